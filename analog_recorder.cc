@@ -21,7 +21,10 @@ analog_recorder::analog_recorder(Source *src)
 	samp_rate = source->get_rate();
 	talkgroup = 0;
 	num = 0;
+	epoch = 0;
 	active = false;
+	activate_time = 0;
+	active_ms = 0;
 
 	timestamp = time(NULL);
 	starttime = time(NULL);
@@ -34,7 +37,7 @@ analog_recorder::analog_recorder(Source *src)
 	float channel_rate = 4800 * samp_per_sym;
 	double pre_channel_rate = samp_rate/decim;
 
-	lpf_taps =  gr::filter::firdes::low_pass(1, samp_rate, xlate_bandwidth/2, 6000);
+	lpf_taps =  cached_low_pass(1, samp_rate, xlate_bandwidth/2, 6000);
 	//lpf_taps =  gr::filter::firdes::low_pass(1, samp_rate, xlate_bandwidth/2, 3000);
 
 	prefilter = gr::filter::freq_xlating_fir_filter_ccf::make(decim,
@@ -63,7 +66,7 @@ analog_recorder::analog_recorder(Source *src)
 
 	demod = gr::analog::quadrature_demod_cf::make(1.527); //1.6 //1.4);
 	levels = gr::blocks::multiply_const_ff::make(1); //33);
-	valve = gr::blocks::copy::make(sizeof(gr_complex));
+	valve = make_preroll_valve(source->get_preroll(), source->get_preroll_catchup());
 	valve->set_enabled(false);
 
 	float tau = 0.000075; //75us
@@ -90,16 +93,18 @@ analog_recorder::analog_recorder(Source *src)
 
 	iam_logging = false;
 
-	tm *ltm = localtime(&starttime);
-
-	std::stringstream path_stream;
-	path_stream << boost::filesystem::current_path().string() <<  "/" << 1900 + ltm->tm_year << "/" << 1 + ltm->tm_mon << "/" << ltm->tm_mday;
-
-	boost::filesystem::create_directories(path_stream.str());
-	sprintf(filename, "%s/%ld-%ld_%g.wav", path_stream.str().c_str(),talkgroup,timestamp,freq);
-	sprintf(status_filename, "%s/%ld-%ld_%g.json", path_stream.str().c_str(),talkgroup,timestamp,freq);
-
-	wav_sink = gr::blocks::wavfile_sink::make(filename,1,8000,16);
+	// no file until the first call, activate() opens it
+	wav_sink = gr::blocks::nonstop_wavfile_sink::make(NULL,1,8000,16);
+	if (silence_gate::enabled()) {
+		// a noise squelch in the gate rather than a squelch ahead of
+		// the demodulator, so where the gaps were is known. What the
+		// discriminator puts out above the 3 kHz of voice is brought
+		// down to the audio rate alongside it, aliasing does not
+		// change its power.
+		noise_taps = gr::filter::firdes::high_pass(1, 48000, 3500, 1000);
+		noise_filter = gr::filter::fir_filter_fff::make(6, noise_taps);
+		gate = make_silence_gate(8000, false, true);
+	}
 
 
 
@@ -111,7 +116,14 @@ analog_recorder::analog_recorder(Source *src)
 	//connect(squelch, 0,	demod, 0);
 	connect(demod, 0, deemph, 0);
 	connect(deemph, 0, decim_audio, 0);
-	connect(decim_audio, 0, wav_sink, 0);
+	if (gate) {
+		connect(demod, 0, noise_filter, 0);
+		connect(decim_audio, 0, gate, 0);
+		connect(noise_filter, 0, gate, 1);
+		connect(gate, 0, wav_sink, 0);
+	} else {
+		connect(decim_audio, 0, wav_sink, 0);
+	}
 
 
 }
@@ -137,6 +149,22 @@ Source *analog_recorder::get_source() {
     return source;
 }
 
+int64_t analog_recorder::get_active_ms() {
+	if (active) {
+		return active_ms + monotonic_ms() - activate_time;
+	}
+	return active_ms;
+}
+
+
+bool analog_recorder::get_silence_gaps(std::vector<silence_gap> &gaps) {
+	gaps.clear();
+	if (!gate) {
+		return false;
+	}
+	gate->get_gaps(epoch, gaps);
+	return true;
+}
 
 void analog_recorder::tune_offset(double f) {
 	freq = f;
@@ -147,28 +175,22 @@ void analog_recorder::tune_offset(double f) {
 void analog_recorder::deactivate() {
 
 	active = false;
+	active_ms += monotonic_ms() - activate_time;
 
 	valve->set_enabled(false);
 
 	wav_sink->close();
+}
 
-	ofstream myfile (status_filename);
-	if (myfile.is_open())
-	{
-		myfile << "{\n";
-		myfile << "\"freq\": " << freq << ",\n";
-		myfile << "\"num\": " << num << ",\n";
-		myfile << "\"talkgroup\": " << talkgroup << ",\n";
-		myfile << "\"mode\": \"analog\" \n";
-		myfile << "}\n";
-		myfile.close();
-	}
-	else cout << "Unable to open file";
+void analog_recorder::abort() {
+	deactivate();
+	wav_sink->discard();
 }
 
 void analog_recorder::activate(Call *call, int n) {
 
 	starttime = time(NULL);
+	activate_time = monotonic_ms();
 
 	talkgroup = call->get_talkgroup();
 	freq = call->get_freq();
@@ -176,8 +198,9 @@ void analog_recorder::activate(Call *call, int n) {
 
 	prefilter->set_center_freq( freq - center); // have to flip for 3.7
 
-	wav_sink->open(call->get_filename());
+	epoch++;
+	wav_sink->open(call->get_filename(), epoch);
 
 	active = true;
-	valve->set_enabled(true);
+	valve->start_from(call->get_grant_time() - source->get_preroll_time(), epoch);
 }
@@ -40,9 +40,12 @@
 #include <gnuradio/blocks/head.h>
 
 #include <gnuradio/blocks/wavfile_sink.h>
+#include "nonstop_wavfile_sink.h"
 #include <gnuradio/blocks/file_sink.h>
 
 #include "smartnet.h"
+#include "filter_cache.h"
+#include "preroll_valve.h"
 #include "recorder.h"
 
 
@@ -66,12 +69,15 @@ public:
 	void activate(Call *call, int n);
 
 	void deactivate();
+	void abort();
 	double get_freq();
     Source *get_source();
 	long get_talkgroup();
 	bool is_active();
-	int lastupdate();
-	long elapsed();
+	int64_t lastupdate();
+	int64_t elapsed();
+	int64_t get_active_ms();
+	bool get_silence_gaps(std::vector<silence_gap> &gaps);
 	void close();
 	static bool logging;
 private:
@@ -81,17 +87,20 @@ private:
 	long samp_rate;
 	time_t timestamp;
 	time_t starttime;
+	int64_t activate_time;
+	int64_t active_ms;  // of the calls before the current one
 	char filename[160];
-	char status_filename[160];
 	char raw_filename[160];
 	char debug_filename[160];
 	int num;
+	long epoch;  // activation number, tags the first sample of each call
 
 	bool iam_logging;
 	bool active;
 	std::vector<float> lpf_taps;
 	std::vector<float> resampler_taps;
 	std::vector<float> audio_resampler_taps;
+	std::vector<float> noise_taps;
 	std::vector<float> sym_taps;
 
     Source *source;
@@ -111,15 +120,17 @@ private:
 
 	gr::filter::rational_resampler_base_ccf::sptr downsample_sig;
 	gr::filter::fir_filter_fff::sptr decim_audio;
+	gr::filter::fir_filter_fff::sptr noise_filter;  // for the silence gate
 	gr::filter::rational_resampler_base_fff::sptr upsample_audio;
 	//gr::analog::pwr_squelch_cc::sptr squelch;
 	gr::analog::quadrature_demod_cf::sptr demod;
-	gr::blocks::wavfile_sink::sptr wav_sink;
+	gr::blocks::nonstop_wavfile_sink::sptr wav_sink;
+	silence_gate_sptr gate;  // NULL unless silence gating is on
 	gr::blocks::file_sink::sptr raw_sink;
 	gr::blocks::file_sink::sptr debug_sink;
 	gr::blocks::null_sink::sptr null_sink;
 	gr::blocks::head::sptr head_source;
-	gr::blocks::copy::sptr valve;
+	preroll_valve_sptr valve;
 
 
 };
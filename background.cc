@@ -0,0 +1,38 @@
+#include "background.h"
+#include <errno.h>
+#include <string.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <boost/log/trivial.hpp>
+
+extern char **environ;
+
+static int running = 0;
+
+bool run_in_background(const std::string &command) {
+	pid_t pid;
+	const char *argv[] = { "sh", "-c", command.c_str(), NULL };
+	int rc = posix_spawn(&pid, "/bin/sh", NULL, NULL, (char * const *) argv, environ);
+
+	if (rc != 0) {
+		BOOST_LOG_TRIVIAL(error) << "Unable to run " << command << ": " << strerror(rc);
+		return false;
+	}
+	running++;
+	return true;
+}
+
+int reap_background() {
+	while (running > 0) {
+		pid_t pid = waitpid(-1, NULL, WNOHANG);
+		if (pid <= 0) {
+			if ((pid < 0) && (errno == ECHILD)) {
+				// nothing left to wait for
+				running = 0;
+			}
+			break;
+		}
+		running--;
+	}
+	return running;
+}
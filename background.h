@@ -0,0 +1,19 @@
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include <string>
+
+/*
+ * Runs a shell command without waiting for it, like
+ * system("command &"), but keeps track of it so the number of
+ * commands still running is known.
+ */
+bool run_in_background(const std::string &command);
+
+/*
+ * Collects the commands that have finished. Returns how many are still
+ * running. Call it regularly from the thread that starts them.
+ */
+int reap_background();
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Throughput of the recorder's own blocks, for comparing builds:
+ *
+ *   bench-trunk-recorder [name ...]
+ *
+ * runs the named benchmarks, all of them without any, and prints how
+ * many items a second each got through. Not run by ctest.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <math.h>
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/vector_source_b.h>
+#include <gnuradio/blocks/vector_source_c.h>
+#include <gnuradio/blocks/null_sink.h>
+#include <gnuradio/blocks/complex_to_arg.h>
+#include <gnuradio/blocks/multiply_const_ff.h>
+#include <gnuradio/digital/diff_phasor_cc.h>
+#include <op25_repeater/fsk4_slicer_fb.h>
+
+#include "smartnet_decode.h"
+#include "smartnet_encode.h"
+#include "dqpsk_slicer.h"
+
+// each benchmark runs at least this long
+static const double MIN_SECONDS = 2.0;
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t lcg(uint32_t &seed)
+{
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+static void report(const char *name, const char *unit, double items, double seconds)
+{
+	printf("%-16s %12.0f %s/s\n", name, items / seconds, unit);
+}
+
+/*
+ * A control channel's worth of OSWs, one in eight with a bit error and
+ * some idle bits in between, as the slicer hands them to the decoder.
+ */
+static void smartnet_corpus(int osws, std::vector<char> &bits)
+{
+	uint32_t seed = 1;
+
+	for (int n = 0; n < osws; n++) {
+		smartnet_append_osw(bits, lcg(seed) & 0xffff, lcg(seed) & 1, lcg(seed) & 0x3ff);
+		if ((lcg(seed) & 7) == 0)
+			bits[bits.size() - smartnet_decode::FRAME_BITS + lcg(seed) % 76] ^= 1;
+		int idle = lcg(seed) % 16;
+		for (int i = 0; i < idle; i++) bits.push_back(lcg(seed) & 1);
+	}
+}
+
+// decode_osw on its own, frames already lined up on the sync word
+static void bench_smartnet_osw()
+{
+	static const int CORPUS = 4096;
+	static char frames[CORPUS][smartnet_decode::FRAME_BITS];
+	uint32_t seed = 1;
+
+	for (int n = 0; n < CORPUS; n++) {
+		smartnet_encode_osw(lcg(seed) & 0xffff, lcg(seed) & 1, lcg(seed) & 0x3ff, frames[n]);
+		if ((lcg(seed) & 7) == 0)
+			frames[n][lcg(seed) % 76] ^= 1;
+	}
+
+	long osws = 0;
+	long decoded = 0;
+	double start = now();
+	double elapsed;
+	do {
+		for (int n = 0; n < CORPUS; n++) {
+			smartnet_packet pkt;
+			unsigned int errors;
+			decoded += smartnet_decode::decode_osw(frames[n], pkt, errors);
+		}
+		osws += CORPUS;
+		elapsed = now() - start;
+	} while (elapsed < MIN_SECONDS);
+	report("decode_osw", "OSWs", osws, elapsed);
+	printf("%-16s %12ld of %ld decoded\n", "", decoded, osws);
+}
+
+// the block in a flow graph, sync search and queueing included
+static void bench_smartnet_block()
+{
+	static const int CORPUS = 100000;
+	std::vector<char> bits;
+	smartnet_corpus(CORPUS, bits);
+	bits.insert(bits.end(), smartnet_decode::FRAME_BITS, 0);
+	std::vector<unsigned char> input(bits.begin(), bits.end());
+
+	long osws = 0;
+	long decoded = 0;
+	double start = now();
+	double elapsed;
+	do {
+		gr::op25_repeater::trunk_msg_queue::sptr queue = gr::op25_repeater::trunk_msg_queue::make(CORPUS);
+		gr::top_block_sptr tb = gr::make_top_block("bench_smartnet");
+		gr::blocks::vector_source_b::sptr src = gr::blocks::vector_source_b::make(input);
+		smartnet_decode_sptr decode = smartnet_make_decode(queue);
+		tb->connect(src, 0, decode, 0);
+		tb->run();
+		osws += CORPUS;
+		decoded += queue->count();
+		elapsed = now() - start;
+	} while (elapsed < MIN_SECONDS);
+	report("smartnet_decode", "OSWs", osws, elapsed);
+	report("", "Mbit", osws * (double) bits.size() / CORPUS / 1e6, elapsed);
+	printf("%-16s %12ld of %ld decoded\n", "", decoded, osws);
+}
+
+/*
+ * The symbols of many recorders at once through the scheduler, with the
+ * QPSK symbol chain as four blocks, as it was, or as one dqpsk_slicer.
+ * Every recorder gets the same stream, so only the blocks and the
+ * threads running them differ.
+ */
+static void bench_qpsk_chains(bool fused, int recorders)
+{
+	static const int SYMBOLS = 200000;  // per recorder and run
+	const float l[] = { -2.0, 0.0, 2.0, 4.0 };
+	std::vector<float> levels(l, l + 4);
+	std::vector<gr_complex> symbols(SYMBOLS);
+	uint32_t seed = 1;
+	float phase = 0;
+
+	for (size_t i = 0; i < symbols.size(); i++) {
+		phase += (2 * (int) (lcg(seed) & 3) - 3) * M_PI / 4;
+		symbols[i] = std::polar(1.0f, phase);
+	}
+
+	long items = 0;
+	int blocks = 0;
+	double start = now();
+	double elapsed;
+	do {
+		gr::top_block_sptr tb = gr::make_top_block("bench_qpsk");
+		gr::blocks::vector_source_c::sptr src = gr::blocks::vector_source_c::make(symbols);
+		blocks = 1;
+		for (int r = 0; r < recorders; r++) {
+			gr::blocks::null_sink::sptr sink = gr::blocks::null_sink::make(sizeof(unsigned char));
+			if (fused) {
+				dqpsk_slicer_sptr dqpsk = make_dqpsk_slicer(levels);
+				tb->connect(src, 0, dqpsk, 0);
+				tb->connect(dqpsk, 0, sink, 0);
+				blocks += 2;
+			} else {
+				gr::digital::diff_phasor_cc::sptr diffdec = gr::digital::diff_phasor_cc::make();
+				gr::blocks::complex_to_arg::sptr to_float = gr::blocks::complex_to_arg::make();
+				gr::blocks::multiply_const_ff::sptr rescale = gr::blocks::multiply_const_ff::make(4.0 / M_PI);
+				gr::op25_repeater::fsk4_slicer_fb::sptr slicer = gr::op25_repeater::fsk4_slicer_fb::make(levels);
+				tb->connect(src, 0, diffdec, 0);
+				tb->connect(diffdec, 0, to_float, 0);
+				tb->connect(to_float, 0, rescale, 0);
+				tb->connect(rescale, 0, slicer, 0);
+				tb->connect(slicer, 0, sink, 0);
+				blocks += 5;
+			}
+		}
+		tb->run();
+		items += (long) SYMBOLS * recorders;
+		elapsed = now() - start;
+	} while (elapsed < MIN_SECONDS);
+
+	char name[32];
+	snprintf(name, sizeof(name), "%s %d", fused ? "dqpsk_slicer" : "4 block chain", recorders);
+	report(name, "symbols", items, elapsed);
+	printf("%-16s %12d blocks, a thread each\n", "", blocks);
+}
+
+// at the recorder counts of a small, a typical and a large site
+static void bench_qpsk_chain()
+{
+	bench_qpsk_chains(false, 10);
+	bench_qpsk_chains(false, 30);
+	bench_qpsk_chains(false, 60);
+	bench_qpsk_chains(true, 10);
+	bench_qpsk_chains(true, 30);
+	bench_qpsk_chains(true, 60);
+}
+
+struct benchmark {
+	const char *name;
+	void (*run)();
+};
+
+static const benchmark benchmarks[] = {
+	{ "smartnet_osw", bench_smartnet_osw },
+	{ "smartnet_block", bench_smartnet_block },
+	{ "qpsk_chain", bench_qpsk_chain },
+};
+
+int main(int argc, char **argv)
+{
+	int n = sizeof(benchmarks) / sizeof(benchmarks[0]);
+	for (int i = 0; i < n; i++) {
+		bool wanted = (argc < 2);
+		for (int j = 1; j < argc; j++)
+			wanted |= (strcmp(argv[j], benchmarks[i].name) == 0);
+		if (wanted)
+			benchmarks[i].run();
+	}
+	return 0;
+}
@@ -1,4 +1,58 @@
 #include "call.h"
+#include "background.h"
+#include "metrics.h"
+#include <map>
+#include <set>
+#include <unistd.h>
+
+bool Call::dry_run = false;
+#ifdef HAVE_SQLITE3
+CallIndex *Call::index = NULL;
+#endif
+bool Call::write_json = true;
+
+// the directory create_filename() made last, most calls go to the same one
+static std::string last_directory;
+
+// names given out within the current second; a call shorter than a
+// second must not get the file of the one before it
+static time_t names_second = 0;
+static std::set<std::string> names_used;
+
+// post call scripts waiting for the recorder to finish their file
+struct post_call_job {
+	std::string command;
+	int64_t queued;         // monotonic_ms()
+};
+static std::map<std::string, post_call_job> post_call_jobs;
+
+// run the script anyway if the file has not been finished by then
+static const int64_t POST_CALL_WAIT_MS = 10000;
+
+void Call::start_post_call_jobs() {
+	std::vector<std::string> closed;
+	gr::blocks::nonstop_wavfile_sink::finish_drained(closed);
+	for (std::vector<std::string>::iterator it = closed.begin(); it != closed.end(); it++) {
+		std::map<std::string, post_call_job>::iterator job = post_call_jobs.find(*it);
+		if (job != post_call_jobs.end()) {
+			run_in_background(job->second.command);
+			Metrics::add(Metrics::POST_CALL_JOBS);
+			post_call_jobs.erase(job);
+		}
+	}
+
+	int64_t now = monotonic_ms();
+	for (std::map<std::string, post_call_job>::iterator it = post_call_jobs.begin(); it != post_call_jobs.end();) {
+		if (now - it->second.queued >= POST_CALL_WAIT_MS) {
+			BOOST_LOG_TRIVIAL(error) << "\t" << it->first << " was not finished after " << POST_CALL_WAIT_MS << "ms, running the post call script anyway";
+			run_in_background(it->second.command);
+			Metrics::add(Metrics::POST_CALL_JOBS);
+			post_call_jobs.erase(it++);
+		} else {
+			it++;
+		}
+	}
+}
 
 void Call::create_filename() {
     tm *ltm = localtime(&start_time);
@@ -7,20 +61,46 @@ void Call::create_filename() {
 	std::stringstream path_stream;
 	path_stream << boost::filesystem::current_path().string() <<  "/" << 1900 + ltm->tm_year << "/" << 1 + ltm->tm_mon << "/" << ltm->tm_mday;
 
-	boost::filesystem::create_directories(path_stream.str());
-	sprintf(filename, "%s/%ld-%ld_%g.wav", path_stream.str().c_str(),talkgroup,start_time,freq);
-    sprintf(status_filename, "%s/%ld-%ld_%g.json", path_stream.str().c_str(),talkgroup,start_time,freq);
+	// archived recordings only need the directory for the .json file
+	bool archived = gr::blocks::nonstop_wavfile_sink::get_archive() != NULL;
+	if (!dry_run && (!archived || write_json) && (path_stream.str() != last_directory)) {
+		boost::filesystem::create_directories(path_stream.str());
+		last_directory = path_stream.str();
+	}
+	if (start_time != names_second) {
+		names_used.clear();
+		names_second = start_time;
+	}
+	char base[160];
+	snprintf(base, sizeof(base), "%s/%ld-%ld_%g", path_stream.str().c_str(),talkgroup,start_time,freq);
+	std::string name = base;
+	// later calls in the same second get -1, -2, ... on the end
+	for (int n = 1; !names_used.insert(name).second; n++) {
+		std::ostringstream numbered;
+		numbered << base << "-" << n;
+		name = numbered.str();
+	}
+	snprintf(filename, sizeof(filename), "%s.wav", name.c_str());
+	snprintf(status_filename, sizeof(status_filename), "%s.json", name.c_str());
 }
 Call::Call(long t, double f) {
 	talkgroup = t;
 	freq = f;
 	start_time = time(NULL);
-	last_update = time(NULL);
+	grant_time = call_time_ms();
+	last_update = grant_time;
+	activate_time = 0;
+	first_voice_time = 0;
+	last_voice_time = 0;
+	stop_time = 0;
 	recording = false;
 	debug_recording = false;
+	parked = false;
 	tdma = false;
 	encrypted = false;
 	emergency = false;
+	priority = 0;
+	has_decode_quality = false;
     src_count = 0;
     this->create_filename();
 }
@@ -29,35 +109,159 @@ Call::Call(TrunkMessage message) {
 	talkgroup = message.talkgroup;
 	freq = message.freq;
 	start_time = time(NULL);
-	last_update = time(NULL);
+	// the grant was decoded a little before it got here
+	grant_time = message.rx_time ? message.rx_time : call_time_ms();
+	last_update = grant_time;
+	activate_time = 0;
+	first_voice_time = 0;
+	last_voice_time = 0;
+	stop_time = 0;
 	recording = false;
 	debug_recording = false;
+	parked = false;
 	tdma = message.tdma;
 	encrypted = message.encrypted;
 	emergency = message.emergency;
+	priority = 0;
+	has_decode_quality = false;
 	src_count = 0;
     this->create_filename();
     this->add_source(message.source);
 }
 
+#ifdef HAVE_SQLITE3
+void Call::add_to_index() {
+    CallIndexRecord record;
+    record.talkgroup = talkgroup;
+    record.freq = freq;
+    record.tdma = tdma;
+    record.emergency = emergency;
+    record.encrypted = encrypted;
+    record.priority = priority;
+    record.grant_time = monotonic_to_epoch_ms(grant_time);
+    record.recorder_time = activate_time ? monotonic_to_epoch_ms(activate_time) : 0;
+    record.first_voice_time = first_voice_time ? monotonic_to_epoch_ms(first_voice_time) : 0;
+    record.last_voice_time = last_voice_time ? monotonic_to_epoch_ms(last_voice_time) : 0;
+    record.stop_time = monotonic_to_epoch_ms(stop_time);
+    record.filename = filename;
+    record.has_quality = has_decode_quality;
+    record.voice_error_rate = decode_quality.voice_error_rate();
+    record.has_mer = decode_quality.slicer_symbols != 0;
+    record.mer = decode_quality.mer();
+    record.sync_losses = decode_quality.stats.sync_losses;
+    record.frames = decode_quality.stats.frames;
+    record.silence_removed_ms = silence_removed_ms();
+    record.units.assign(src_list, src_list + src_count);
+    index->add(record);
+}
+#endif
+
+// recordings are all 8 kHz
+static int64_t samples_to_ms(uint64_t samples) {
+    return samples / 8;
+}
+
+int64_t Call::silence_removed_ms() {
+    uint64_t removed = 0;
+    for (size_t i = 0; i < silence_gaps.size(); i++) {
+        removed += silence_gaps[i].removed;
+    }
+    return samples_to_ms(removed);
+}
+
 Call::~Call() {
   //  BOOST_LOG_TRIVIAL(info) << " This call is over!!";
 }
 
+static void write_json_time(std::ofstream &out, const char *name, int64_t t) {
+    out << "\"" << name << "\": ";
+    if (t) {
+        out << monotonic_to_epoch_ms(t);
+    } else {
+        out << "null";
+    }
+    out << ",\n";
+}
+
 void Call::end_call() {
     char shell_command[200];
-    
-            if (this->get_recording() == true) {
+
+    if (parked) {
+        return;
+    }
+    stop_time = call_time_ms();
+            if ((this->get_recording() == true) && (this->get_recorder()->waiting_for_voice() >= 0)) {
+                // a grant for a transmission that had already ended, or
+                // one the recorder never heard; there is nothing to keep
+                BOOST_LOG_TRIVIAL(info) << "\tNo voice - TG: " << talkgroup << "\tFreq: " << freq << "\tElapsed: " << elapsed() << "ms";
+                this->get_recorder()->abort();
+                Metrics::add(Metrics::CALLS_NO_VOICE);
+            } else if (this->get_recording() == true) {
+                Recorder *recorder = this->get_recorder();
+                first_voice_time = recorder->get_first_voice_time();
+                last_voice_time = recorder->get_last_voice_time();
+                has_decode_quality = recorder->get_decode_quality(decode_quality);
+                if (has_decode_quality) {
+                    const gr::op25_repeater::decode_stats &stats = decode_quality.stats;
+                    BOOST_LOG_TRIVIAL(info) << "\tDecode TG: " << talkgroup << "\tFrames: " << stats.frames << "\tVoice Frames: " << stats.voice_frames << "\tSync Losses: " << stats.sync_losses << "\tVoice Errors/Codeword: " << decode_quality.voice_error_rate() << "\tMER: " << decode_quality.mer() << "dB";
+                }
+                bool gated = recorder->get_silence_gaps(silence_gaps);
 
                 //BOOST_LOG_TRIVIAL(info) << "\tRemoving TG: " << call->get_talkgroup() << "\tElapsed: " << call->elapsed() << std::endl;
 
-                std::ofstream myfile (status_filename);
+                std::ofstream myfile;
+                if (!dry_run && write_json) {
+                    myfile.open(status_filename);
+                }
                 if (myfile.is_open())
                 {
                     myfile << "{\n";
                     myfile << "\"freq\": " << this->freq << ",\n";
                     myfile << "\"emergency\": " << this->emergency << ",\n";
                     myfile << "\"talkgroup\": " << this->talkgroup << ",\n";
+                    // milliseconds since the epoch
+                    write_json_time(myfile, "grantTime", grant_time);
+                    write_json_time(myfile, "recorderTime", activate_time);
+                    write_json_time(myfile, "firstVoiceTime", first_voice_time);
+                    write_json_time(myfile, "lastVoiceTime", last_voice_time);
+                    write_json_time(myfile, "stopTime", stop_time);
+                    if (has_decode_quality) {
+                        const gr::op25_repeater::decode_stats &stats = decode_quality.stats;
+                        myfile << "\"decode\": {\n";
+                        myfile << "\t\"symbols\": " << stats.symbols << ",\n";
+                        myfile << "\t\"frameSyncs\": " << stats.frame_syncs << ",\n";
+                        myfile << "\t\"syncLosses\": " << stats.sync_losses << ",\n";
+                        myfile << "\t\"frames\": " << stats.frames << ",\n";
+                        myfile << "\t\"nidErrors\": " << stats.nid_errors << ",\n";
+                        myfile << "\t\"bchErrors\": " << stats.bch_errors << ",\n";
+                        myfile << "\t\"voiceFrames\": " << stats.voice_frames << ",\n";
+                        myfile << "\t\"voiceCodewords\": " << stats.voice_codewords << ",\n";
+                        myfile << "\t\"voiceE0Errors\": " << stats.voice_e0_errors << ",\n";
+                        myfile << "\t\"voiceErrors\": " << stats.voice_et_errors << ",\n";
+                        myfile << "\t\"voiceErrorRate\": " << decode_quality.voice_error_rate() << ",\n";
+                        myfile << "\t\"tsbkBlocks\": " << stats.tsbk_blocks << ",\n";
+                        myfile << "\t\"tsbkErrors\": " << stats.tsbk_errors << ",\n";
+                        myfile << "\t\"mer\": ";
+                        if (decode_quality.slicer_symbols) {
+                            myfile << decode_quality.mer() << "\n";
+                        } else {
+                            myfile << "null\n";
+                        }
+                        myfile << "},\n";
+                    }
+                    if (gated) {
+                        // [where in the file, how long] in ms, for putting
+                        // the time back on playback
+                        myfile << "\"silenceGaps\": [ ";
+                        for (size_t i = 0; i < silence_gaps.size(); i++) {
+                            if (i != 0) {
+                                myfile << ", ";
+                            }
+                            myfile << "[" << samples_to_ms(silence_gaps[i].offset) << ", " << samples_to_ms(silence_gaps[i].removed) << "]";
+                        }
+                        myfile << " ],\n";
+                        myfile << "\"silenceRemoved\": " << silence_removed_ms() << ",\n";
+                    }
                     myfile << "\"srcList\": [ ";
                     for (int i=0; i < this->src_count; i++ ){
                         if (i != 0) {
@@ -70,9 +274,22 @@ void Call::end_call() {
                     myfile << "}\n";
                     myfile.close();
                 }
-                sprintf(shell_command,"./encode-upload.sh %s > /dev/null 2>&1 &", this->get_filename());
+#ifdef HAVE_SQLITE3
+                if (index && !dry_run) {
+                    add_to_index();
+                }
+#endif
+                sprintf(shell_command,"./encode-upload.sh %s > /dev/null 2>&1", this->get_filename());
                 this->get_recorder()->deactivate();
-                system(shell_command);
+                // there is no .wav file for the script when archiving; the
+                // script starts once the recorder has finished the file,
+                // see start_post_call_jobs()
+                if (!dry_run && !gr::blocks::nonstop_wavfile_sink::get_archive()) {
+                    post_call_job job;
+                    job.command = shell_command;
+                    job.queued = monotonic_ms();
+                    post_call_jobs[filename] = job;
+                }
             }
             if (this->get_debug_recording() == true) {
                 this->get_debug_recorder()->deactivate();
@@ -83,6 +300,22 @@ void Call::end_call() {
 }
 
 
+void Call::park() {
+	end_call();
+	recording = false;
+	debug_recording = false;
+	parked = true;
+}
+
+bool Call::get_parked() {
+	return parked;
+}
+
+bool Call::get_decode_quality(DecodeQuality &quality) {
+	quality = decode_quality;
+	return has_decode_quality;
+}
+
 void  Call::set_debug_recorder(Recorder *r) {
 	debug_recorder = r;
 }
@@ -93,6 +326,7 @@ Recorder *  Call::get_debug_recorder() {
 
 void  Call::set_recorder(Recorder *r) {
 	recorder = r;
+	activate_time = call_time_ms();
 }
 Recorder *  Call::get_recorder() {
 	return recorder;
@@ -148,6 +382,12 @@ void  Call::set_encrypted(bool m) {
 bool  Call::get_encrypted() {
 	return encrypted;
 }
+void  Call::set_priority(int p) {
+	priority = p;
+}
+int  Call::get_priority() {
+	return priority;
+}
 void  Call::set_emergency(bool m) {
 	emergency = m;
 }
@@ -163,13 +403,17 @@ int  Call::get_tdma() {
 void  Call::update(TrunkMessage message) {
     
     this->add_source(message.source);
-	last_update = time(NULL);
+	last_update = call_time_ms();
 }
-int  Call::since_last_update() {
-	return time(NULL) - last_update;
+int64_t  Call::since_last_update() {
+	return call_time_ms() - last_update;
 }
-long  Call::elapsed() {
-	return time(NULL) - start_time;
+int64_t  Call::get_grant_time() {
+	return grant_time;
+}
+
+int64_t  Call::elapsed() {
+	return call_time_ms() - grant_time;
 }
 
 char *Call::get_filename() {
@@ -2,6 +2,12 @@
 #define CALL_H
 #include <sys/time.h>
 #include <boost/log/trivial.hpp>
+#include "timestamp.h"
+#include "decode_quality.h"
+#ifdef HAVE_SQLITE3
+#include "call_index.h"
+#endif
+#include "silence_gate.h"
 
 class Recorder;
 #include "parser.h"
@@ -10,12 +16,22 @@ class Recorder;
 class Call {
 	long talkgroup;
 	double freq;
-	time_t last_update;
 	time_t start_time;
+	// call_time_ms() timestamps, 0 if the event has not happened
+	int64_t grant_time;
+	int64_t last_update;
+	int64_t activate_time;
+	int64_t first_voice_time;
+	int64_t last_voice_time;
+	int64_t stop_time;
 	bool recording;
 	bool debug_recording;
+	// ended, on a terminator, without voice or by preemption, and kept
+	// until callTimeout; end_call() does nothing any more
+	bool parked;
 	bool encrypted;
 	bool emergency;
+	int priority;
     char filename[160];
     char status_filename[160];
 	int tdma;
@@ -23,11 +39,35 @@ class Call {
     long src_list[50];
 	Recorder *recorder;
 	Recorder *debug_recorder;
+	bool has_decode_quality;
+	DecodeQuality decode_quality;
+	// silence the recorder's gate took out of the file
+	std::vector<silence_gap> silence_gaps;
+	int64_t silence_removed_ms();
+#ifdef HAVE_SQLITE3
+	void add_to_index();
+#endif
 public:
+	// calls are followed but nothing is written and no scripts are
+	// run, for replaying a journal
+	static bool dry_run;
+#ifdef HAVE_SQLITE3
+	// where ended calls are indexed, NULL for none
+	static CallIndex *index;
+#endif
+	// write the .json file next to each recording
+	static bool write_json;
+
 	Call( long t, double f);
 	Call( TrunkMessage message );
     ~Call();
     void end_call();
+	// start the post call scripts of the ended calls whose files the
+	// recorders have finished writing; call it regularly
+	static void start_post_call_jobs();
+	// end_call() and keep the call as parked
+	void park();
+	bool get_parked();
 	void set_debug_recorder(Recorder *r);
 	Recorder * get_debug_recorder();
 	void set_recorder(Recorder *r);
@@ -41,8 +81,9 @@ public:
     long *get_source_list();
     bool add_source(long src);
 	void update(TrunkMessage message);
-	int since_last_update();
-	long elapsed();
+	int64_t since_last_update();
+	int64_t elapsed();
+	int64_t get_grant_time();
 	void set_debug_recording(bool m);
 	bool get_debug_recording();
 	void set_recording(bool m);
@@ -53,5 +94,9 @@ public:
 	bool get_encrypted();
 	void set_emergency(bool m);
 	bool get_emergency();
+	void set_priority(int p);
+	int get_priority();
+	// the recorder's error counts, taken when the call ended
+	bool get_decode_quality(DecodeQuality &quality);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "call_archive.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <boost/filesystem/operations.hpp>
+#include <boost/log/trivial.hpp>
+
+CallArchive::CallArchive(const std::string &d) {
+	dir = d;
+	segment_fd = -1;
+	index_fd = -1;
+	tail = 0;
+	allocated = 0;
+	boost::filesystem::create_directories(dir);
+}
+
+CallArchive::~CallArchive() {
+	close_files();
+}
+
+void CallArchive::close_files() {
+	if (segment_fd >= 0) {
+		::close(segment_fd);
+		segment_fd = -1;
+	}
+	if (index_fd >= 0) {
+		::close(index_fd);
+		index_fd = -1;
+	}
+}
+
+// opens the segment and index for today, if they are not the ones open
+bool CallArchive::rotate() {
+	char name[16];
+	time_t now = time(NULL);
+	strftime(name, sizeof(name), "%Y-%m-%d", localtime(&now));
+	if ((segment_fd >= 0) && (day == name)) {
+		return true;
+	}
+
+	close_files();
+	day = name;
+	std::string segment = dir + "/" + day + ".seg";
+	std::string index = dir + "/" + day + ".idx";
+	segment_fd = ::open(segment.c_str(), O_RDWR | O_CREAT, 0664);
+	index_fd = ::open(index.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0664);
+	if ((segment_fd < 0) || (index_fd < 0)) {
+		BOOST_LOG_TRIVIAL(error) << "Call archive: unable to open " << segment << ": " << strerror(errno);
+		close_files();
+		return false;
+	}
+
+	// preallocated space is not counted in the size, so the size is
+	// where the last call written ends; anything cut short by a crash
+	// after that has no index line and is skipped
+	struct stat st;
+	fstat(segment_fd, &st);
+	tail = st.st_size;
+	allocated = tail;
+	BOOST_LOG_TRIVIAL(info) << "Call archive: " << segment;
+	return true;
+}
+
+bool CallArchive::append(const std::string &name, const char *data, size_t size) {
+	gr::thread::scoped_lock guard(mutex);
+	if (!rotate()) {
+		return false;
+	}
+
+	if (tail + size > allocated) {
+		uint64_t chunk = std::max((uint64_t) SEGMENT_CHUNK, (uint64_t) size);
+#ifdef FALLOC_FL_KEEP_SIZE
+		// best effort, without it pwrite() allocates as it goes
+		fallocate(segment_fd, FALLOC_FL_KEEP_SIZE, tail, chunk);
+#endif
+		allocated = tail + chunk;
+	}
+
+	uint64_t offset = tail;
+	size_t written = 0;
+	while (written < size) {
+		ssize_t n = pwrite(segment_fd, data + written, size - written, offset + written);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			BOOST_LOG_TRIVIAL(error) << "Call archive: unable to write " << name << ": " << strerror(errno);
+			return false;
+		}
+		written += n;
+	}
+	tail += size;
+
+	// the index line goes after the data, so it only ever points at a
+	// complete call
+	std::ostringstream line;
+	line << offset << " " << size << " " << boost::filesystem::path(name).filename().string() << "\n";
+	std::string text = line.str();
+	if (write(index_fd, text.data(), text.size()) != (ssize_t) text.size()) {
+		BOOST_LOG_TRIVIAL(error) << "Call archive: unable to index " << name << ": " << strerror(errno);
+		return false;
+	}
+	return true;
+}
+
+bool CallArchive::extract(const std::string &dir, const std::string &name, const std::string &output) {
+	std::string wanted = boost::filesystem::path(name).filename().string();
+	std::vector<std::string> indexes;
+
+	boost::filesystem::directory_iterator end;
+	for (boost::filesystem::directory_iterator it(dir); it != end; it++) {
+		if (it->path().extension() == ".idx") {
+			indexes.push_back(it->path().string());
+		}
+	}
+	// newest first, a call is usually looked for soon after
+	std::sort(indexes.rbegin(), indexes.rend());
+
+	for (size_t i = 0; i < indexes.size(); i++) {
+		std::ifstream index(indexes[i].c_str());
+		uint64_t offset;
+		size_t size;
+		std::string file;
+		while (index >> offset >> size >> file) {
+			if (file != wanted) {
+				continue;
+			}
+
+			std::string segment = indexes[i].substr(0, indexes[i].size() - 4) + ".seg";
+			std::vector<char> data(size);
+			int fd = ::open(segment.c_str(), O_RDONLY);
+			if ((fd < 0) || (pread(fd, &data[0], size, offset) != (ssize_t) size)) {
+				BOOST_LOG_TRIVIAL(error) << "Call archive: unable to read " << segment << ": " << strerror(errno);
+				if (fd >= 0) {
+					::close(fd);
+				}
+				return false;
+			}
+			::close(fd);
+
+			FILE *out = (output == "-") ? stdout : fopen(output.c_str(), "wb");
+			if (!out || (fwrite(&data[0], 1, size, out) != size)) {
+				BOOST_LOG_TRIVIAL(error) << "Call archive: unable to write " << output << ": " << strerror(errno);
+				return false;
+			}
+			if (out != stdout) {
+				fclose(out);
+			}
+			return true;
+		}
+	}
+	BOOST_LOG_TRIVIAL(error) << "Call archive: " << wanted << " is not in " << dir;
+	return false;
+}
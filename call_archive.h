@@ -0,0 +1,48 @@
+#ifndef CALL_ARCHIVE_H
+#define CALL_ARCHIVE_H
+
+#include <stdint.h>
+#include <string>
+#include <gnuradio/thread/thread.h>
+
+/*
+ * Keeps call recordings in a few large files instead of a .wav each.
+ *
+ * Every call's audio, a complete WAV file, is appended to the day's
+ * segment, dir/YYYY-MM-DD.seg, and a line with its offset, length and
+ * file name is added to dir/YYYY-MM-DD.idx. Segments are preallocated
+ * SEGMENT_CHUNK at a time with fallocate(), so a call is one pwrite()
+ * into space the filesystem already set aside, and the only files
+ * created are two a day.
+ */
+class CallArchive {
+	std::string dir;
+	std::string day;         // of the open segment
+	int segment_fd;
+	int index_fd;
+	uint64_t tail;           // end of the data in the segment
+	uint64_t allocated;      // bytes preallocated
+	gr::thread::mutex mutex;
+
+	bool rotate();
+	void close_files();
+public:
+	static const uint64_t SEGMENT_CHUNK = 256 << 20;
+
+	CallArchive(const std::string &d);
+	~CallArchive();
+
+	/*
+	 * Adds a call's WAV file, held in memory, under name (the .wav
+	 * file name it would have had). Thread-safe.
+	 */
+	bool append(const std::string &name, const char *data, size_t size);
+
+	/*
+	 * Writes the call archived under name, the file name or just its
+	 * last part, to output as a standalone WAV file.
+	 */
+	static bool extract(const std::string &dir, const std::string &name, const std::string &output);
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "call_history.h"
+#include "journal.h"
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/log/trivial.hpp>
+
+CallHistory::CallHistory(int64_t timeout) {
+	call_timeout = timeout;
+}
+
+// the same as assign_recorder(): a grant continues the talkgroup's
+// call, or starts one and ends whatever else was on the channel
+void CallHistory::grant(int64_t t, double freq, long talkgroup, int tdma, bool encrypted, bool emergency) {
+	std::pair<double, int> channel(freq, tdma);
+	std::map<std::pair<double, int>, size_t>::iterator ch = open_channels.find(channel);
+	if ((ch != open_channels.end()) && (calls[ch->second].talkgroup != talkgroup)) {
+		HistoricalCall &other = calls[ch->second];
+		// one quiet for longer than the timeout had ended by itself
+		if (t - other.last <= call_timeout) {
+			other.cut = t;
+		}
+		std::map<long, size_t>::iterator it = open_calls.find(other.talkgroup);
+		if ((it != open_calls.end()) && (it->second == ch->second)) {
+			open_calls.erase(it);
+		}
+		open_channels.erase(ch);
+	}
+
+	std::map<long, size_t>::iterator it = open_calls.find(talkgroup);
+	if ((it != open_calls.end()) && (t >= calls[it->second].last) && (t - calls[it->second].last <= call_timeout)) {
+		HistoricalCall &call = calls[it->second];
+		call.last = t;
+		call.emergency = call.emergency || emergency;
+		if ((call.freq != freq) || (call.tdma != tdma)) {
+			// recorders are retuned on the same source, the call keeps
+			// the channel it was allocated for
+			std::map<std::pair<double, int>, size_t>::iterator old = open_channels.find(std::make_pair(call.freq, call.tdma));
+			if ((old != open_channels.end()) && (old->second == it->second)) {
+				open_channels.erase(old);
+			}
+			open_channels[channel] = it->second;
+		}
+		return;
+	}
+
+	HistoricalCall call;
+	call.start = t;
+	call.last = t;
+	call.cut = 0;
+	call.freq = freq;
+	call.talkgroup = talkgroup;
+	call.tdma = tdma;
+	call.encrypted = encrypted;
+	call.emergency = emergency;
+	open_calls[talkgroup] = calls.size();
+	open_channels[channel] = calls.size();
+	calls.push_back(call);
+}
+
+void CallHistory::update(int64_t t, long talkgroup) {
+	std::map<long, size_t>::iterator it = open_calls.find(talkgroup);
+	if ((it != open_calls.end()) && (t >= calls[it->second].last) && (t - calls[it->second].last <= call_timeout)) {
+		calls[it->second].last = t;
+	}
+}
+
+bool CallHistory::load_journal(const std::string &filename) {
+	JournalReader reader;
+	trunk_msg msg;
+	std::vector<TrunkMessage> messages;
+
+	if (!reader.open(filename)) {
+		return false;
+	}
+	// the records are on the clock of the run that wrote them
+	int64_t to_epoch = reader.get_epoch_ms() - reader.get_monotonic_ms();
+	while (reader.next(msg, messages)) {
+		int64_t t = msg.rx_time + to_epoch;
+		for (size_t i = 0; i < messages.size(); i++) {
+			const TrunkMessage &message = messages[i];
+			if (message.message_type == GRANT) {
+				grant(t, message.freq, message.talkgroup, message.tdma, message.encrypted, message.emergency);
+			} else if (message.message_type == UPDATE) {
+				update(t, message.talkgroup);
+			}
+		}
+	}
+	return true;
+}
+
+bool CallHistory::load_call_json(const std::string &filename) {
+	boost::property_tree::ptree pt;
+	try {
+		boost::property_tree::read_json(filename, pt);
+	} catch (boost::property_tree::json_parser_error &e) {
+		BOOST_LOG_TRIVIAL(error) << "Call history: unable to read " << filename << ": " << e.what();
+		return false;
+	}
+	// null times read as the default
+	int64_t grant_time = pt.get<int64_t>("grantTime", 0);
+	if (!grant_time || !pt.count("talkgroup")) {
+		// not a call, or from before the times were written
+		return false;
+	}
+
+	HistoricalCall call;
+	call.start = grant_time;
+	call.last = pt.get<int64_t>("lastVoiceTime", 0);
+	if (!call.last) {
+		call.last = pt.get<int64_t>("stopTime", grant_time);
+	}
+	call.cut = 0;
+	call.freq = pt.get<double>("freq", 0);
+	call.talkgroup = pt.get<long>("talkgroup");
+	call.tdma = 0;
+	call.encrypted = false;
+	call.emergency = pt.get<int>("emergency", 0) != 0;
+	calls.push_back(call);
+	return true;
+}
+
+struct StartedBefore {
+	bool operator()(const HistoricalCall &a, const HistoricalCall &b) const {
+		return a.start < b.start;
+	}
+};
+
+void CallHistory::load(const std::vector<std::string> &paths) {
+	std::vector<std::string> files;
+	for (std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); it++) {
+		if (!boost::filesystem::is_directory(*it)) {
+			files.push_back(*it);
+			continue;
+		}
+		boost::filesystem::recursive_directory_iterator end;
+		for (boost::filesystem::recursive_directory_iterator dir(*it); dir != end; dir++) {
+			std::string ext = dir->path().extension().string();
+			if (boost::filesystem::is_regular_file(dir->status()) && ((ext == ".journal") || (ext == ".json"))) {
+				files.push_back(dir->path().string());
+			}
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	size_t journals = 0;
+	size_t call_files = 0;
+	for (std::vector<std::string>::iterator it = files.begin(); it != files.end(); it++) {
+		if (boost::filesystem::path(*it).extension() == ".json") {
+			call_files += load_call_json(*it);
+		} else {
+			journals += load_journal(*it);
+		}
+	}
+	open_calls.clear();
+	open_channels.clear();
+
+	std::stable_sort(calls.begin(), calls.end(), StartedBefore());
+	BOOST_LOG_TRIVIAL(info) << "Call history: " << calls.size() << " calls from " << journals << " journals and " << call_files << " call files";
+}
+
+int64_t CallHistory::get_span() const {
+	if (calls.empty()) {
+		return 0;
+	}
+	int64_t last = 0;
+	for (size_t i = 0; i < calls.size(); i++) {
+		last = std::max(last, calls[i].last);
+	}
+	return last - calls.front().start;
+}
@@ -0,0 +1,63 @@
+#ifndef CALL_HISTORY_H
+#define CALL_HISTORY_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * A call as it happened, as far as recorder allocation cares. Times
+ * are milliseconds since the epoch.
+ */
+struct HistoricalCall {
+	int64_t start;      // the grant
+	int64_t last;       // the last grant or update for it, or its last voice
+	int64_t cut;        // its channel was granted to another talkgroup, 0 if not
+	double freq;
+	long talkgroup;
+	int tdma;
+	bool encrypted;
+	bool emergency;
+
+	// when a recorder following it would have been freed
+	int64_t end(int64_t hang_time) const {
+		int64_t t = last + hang_time;
+		return (cut && (cut < t)) ? cut : t;
+	}
+};
+
+/*
+ * The calls in message journals or in the .json files written next to
+ * the recordings, ordered by when they started. Journals have every
+ * call; the .json files only the ones that were recorded.
+ */
+class CallHistory {
+	std::vector<HistoricalCall> calls;
+	int64_t call_timeout;
+	// calls that can still get updates, by talkgroup and by channel
+	std::map<long, size_t> open_calls;
+	std::map<std::pair<double, int>, size_t> open_channels;
+
+	void grant(int64_t t, double freq, long talkgroup, int tdma, bool encrypted, bool emergency);
+	void update(int64_t t, long talkgroup);
+	bool load_journal(const std::string &filename);
+	bool load_call_json(const std::string &filename);
+public:
+	// a talkgroup quiet for longer than timeout ms starts a new call
+	CallHistory(int64_t timeout);
+
+	/*
+	 * Adds the calls in journal (.journal) and call (.json) files,
+	 * searching directories. Files are read in name order, which is
+	 * the order the journals were written in.
+	 */
+	void load(const std::vector<std::string> &paths);
+
+	const std::vector<HistoricalCall> &get_calls() const { return calls; }
+	// from the first grant to the last activity
+	int64_t get_span() const;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "call_index.h"
+#include <sqlite3.h>
+#include <string.h>
+#include <boost/bind.hpp>
+#include <boost/log/trivial.hpp>
+
+// queued calls are written at least this often ...
+static const int FLUSH_MS = 1000;
+// ... or as soon as this many are waiting
+static const size_t BATCH_SIZE = 256;
+
+static const char *SCHEMA =
+	"CREATE TABLE IF NOT EXISTS calls ("
+	" id INTEGER PRIMARY KEY,"
+	" talkgroup INTEGER NOT NULL,"
+	" freq REAL NOT NULL,"
+	" tdma INTEGER NOT NULL,"
+	" emergency INTEGER NOT NULL,"
+	" encrypted INTEGER NOT NULL,"
+	" priority INTEGER NOT NULL,"
+	" grant_time INTEGER NOT NULL,"
+	" recorder_time INTEGER,"
+	" first_voice_time INTEGER,"
+	" last_voice_time INTEGER,"
+	" stop_time INTEGER,"
+	" filename TEXT,"
+	" voice_error_rate REAL,"
+	" mer REAL,"
+	" sync_losses INTEGER,"
+	" frames INTEGER,"
+	" silence_removed INTEGER);"
+	"CREATE TABLE IF NOT EXISTS call_units ("
+	" call_id INTEGER NOT NULL REFERENCES calls(id),"
+	" unit INTEGER NOT NULL);"
+	"CREATE INDEX IF NOT EXISTS calls_talkgroup ON calls(talkgroup, grant_time);"
+	"CREATE INDEX IF NOT EXISTS calls_time ON calls(grant_time);"
+	"CREATE INDEX IF NOT EXISTS calls_freq ON calls(freq, grant_time);"
+	"CREATE INDEX IF NOT EXISTS calls_emergency ON calls(emergency, grant_time);"
+	"CREATE INDEX IF NOT EXISTS calls_quality ON calls(voice_error_rate);"
+	"CREATE INDEX IF NOT EXISTS call_units_unit ON call_units(unit, call_id);"
+	"CREATE INDEX IF NOT EXISTS call_units_call ON call_units(call_id);";
+
+CallIndex::CallIndex() {
+	db = NULL;
+	insert_call = NULL;
+	insert_unit = NULL;
+	stopping = false;
+	writer = NULL;
+}
+
+CallIndex::~CallIndex() {
+	close();
+}
+
+bool CallIndex::exec(const char *sql) {
+	char *error = NULL;
+	if (sqlite3_exec(db, sql, NULL, NULL, &error) != SQLITE_OK) {
+		BOOST_LOG_TRIVIAL(error) << "Call index: " << (error ? error : sqlite3_errmsg(db));
+		sqlite3_free(error);
+		return false;
+	}
+	return true;
+}
+
+// adds a column that a database made by an older version is missing
+bool CallIndex::add_column(const char *table, const char *column) {
+	std::string name(column, strcspn(column, " "));
+	std::string query = std::string("PRAGMA table_info(") + table + ");";
+	sqlite3_stmt *stmt = NULL;
+	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+		return false;
+	}
+	bool found = false;
+	while (!found && (sqlite3_step(stmt) == SQLITE_ROW)) {
+		found = name == (const char *) sqlite3_column_text(stmt, 1);
+	}
+	sqlite3_finalize(stmt);
+	if (found) {
+		return true;
+	}
+	return exec((std::string("ALTER TABLE ") + table + " ADD COLUMN " + column + ";").c_str());
+}
+
+bool CallIndex::open(const std::string &filename) {
+	if (sqlite3_open(filename.c_str(), &db) != SQLITE_OK) {
+		BOOST_LOG_TRIVIAL(error) << "Call index: unable to open " << filename << ": " << sqlite3_errmsg(db);
+		sqlite3_close(db);
+		db = NULL;
+		return false;
+	}
+	// readers are not blocked by the writer, and a commit does not
+	// wait for the disk; a crash can lose the last batch, not the
+	// database
+	if (!exec("PRAGMA journal_mode=WAL;") ||
+	    !exec("PRAGMA synchronous=NORMAL;") ||
+	    !exec(SCHEMA) ||
+	    !add_column("calls", "silence_removed INTEGER") ||
+	    (sqlite3_prepare_v2(db,
+	        "INSERT INTO calls (talkgroup, freq, tdma, emergency, encrypted, priority, grant_time, recorder_time,"
+	        " first_voice_time, last_voice_time, stop_time, filename, voice_error_rate, mer, sync_losses, frames,"
+	        " silence_removed)"
+	        " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);", -1, &insert_call, NULL) != SQLITE_OK) ||
+	    (sqlite3_prepare_v2(db, "INSERT INTO call_units (call_id, unit) VALUES (?, ?);", -1, &insert_unit, NULL) != SQLITE_OK)) {
+		BOOST_LOG_TRIVIAL(error) << "Call index: unable to set up " << filename << ": " << sqlite3_errmsg(db);
+		close();
+		return false;
+	}
+	// readers that find the database locked retry instead of failing
+	sqlite3_busy_timeout(db, 5000);
+
+	stopping = false;
+	writer = new gr::thread::thread(boost::bind(&CallIndex::run, this));
+	BOOST_LOG_TRIVIAL(info) << "Call index: " << filename;
+	return true;
+}
+
+void CallIndex::close() {
+	if (writer) {
+		{
+			gr::thread::scoped_lock guard(mutex);
+			stopping = true;
+			wake.notify_one();
+		}
+		writer->join();
+		delete writer;
+		writer = NULL;
+	}
+	sqlite3_finalize(insert_call);
+	sqlite3_finalize(insert_unit);
+	insert_call = NULL;
+	insert_unit = NULL;
+	if (db) {
+		sqlite3_close(db);
+		db = NULL;
+	}
+}
+
+void CallIndex::add(const CallIndexRecord &record) {
+	gr::thread::scoped_lock guard(mutex);
+	if (!writer) {
+		return;
+	}
+	pending.push_back(record);
+	if (pending.size() >= BATCH_SIZE) {
+		wake.notify_one();
+	}
+}
+
+static void bind_time(sqlite3_stmt *stmt, int column, int64_t t) {
+	if (t) {
+		sqlite3_bind_int64(stmt, column, t);
+	} else {
+		sqlite3_bind_null(stmt, column);
+	}
+}
+
+void CallIndex::write(const std::vector<CallIndexRecord> &records) {
+	if (!exec("BEGIN;")) {
+		return;
+	}
+	for (size_t i = 0; i < records.size(); i++) {
+		const CallIndexRecord &r = records[i];
+
+		sqlite3_reset(insert_call);
+		sqlite3_bind_int64(insert_call, 1, r.talkgroup);
+		sqlite3_bind_double(insert_call, 2, r.freq);
+		sqlite3_bind_int(insert_call, 3, r.tdma);
+		sqlite3_bind_int(insert_call, 4, r.emergency);
+		sqlite3_bind_int(insert_call, 5, r.encrypted);
+		sqlite3_bind_int(insert_call, 6, r.priority);
+		sqlite3_bind_int64(insert_call, 7, r.grant_time);
+		bind_time(insert_call, 8, r.recorder_time);
+		bind_time(insert_call, 9, r.first_voice_time);
+		bind_time(insert_call, 10, r.last_voice_time);
+		bind_time(insert_call, 11, r.stop_time);
+		sqlite3_bind_text(insert_call, 12, r.filename.c_str(), -1, SQLITE_TRANSIENT);
+		if (r.has_quality) {
+			sqlite3_bind_double(insert_call, 13, r.voice_error_rate);
+			if (r.has_mer) {
+				sqlite3_bind_double(insert_call, 14, r.mer);
+			} else {
+				sqlite3_bind_null(insert_call, 14);
+			}
+			sqlite3_bind_int(insert_call, 15, r.sync_losses);
+			sqlite3_bind_int(insert_call, 16, r.frames);
+		} else {
+			for (int column = 13; column <= 16; column++) {
+				sqlite3_bind_null(insert_call, column);
+			}
+		}
+		sqlite3_bind_int64(insert_call, 17, r.silence_removed_ms);
+		if (sqlite3_step(insert_call) != SQLITE_DONE) {
+			BOOST_LOG_TRIVIAL(error) << "Call index: unable to add TG " << r.talkgroup << ": " << sqlite3_errmsg(db);
+			continue;
+		}
+
+		sqlite3_int64 id = sqlite3_last_insert_rowid(db);
+		for (size_t j = 0; j < r.units.size(); j++) {
+			sqlite3_reset(insert_unit);
+			sqlite3_bind_int64(insert_unit, 1, id);
+			sqlite3_bind_int64(insert_unit, 2, r.units[j]);
+			sqlite3_step(insert_unit);
+		}
+	}
+	exec("COMMIT;");
+}
+
+void CallIndex::run() {
+	std::vector<CallIndexRecord> batch;
+	bool done = false;
+
+	while (!done) {
+		{
+			gr::thread::scoped_lock guard(mutex);
+			if (!stopping && (pending.size() < BATCH_SIZE)) {
+				wake.timed_wait(guard, boost::posix_time::milliseconds(FLUSH_MS));
+			}
+			batch.swap(pending);
+			done = stopping;
+		}
+		if (!batch.empty()) {
+			write(batch);
+			batch.clear();
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef CALL_INDEX_H
+#define CALL_INDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <gnuradio/thread/thread.h>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/*
+ * One row of the call index, filled in by Call::end_call(). Times are
+ * milliseconds since the epoch, 0 if it did not happen.
+ */
+struct CallIndexRecord {
+	long talkgroup;
+	double freq;
+	int tdma;
+	bool emergency;
+	bool encrypted;
+	int priority;
+	int64_t grant_time;
+	int64_t recorder_time;
+	int64_t first_voice_time;
+	int64_t last_voice_time;
+	int64_t stop_time;
+	std::string filename;
+	// decode quality, has_quality is false when there is none
+	bool has_quality;
+	double voice_error_rate;
+	bool has_mer;        // false for C4FM
+	double mer;
+	uint32_t sync_losses;
+	uint32_t frames;
+	int64_t silence_removed_ms;  // by the silence gate
+	std::vector<long> units;
+};
+
+/*
+ * SQLite database of the recorded calls, so they can be searched by
+ * talkgroup, time, frequency, unit, emergency or quality without
+ * walking the call directories.
+ *
+ * add() only queues the record. A thread of its own writes the queue
+ * out in one transaction per batch, at least once a second, so the
+ * main loop never waits on the disk. The database is in WAL mode and
+ * can be read while it is being written.
+ */
+class CallIndex {
+	sqlite3 *db;
+	sqlite3_stmt *insert_call;
+	sqlite3_stmt *insert_unit;
+	gr::thread::mutex mutex;
+	gr::thread::condition_variable wake;
+	std::vector<CallIndexRecord> pending;
+	bool stopping;
+	gr::thread::thread *writer;
+
+	bool exec(const char *sql);
+	bool add_column(const char *table, const char *column);
+	void write(const std::vector<CallIndexRecord> &records);
+	void run();
+public:
+	CallIndex();
+	~CallIndex();
+
+	// opens or creates the database and starts the writer
+	bool open(const std::string &filename);
+
+	void add(const CallIndexRecord &record);
+
+	// writes what is queued and stops the writer
+	void close();
+};
+
+#endif
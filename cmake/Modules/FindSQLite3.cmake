@@ -0,0 +1,24 @@
+INCLUDE(FindPkgConfig)
+PKG_CHECK_MODULES(PC_SQLITE3 sqlite3)
+
+FIND_PATH(
+    SQLITE3_INCLUDE_DIRS
+    NAMES sqlite3.h
+    HINTS $ENV{SQLITE3_DIR}/include
+        ${PC_SQLITE3_INCLUDEDIR}
+    PATHS /usr/local/include
+          /usr/include
+)
+
+FIND_LIBRARY(
+    SQLITE3_LIBRARIES
+    NAMES sqlite3
+    HINTS $ENV{SQLITE3_DIR}/lib
+        ${PC_SQLITE3_LIBDIR}
+    PATHS /usr/local/lib
+          /usr/lib
+)
+
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(SQLITE3 DEFAULT_MSG SQLITE3_LIBRARIES SQLITE3_INCLUDE_DIRS)
+MARK_AS_ADVANCED(SQLITE3_LIBRARIES SQLITE3_INCLUDE_DIRS)
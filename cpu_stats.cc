@@ -0,0 +1,55 @@
+#include "cpu_stats.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <boost/log/trivial.hpp>
+
+CpuStats::CpuStats() {
+	read_times(last);
+}
+
+int CpuStats::num_cores() {
+	return last.size();
+}
+
+bool CpuStats::read_times(std::vector<CoreTimes> &times) {
+	std::ifstream in("/proc/stat");
+	std::string line;
+
+	if (!in.is_open()) {
+		return false;
+	}
+	times.clear();
+	while (std::getline(in, line)) {
+		// the per core lines are "cpuN", skip the "cpu" total
+		if ((line.compare(0, 3, "cpu") != 0) || (line.size() < 4) || (line[3] == ' ')) {
+			continue;
+		}
+		std::istringstream fields(line.substr(line.find(' ')));
+		uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+		fields >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+
+		CoreTimes core;
+		core.busy = user + nice + system + irq + softirq + steal;
+		core.total = core.busy + idle + iowait;
+		times.push_back(core);
+	}
+	return true;
+}
+
+void CpuStats::log_utilization() {
+	std::vector<CoreTimes> now;
+
+	if (!read_times(now)) {
+		BOOST_LOG_TRIVIAL(error) << "\tUnable to read /proc/stat for the CPU utilization";
+		return;
+	}
+	std::ostringstream msg;
+	for (size_t i = 0; (i < now.size()) && (i < last.size()); i++) {
+		uint64_t total = now[i].total - last[i].total;
+		uint64_t busy = now[i].busy - last[i].busy;
+		msg << "\t" << i << ": " << (total ? (100 * busy / total) : 0) << "%";
+	}
+	BOOST_LOG_TRIVIAL(info) << "\tCPU Utilization -" << msg.str();
+	last = now;
+}
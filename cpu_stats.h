@@ -0,0 +1,24 @@
+#ifndef CPU_STATS_H
+#define CPU_STATS_H
+
+#include <vector>
+#include <stdint.h>
+
+/*
+ * Per core utilization from /proc/stat, so the effect of pinning
+ * sources and recorders to cores can be seen in the log.
+ */
+class CpuStats {
+	struct CoreTimes {
+		uint64_t busy;
+		uint64_t total;
+	};
+	std::vector<CoreTimes> last;
+	bool read_times(std::vector<CoreTimes> &times);
+public:
+	CpuStats();
+	int num_cores();
+	// logs how busy each core was since the last call
+	void log_utilization();
+};
+#endif
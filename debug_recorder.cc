@@ -20,6 +20,7 @@ debug_recorder::debug_recorder(Source *src)
 	samp_rate = source->get_rate();
 	talkgroup = 0;
 	num = 0;
+	epoch = 0;
 	active = false;
 
 
@@ -35,7 +36,7 @@ debug_recorder::debug_recorder(Source *src)
 
 
 
-	lpf_taps =  gr::filter::firdes::low_pass(1, samp_rate, xlate_bandwidth/2, 5000, gr::filter::firdes::WIN_BLACKMAN);
+	lpf_taps =  cached_low_pass(1, samp_rate, xlate_bandwidth/2, 5000, gr::filter::firdes::WIN_BLACKMAN);
 
 	prefilter = gr::filter::freq_xlating_fir_filter_ccf::make(decim,
 	            lpf_taps,
@@ -47,15 +48,11 @@ debug_recorder::debug_recorder(Source *src)
 	resampler_taps = design_filter(channel_rate, pre_channel_rate);
 
 	downsample_sig = gr::filter::rational_resampler_base_ccf::make(channel_rate, pre_channel_rate, resampler_taps);
-	valve = gr::blocks::copy::make(sizeof(gr_complex));
+	valve = make_preroll_valve(source->get_preroll(), source->get_preroll_catchup());
 	valve->set_enabled(false);
 
-	std::stringstream path_stream;
-	path_stream << boost::filesystem::current_path().string() <<  "/debug";
-
-	boost::filesystem::create_directories(path_stream.str());
-	sprintf(filename, "%s/%ld-%ld_%g.raw", path_stream.str().c_str(),talkgroup,starttime,freq);
-	raw_sink = gr::blocks::file_sink::make(sizeof(gr_complex), filename);
+	// file_sink has to open something, activate() opens the real file
+	raw_sink = gr::blocks::file_sink::make(sizeof(gr_complex), "/dev/null");
 
 
 
@@ -131,5 +128,6 @@ void debug_recorder::activate(Call *call, int n) {
 
 
 	active = true;
-	valve->set_enabled(true);
+	epoch++;
+	valve->start_from(call->get_grant_time() - source->get_preroll_time(), epoch);
 }
\ No newline at end of file
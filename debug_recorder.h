@@ -48,8 +48,10 @@
 //#include <gnuradio/blocks/wavfile_sink.h>
 #include <gnuradio/blocks/file_sink.h>
 //#include <blocks/wavfile_sink.h>
+#include "preroll_valve.h"
 #include "recorder.h"
 #include "smartnet.h"
+#include "filter_cache.h"
 
 class Source;
 class debug_recorder;
@@ -75,8 +77,8 @@ public:
     Source *get_source();
 	long get_talkgroup();
 	bool is_active();
-	int lastupdate();
-	long elapsed();
+	int64_t lastupdate();
+	int64_t elapsed();
 	void close();
 
 	//void forecast(int noutput_items, gr_vector_int &ninput_items_required);
@@ -91,6 +93,7 @@ private:
 	char filename[160];
 
 	int num;
+	long epoch;  // activation number, tags the first sample of each call
 
 	bool iam_logging;
 	bool active;
@@ -121,7 +124,7 @@ private:
 	gr::blocks::file_sink::sptr raw_sink;
 	gr::blocks::null_sink::sptr null_sink;
 	gr::blocks::head::sptr head_source;
-	gr::blocks::copy::sptr valve;
+	preroll_valve_sptr valve;
 	//gr_kludge_copy_sptr copier;
 
 };
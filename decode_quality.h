@@ -0,0 +1,57 @@
+#ifndef DECODE_QUALITY_H
+#define DECODE_QUALITY_H
+
+#include <stdint.h>
+#include <math.h>
+#include <op25_repeater/decode_stats.h>
+
+// How well a call decoded, from the recorder's frame assembler and
+// symbol slicer
+struct DecodeQuality {
+	gr::op25_repeater::decode_stats stats;
+	uint64_t slicer_symbols;  // symbols symbol_error is over, 0 if not measured
+	double symbol_error;      // mean squared distance from the ideal symbol levels
+
+	DecodeQuality() : slicer_symbols(0), symbol_error(0) {}
+
+	// modulation error ratio in dB: power of the ideal -3/-1/+1/+3
+	// symbols (5 on average) over the symbol error
+	double mer() const {
+		if (!slicer_symbols || symbol_error <= 0) {
+			return 0;
+		}
+		return 10 * log10(5 / symbol_error);
+	}
+
+	// average bit errors the vocoder found per IMBE codeword
+	double voice_error_rate() const {
+		if (!stats.voice_codewords) {
+			return 0;
+		}
+		return (double) stats.voice_et_errors / stats.voice_codewords;
+	}
+};
+
+// A recorder's decode counts summed over its calls since startup
+struct DecodeTotals {
+	uint64_t frames;
+	uint64_t sync_losses;
+	uint64_t voice_codewords;
+	uint64_t voice_errors;  // ET bit errors in those codewords
+	bool has_mer;
+	double last_mer;        // of the last call MER was measured on
+
+	DecodeTotals() : frames(0), sync_losses(0), voice_codewords(0), voice_errors(0), has_mer(false), last_mer(0) {}
+
+	void add(const DecodeQuality &quality) {
+		frames += quality.stats.frames;
+		sync_losses += quality.stats.sync_losses;
+		voice_codewords += quality.stats.voice_codewords;
+		voice_errors += quality.stats.voice_et_errors;
+		if (quality.slicer_symbols) {
+			has_mer = true;
+			last_mer = quality.mer();
+		}
+	}
+};
+#endif
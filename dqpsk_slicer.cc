@@ -0,0 +1,95 @@
+#include "dqpsk_slicer.h"
+#include <gnuradio/io_signature.h>
+#include <gnuradio/math.h>
+#include <op25_repeater/epoch_tag.h>
+#include <stdint.h>
+#include <math.h>
+
+dqpsk_slicer_sptr make_dqpsk_slicer(const std::vector<float> &slice_levels)
+{
+	return dqpsk_slicer_sptr (new dqpsk_slicer (slice_levels));
+}
+
+dqpsk_slicer::dqpsk_slicer(const std::vector<float> &slice_levels)
+	: gr::sync_block ("dqpsk_slicer",
+	                  gr::io_signature::make (1, 1, sizeof (gr_complex)),
+	                  gr::io_signature::make (1, 1, sizeof (unsigned char)))
+{
+	for (int i = 0; i < 4; i++)
+		d_slice_levels[i] = slice_levels[i];
+	d_last = gr_complex(0, 0);
+	d_epoch = -1;
+	d_error_sum = 0;
+	d_symbols = 0;
+}
+
+void dqpsk_slicer::get_symbol_error(long &epoch, double &mean_square, uint64_t &symbols)
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	epoch = d_epoch;
+	symbols = d_symbols;
+	mean_square = d_symbols ? d_error_sum / d_symbols : 0;
+}
+
+dqpsk_slicer::~dqpsk_slicer()
+{
+}
+
+int
+dqpsk_slicer::work (int noutput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items)
+{
+	const gr_complex *in = (const gr_complex *) input_items[0];
+	unsigned char *out = (unsigned char *) output_items[0];
+	// radians to -3/-1/+1/+3
+	const float scale = 4.0 / M_PI;
+	std::vector<gr::tag_t> tags;
+	size_t next_tag = 0;
+	float error_sum = 0;
+
+	get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + noutput_items, gr::op25_repeater::epoch_tag_key());
+	gr::thread::scoped_lock guard(d_mutex);
+
+	for (int i = 0; i < noutput_items; i++) {
+		if (next_tag < tags.size() && tags[next_tag].offset == nitems_read(0) + i) {
+			// a new activation, start measuring over
+			d_epoch = pmt::to_long(tags[next_tag].value);
+			d_error_sum = 0;
+			d_symbols = 0;
+			error_sum = 0;
+			next_tag++;
+		}
+		gr_complex diff = in[i] * conj(d_last);
+		float sym = gr::fast_atan2f(diff.imag(), diff.real()) * scale;
+		d_last = in[i];
+
+		// same decision as fsk4_slicer_fb
+		uint8_t dibit;
+		if (d_slice_levels[3] < 0) {
+			dibit = 1;
+			if (d_slice_levels[3] <= sym && sym < d_slice_levels[0])
+				dibit = 3;
+		} else {
+			dibit = 3;
+			if (d_slice_levels[2] <= sym && sym < d_slice_levels[3])
+				dibit = 1;
+		}
+		if (d_slice_levels[0] <= sym && sym < d_slice_levels[1])
+			dibit = 2;
+		if (d_slice_levels[1] <= sym && sym < d_slice_levels[2])
+			dibit = 0;
+		out[i] = dibit;
+
+		// distance to the nearest of -3/-1/+1/+3
+		float ideal = 2 * floorf(sym / 2) + 1;
+		if (ideal > 3)
+			ideal = 3;
+		else if (ideal < -3)
+			ideal = -3;
+		error_sum += (sym - ideal) * (sym - ideal);
+		d_symbols++;
+	}
+	d_error_sum += error_sum;
+	return noutput_items;
+}
@@ -0,0 +1,57 @@
+#ifndef DQPSK_SLICER_H
+#define DQPSK_SLICER_H
+
+#include <vector>
+#include <stdint.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_complex.h>
+#include <gnuradio/thread/thread.h>
+
+class dqpsk_slicer;
+
+typedef boost::shared_ptr<dqpsk_slicer> dqpsk_slicer_sptr;
+
+dqpsk_slicer_sptr make_dqpsk_slicer(const std::vector<float> &slice_levels);
+
+/*!
+ * \brief Differential QPSK symbols to P25 dibits.
+ *
+ * Does the work of diff_phasor_cc, complex_to_arg, multiply_const_ff
+ * (by 4 / pi) and fsk4_slicer_fb in one block, so a digital recorder
+ * runs one scheduler thread for it instead of four and the symbols are
+ * not copied through three buffers on the way. Stream tags pass
+ * through unchanged, as they did through the four sync blocks.
+ *
+ * It also measures how far the symbols land from the ideal
+ * -3/-1/+1/+3, per activation epoch, as an estimate of the signal
+ * quality.
+ */
+class dqpsk_slicer : public gr::sync_block
+{
+	friend dqpsk_slicer_sptr make_dqpsk_slicer(const std::vector<float> &slice_levels);
+
+	dqpsk_slicer(const std::vector<float> &slice_levels);
+
+	float d_slice_levels[4];
+	gr_complex d_last;
+
+	gr::thread::mutex d_mutex;
+	long d_epoch;
+	double d_error_sum;      // squared distance from the ideal symbols
+	uint64_t d_symbols;
+
+public:
+	~dqpsk_slicer();
+
+	/*!
+	 * Mean squared symbol error and the number of symbols it is over,
+	 * for activation epoch (see epoch_tag_key()). Thread-safe.
+	 */
+	void get_symbol_error(long &epoch, double &mean_square, uint64_t &symbols);
+
+	int work(int noutput_items,
+	         gr_vector_const_void_star &input_items,
+	         gr_vector_void_star &output_items);
+};
+
+#endif /* DQPSK_SLICER_H */
@@ -0,0 +1,98 @@
+#include "filter_cache.h"
+#include "smartnet.h"
+#include <map>
+
+namespace {
+
+struct FilterKey {
+	enum { LOW_PASS, LOW_PASS_2 } design;
+	double params[6];
+	int window;
+
+	bool operator<(const FilterKey &other) const {
+		if (design != other.design) {
+			return design < other.design;
+		}
+		if (window != other.window) {
+			return window < other.window;
+		}
+		for (int i = 0; i < 6; i++) {
+			if (params[i] != other.params[i]) {
+				return params[i] < other.params[i];
+			}
+		}
+		return false;
+	}
+};
+
+std::map<FilterKey, std::vector<float> > filter_cache;
+
+}
+
+std::vector<float> cached_low_pass(double gain, double sampling_freq, double cutoff_freq, double transition_width,
+                                   gr::filter::firdes::win_type window, double beta) {
+	FilterKey key;
+	key.design = FilterKey::LOW_PASS;
+	key.params[0] = gain;
+	key.params[1] = sampling_freq;
+	key.params[2] = cutoff_freq;
+	key.params[3] = transition_width;
+	key.params[4] = 0;
+	key.params[5] = beta;
+	key.window = window;
+
+	std::map<FilterKey, std::vector<float> >::iterator it = filter_cache.find(key);
+	if (it == filter_cache.end()) {
+		it = filter_cache.insert(std::make_pair(key, gr::filter::firdes::low_pass(gain, sampling_freq, cutoff_freq, transition_width, window, beta))).first;
+	}
+	return it->second;
+}
+
+std::vector<float> cached_low_pass_2(double gain, double sampling_freq, double cutoff_freq, double transition_width,
+                                     double attenuation_dB, gr::filter::firdes::win_type window, double beta) {
+	FilterKey key;
+	key.design = FilterKey::LOW_PASS_2;
+	key.params[0] = gain;
+	key.params[1] = sampling_freq;
+	key.params[2] = cutoff_freq;
+	key.params[3] = transition_width;
+	key.params[4] = attenuation_dB;
+	key.params[5] = beta;
+	key.window = window;
+
+	std::map<FilterKey, std::vector<float> >::iterator it = filter_cache.find(key);
+	if (it == filter_cache.end()) {
+		it = filter_cache.insert(std::make_pair(key, gr::filter::firdes::low_pass_2(gain, sampling_freq, cutoff_freq, transition_width, attenuation_dB, window, beta))).first;
+	}
+	return it->second;
+}
+
+size_t cached_filter_count() {
+	return filter_cache.size();
+}
+
+unsigned GCD(unsigned u, unsigned v) {
+	while ( v != 0) {
+		unsigned r = u % v;
+		u = v;
+		v = r;
+	}
+	return u;
+}
+
+std::vector<float> design_filter(double interpolation, double deci) {
+	float beta = 5.0;
+	float trans_width = 0.5 - 0.4;
+	float mid_transition_band = 0.5 - trans_width/2;
+
+	std::vector<float> result = cached_low_pass(
+	                                            interpolation,
+	                                            1,
+	                                            mid_transition_band/interpolation,
+	                                            trans_width/interpolation,
+	                                            gr::filter::firdes::WIN_KAISER,
+	                                            beta
+	                                            );
+
+	return result;
+}
@@ -0,0 +1,24 @@
+#ifndef FILTER_CACHE_H
+#define FILTER_CACHE_H
+
+#include <vector>
+#include <gnuradio/filter/firdes.h>
+
+/*
+ * firdes designs memoized on their parameters. Every recorder on a
+ * source designs the same filters, at the full source rate, so only
+ * the first one pays for it. Not thread safe; recorders are built by
+ * the main thread.
+ */
+std::vector<float> cached_low_pass(double gain, double sampling_freq, double cutoff_freq, double transition_width,
+                                   gr::filter::firdes::win_type window = gr::filter::firdes::WIN_HAMMING,
+                                   double beta = 6.76);
+
+std::vector<float> cached_low_pass_2(double gain, double sampling_freq, double cutoff_freq, double transition_width,
+                                     double attenuation_dB,
+                                     gr::filter::firdes::win_type window = gr::filter::firdes::WIN_HAMMING,
+                                     double beta = 6.76);
+
+// how many designs are held
+size_t cached_filter_count();
+#endif
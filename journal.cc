@@ -0,0 +1,225 @@
+#include "journal.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <sstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boost/filesystem/operations.hpp>
+#include <boost/log/trivial.hpp>
+
+const char JOURNAL_MAGIC[8] = { 'T', 'R', 'J', 'R', 'N', 'L', '2', '\0' };
+
+int64_t replay_time_ms = 0;
+
+// buffered records are written out at least this often
+static const int64_t FLUSH_MS = 1000;
+
+JournalWriter::JournalWriter(const std::string &d) {
+	dir = d;
+	fp = NULL;
+	last_flush = 0;
+	run_ms = monotonic_ms();
+	boost::filesystem::create_directories(dir);
+}
+
+JournalWriter::~JournalWriter() {
+	if (fp) {
+		fclose(fp);
+	}
+}
+
+// starts a new file on the first message of the run and of each day
+void JournalWriter::rotate() {
+	char name[32];
+	time_t now = time(NULL);
+	struct tm local;
+	localtime_r(&now, &local);
+	strftime(name, sizeof(name), "%Y-%m-%d", &local);
+	if (fp && (day == name)) {
+		return;
+	}
+
+	if (fp) {
+		fclose(fp);
+	}
+	day = name;
+	strftime(name, sizeof(name), "%Y-%m-%d-%H%M%S", &local);
+	std::string filename = dir + "/" + name + ".journal";
+	// never another run's file, even one started in the same second;
+	// name_1 sorts after name, and before the next second's file
+	for (int n = 1; ; n++) {
+		fp = fopen(filename.c_str(), "wbx");
+		if (fp || (errno != EEXIST)) {
+			break;
+		}
+		std::ostringstream numbered;
+		numbered << dir << "/" << name << "_" << n << ".journal";
+		filename = numbered.str();
+	}
+	if (!fp) {
+		BOOST_LOG_TRIVIAL(error) << "Journal: unable to open " << filename << ": " << strerror(errno);
+		return;
+	}
+	JournalHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+	header.record_size = sizeof(JournalRecord);
+	header.message_size = sizeof(JournalMessage);
+	header.monotonic_ms = monotonic_ms();
+	header.epoch_ms = monotonic_to_epoch_ms(header.monotonic_ms);
+	header.run_ms = run_ms;
+	fwrite(&header, sizeof(header), 1, fp);
+	BOOST_LOG_TRIVIAL(info) << "Journal: " << filename;
+}
+
+void JournalWriter::append(const trunk_msg &msg, const std::vector<TrunkMessage> &messages) {
+	rotate();
+	if (!fp) {
+		return;
+	}
+
+	JournalRecord record;
+	memset(&record, 0, sizeof(record));
+	record.rx_time = msg.rx_time;
+	record.type = msg.type;
+	record.nac = msg.nac;
+	record.errors = msg.errors;
+	record.len = msg.len;
+	record.parsed = messages.size();
+	memcpy(record.data, msg.data, msg.len);
+	fwrite(&record, sizeof(record), 1, fp);
+
+	for (size_t i = 0; i < messages.size(); i++) {
+		const TrunkMessage &message = messages[i];
+		JournalMessage out;
+		memset(&out, 0, sizeof(out));
+		out.freq = message.freq;
+		out.talkgroup = message.talkgroup;
+		out.source = message.source;
+		out.message_type = message.message_type;
+		out.encrypted = message.encrypted;
+		out.emergency = message.emergency;
+		out.tdma = message.tdma;
+		fwrite(&out, sizeof(out), 1, fp);
+	}
+
+	int64_t now = monotonic_ms();
+	if (now - last_flush >= FLUSH_MS) {
+		fflush(fp);
+		last_flush = now;
+	}
+}
+
+JournalReader::JournalReader() {
+	fd = -1;
+	map = NULL;
+	size = 0;
+	pos = 0;
+}
+
+JournalReader::~JournalReader() {
+	close();
+}
+
+void JournalReader::close() {
+	if (map) {
+		munmap((void *) map, size);
+		map = NULL;
+	}
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+}
+
+bool JournalReader::open(const std::string &filename) {
+	close();
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		BOOST_LOG_TRIVIAL(error) << "Journal: unable to open " << filename << ": " << strerror(errno);
+		return false;
+	}
+	struct stat st;
+	if ((fstat(fd, &st) < 0) || (st.st_size < (off_t) sizeof(JournalHeader))) {
+		BOOST_LOG_TRIVIAL(error) << "Journal: " << filename << " is too short";
+		close();
+		return false;
+	}
+	size = st.st_size;
+	void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED) {
+		BOOST_LOG_TRIVIAL(error) << "Journal: unable to map " << filename << ": " << strerror(errno);
+		map = NULL;
+		close();
+		return false;
+	}
+	map = (const uint8_t *) p;
+	madvise(p, size, MADV_SEQUENTIAL);
+
+	const JournalHeader *header = (const JournalHeader *) map;
+	if ((memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) != 0) ||
+	    (header->record_size != sizeof(JournalRecord)) ||
+	    (header->message_size != sizeof(JournalMessage))) {
+		BOOST_LOG_TRIVIAL(error) << "Journal: " << filename << " is not a journal written by this version";
+		close();
+		return false;
+	}
+	pos = sizeof(JournalHeader);
+	return true;
+}
+
+int64_t JournalReader::get_monotonic_ms() {
+	return map ? ((const JournalHeader *) map)->monotonic_ms : 0;
+}
+
+int64_t JournalReader::get_epoch_ms() {
+	return map ? ((const JournalHeader *) map)->epoch_ms : 0;
+}
+
+int64_t JournalReader::get_run_ms() {
+	return map ? ((const JournalHeader *) map)->run_ms : 0;
+}
+
+bool JournalReader::next(trunk_msg &msg, std::vector<TrunkMessage> &messages) {
+	if (!map || (pos + sizeof(JournalRecord) > size)) {
+		return false;
+	}
+	JournalRecord record;
+	memcpy(&record, map + pos, sizeof(record));
+	// a record cut short by a crash is the end of the file
+	if (pos + sizeof(JournalRecord) + record.parsed * sizeof(JournalMessage) > size) {
+		return false;
+	}
+	pos += sizeof(JournalRecord);
+
+	msg.type = record.type;
+	msg.nac = record.nac;
+	msg.errors = record.errors;
+	msg.len = std::min<size_t>(record.len, trunk_msg::MAX_DATA);
+	msg.rx_time = record.rx_time;
+	memcpy(msg.data, record.data, msg.len);
+
+	messages.clear();
+	for (int i = 0; i < record.parsed; i++) {
+		JournalMessage in;
+		memcpy(&in, map + pos, sizeof(in));
+		pos += sizeof(in);
+
+		TrunkMessage message;
+		message.message_type = (MessageType) in.message_type;
+		message.freq = in.freq;
+		message.talkgroup = in.talkgroup;
+		message.source = in.source;
+		message.encrypted = in.encrypted;
+		message.emergency = in.emergency;
+		message.tdma = in.tdma;
+		message.rx_time = record.rx_time;
+		messages.push_back(message);
+	}
+	return true;
+}
@@ -0,0 +1,89 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "parser.h"
+
+/*
+ * Append-only log of every control channel message, as decoded and as
+ * parsed, so call management can be replayed without the radio.
+ *
+ * A journal file is a JournalHeader followed by records: a
+ * JournalRecord with the raw message from the decoder, then the
+ * JournalMessages the parser made of it. Everything is fixed size, in
+ * host byte order, so a file can be mmap()ed and walked in place.
+ *
+ * Every run of the recorder starts a file of its own, and another at
+ * each local midnight, named YYYY-MM-DD-HHMMSS.journal for when it was
+ * started. A file is never appended to by a later run, so a record cut
+ * short by a crash can only be at the end of one, and the clock in the
+ * header holds for every record in it.
+ */
+struct JournalHeader {
+	char magic[8];          // JOURNAL_MAGIC
+	uint32_t record_size;   // sizeof(JournalRecord)
+	uint32_t message_size;  // sizeof(JournalMessage)
+	int64_t monotonic_ms;   // monotonic_ms() ...
+	int64_t epoch_ms;       // ... and the wall clock when the file was started
+	int64_t run_ms;         // monotonic_ms() the run that wrote it started at
+};
+
+struct JournalRecord {
+	int64_t rx_time;        // trunk_msg::rx_time, monotonic_ms()
+	int32_t type;
+	uint32_t nac;
+	uint32_t errors;
+	uint16_t len;
+	uint16_t parsed;        // JournalMessages that follow
+	uint8_t data[trunk_msg::MAX_DATA];
+};
+
+struct JournalMessage {
+	double freq;
+	int32_t talkgroup;
+	int32_t source;
+	uint8_t message_type;
+	uint8_t encrypted;
+	uint8_t emergency;
+	uint8_t tdma;
+	uint32_t reserved;
+};
+
+extern const char JOURNAL_MAGIC[8];
+
+class JournalWriter {
+	std::string dir;
+	std::string day;   // of the open file
+	FILE *fp;
+	int64_t last_flush;
+	int64_t run_ms;
+	void rotate();
+public:
+	JournalWriter(const std::string &d);
+	~JournalWriter();
+	void append(const trunk_msg &msg, const std::vector<TrunkMessage> &messages);
+};
+
+class JournalReader {
+	int fd;
+	const uint8_t *map;
+	size_t size;
+	size_t pos;
+public:
+	JournalReader();
+	~JournalReader();
+	bool open(const std::string &filename);
+	void close();
+	// the next record, false at the end of the file
+	bool next(trunk_msg &msg, std::vector<TrunkMessage> &messages);
+	// monotonic / wall clock pair the file was started with
+	int64_t get_monotonic_ms();
+	int64_t get_epoch_ms();
+	// the same for every file written by one run of the recorder
+	int64_t get_run_ms();
+};
+
+#endif
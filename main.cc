@@ -2,6 +2,7 @@
 #include <boost/property_tree/xml_parser.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/program_options.hpp>
 #include <boost/math/constants/constants.hpp>
@@ -11,6 +12,7 @@
 #include <boost/tokenizer.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 
 #include <iostream>
@@ -20,6 +22,8 @@
 #include <sstream>
 #include <string>
 #include <fstream>
+#include <queue>
+#include <limits>
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
@@ -33,10 +37,15 @@
 #include "smartnet_trunking.h"
 #include "p25_trunking.h"
 
-#include "smartnet_crc.h"
-#include "smartnet_deinterleave.h"
 #include "talkgroups.h"
 #include "source.h"
+#include "source_index.h"
+#include "cpu_stats.h"
+#include "metrics.h"
+#include "background.h"
+#include "journal.h"
+#include "call_history.h"
+#include "call_archive.h"
 #include "call.h"
 #include "smartnet_parser.h"
 #include "p25_parser.h"
@@ -56,6 +65,18 @@ using namespace std;
 namespace logging = boost::log;
 
 std::vector<Source *> sources;
+SourceIndex *source_index;
+CpuStats *cpu_stats;
+int control_channel_core = -1;
+std::string p25_state_file;
+int metrics_port = 0;
+std::string metrics_address;
+std::string config_file = "config.json";
+std::string journal_dir;
+std::string call_index_file;
+std::string archive_dir;
+JournalWriter *journal = NULL;
+bool replay_mode = false;
 std::vector<double> control_channels;
 std::map<long,long> unit_affiliations;
 int current_control_channel = 0;
@@ -65,10 +86,24 @@ std::string talkgroups_file;
 string system_type;
 string system_modulation;
 bool qpsk_mod = true;
+int64_t call_hang_time = 500;   // ms
+int64_t call_timeout = 8000;    // ms
+int64_t voice_timeout = 2000;   // ms from activating a recorder to the first voice frame
+
+// calls by recording priority since startup
+struct PriorityStats {
+    long recorded;
+    long missed;      // no recorder could be had
+    long preempted;   // lost their recorder to a higher priority call
+    PriorityStats() : recorded(0), missed(0), preempted(0) {}
+};
+std::map<int, PriorityStats> priority_stats;
+
 gr::top_block_sptr tb;
 smartnet_trunking_sptr smartnet_trunking;
 p25_trunking_sptr p25_trunking;
-gr::msg_queue::sptr queue;
+Source *control_source = NULL;
+trunk_msg_queue::sptr control_queue;
 
 volatile sig_atomic_t exit_flag = 0;
 SmartnetParser *smartnet_parser;
@@ -80,48 +115,43 @@ void exit_interupt(int sig) { // can be called asynchronously
     exit_flag = 1; // set flag
 }
 
-unsigned GCD(unsigned u, unsigned v) {
-    while ( v != 0) {
-        unsigned r = u % v;
-        u = v;
-        v = r;
-    }
-    return u;
-}
-
-std::vector<float> design_filter(double interpolation, double deci) {
-    float beta = 5.0;
-    float trans_width = 0.5 - 0.4;
-    float mid_transition_band = 0.5 - trans_width/2;
-
-    std::vector<float> result = gr::filter::firdes::low_pass(
-                                                             interpolation,
-                                                             1,
-                                                             mid_transition_band/interpolation,
-                                                             trans_width/interpolation,
-                                                             gr::filter::firdes::WIN_KAISER,
-                                                             beta
-                                                             );
-
-    return result;
-}
-
 /**
  * Method name: load_config()
  * Description: <#description#>
  * Parameters: <#parameters#>
  */
 
+/*
+ * A list of CPU core numbers, like "cores": [2, 3]. Cores the machine
+ * does not have are left out.
+ */
+std::vector<int> read_cores(boost::property_tree::ptree &node, std::string key) {
+    std::vector<int> cores;
+    boost::optional<boost::property_tree::ptree &> list = node.get_child_optional(key);
+
+    if (!list) {
+        return cores;
+    }
+    BOOST_FOREACH( boost::property_tree::ptree::value_type  &core, *list )
+    {
+        int n = core.second.get<int>("", -1);
+        if ((n < 0) || (n >= cpu_stats->num_cores())) {
+            BOOST_LOG_TRIVIAL(error) << "\tIgnoring core " << n << ", there are " << cpu_stats->num_cores() << " cores";
+            continue;
+        }
+        cores.push_back(n);
+    }
+    return cores;
+}
+
 void load_config()
 {
 
     try
     {
 
-        const std::string json_filename = "config.json";
-
         boost::property_tree::ptree pt;
-        boost::property_tree::read_json(json_filename, pt);
+        boost::property_tree::read_json(config_file, pt);
 
         BOOST_LOG_TRIVIAL(info) << "Control Channels: ";
         BOOST_FOREACH( boost::property_tree::ptree::value_type  &node,pt.get_child("system.control_channels") )
@@ -134,6 +164,8 @@ void load_config()
 
         talkgroups_file = pt.get<std::string>("talkgroupsFile","");
         BOOST_LOG_TRIVIAL(info) << "Talkgroups File: " << talkgroups_file;
+        metrics_port = pt.get<int>("metricsPort", 0);
+        metrics_address = pt.get<std::string>("metricsAddress", "127.0.0.1");
         system_type = pt.get<std::string>("system.type");
         boost::optional<std::string> mod_exists = pt.get_optional<std::string>("system.modulation");
         if (mod_exists) {
@@ -150,6 +182,32 @@ void load_config()
         } else {
             qpsk_mod = true;
         }
+        call_hang_time = pt.get<int64_t>("system.hangTime", 500);
+        call_timeout = pt.get<int64_t>("system.callTimeout", 8000);
+        voice_timeout = pt.get<int64_t>("system.voiceTimeout", 2000);
+        BOOST_LOG_TRIVIAL(info) << "Call Hang Time: " << call_hang_time << "ms";
+        BOOST_LOG_TRIVIAL(info) << "Call Timeout: " << call_timeout << "ms";
+        BOOST_LOG_TRIVIAL(info) << "Voice Timeout: " << voice_timeout << "ms";
+        p25_state_file = pt.get<std::string>("system.stateFile", "p25_state.json");
+        journal_dir = pt.get<std::string>("system.journalDir", "");
+        call_index_file = pt.get<std::string>("system.callIndex", "");
+        Call::write_json = pt.get<bool>("system.callJson", true);
+        archive_dir = pt.get<std::string>("system.archiveDir", "");
+        silence_gate::configure(pt.get<bool>("system.silenceGate", false),
+                                pt.get<float>("system.silenceThreshold", -40),
+                                pt.get<int64_t>("system.silenceKeep", 250),
+                                pt.get<float>("system.silenceNoise", -10));
+        if (silence_gate::enabled()) {
+            BOOST_LOG_TRIVIAL(info) << "Silence Gate: " << pt.get<float>("system.silenceThreshold", -40) << "dB";
+        }
+        control_channel_core = pt.get<int>("system.controlChannelCore", -1);
+        if (control_channel_core >= cpu_stats->num_cores()) {
+            BOOST_LOG_TRIVIAL(error) << "\tIgnoring controlChannelCore " << control_channel_core << ", there are " << cpu_stats->num_cores() << " cores";
+            control_channel_core = -1;
+        }
+        if (control_channel_core >= 0) {
+            BOOST_LOG_TRIVIAL(info) << "Control Channel Core: " << control_channel_core;
+        }
         BOOST_FOREACH( boost::property_tree::ptree::value_type  &node,pt.get_child("sources") )
         {
             double center = node.second.get<double>("center",0);
@@ -163,14 +221,20 @@ void load_config()
             int digital_recorders = node.second.get<int>("digitalRecorders",0);
             int debug_recorders = node.second.get<int>("debugRecorders",0);
             int analog_recorders = node.second.get<int>("analogRecorders",0);
+            int64_t preroll_time = node.second.get<int64_t>("prerollTime",0);
+            float preroll_catchup = node.second.get<float>("prerollCatchup",4.0);
+            bool lazy_recorders = node.second.get<bool>("lazyRecorders",false);
+            bool afc = node.second.get<bool>("afc",false);
 
             std::string driver = node.second.get<std::string>("driver","");
             std::string device = node.second.get<std::string>("device","");
+            std::vector<int> cores = read_cores(node.second, "cores");
 
             BOOST_LOG_TRIVIAL(info) << "Center: " << node.second.get<double>("center",0);
             BOOST_LOG_TRIVIAL(info) << "Rate: " << node.second.get<double>("rate",0);
             BOOST_LOG_TRIVIAL(info) << "Error: " << node.second.get<double>("error",0);
             BOOST_LOG_TRIVIAL(info) << "PPM Error: " << node.second.get<double>("ppm",0);
+            BOOST_LOG_TRIVIAL(info) << "AFC: " << afc;
             BOOST_LOG_TRIVIAL(info) << "Gain: " << node.second.get<int>("gain",0);
             BOOST_LOG_TRIVIAL(info) << "IF Gain: " << node.second.get<int>("ifGain",0);
             BOOST_LOG_TRIVIAL(info) << "BB Gain: " << node.second.get<int>("bbGain",0);
@@ -181,6 +245,14 @@ void load_config()
             BOOST_LOG_TRIVIAL(info) << "driver: " << node.second.get<std::string>("driver","");
 
 
+            if (replay_mode) {
+                // only the recorder allocation is replayed, no SDR or DSP
+                Source *source = new Source(center,rate,error,"replay",device);
+                source->create_replay_recorders(digital_recorders, analog_recorders);
+                sources.push_back(source);
+                continue;
+            }
+
             if ((ppm!=0) && (error!=0)) {
                 BOOST_LOG_TRIVIAL(info) << "Both PPM and Error should not be set at the same time. Setting Error to 0.";
                 error = 0;
@@ -196,6 +268,25 @@ void load_config()
             if (ppm!=0){
                 source->set_freq_corr(ppm);
             }
+            source->set_afc(afc);
+            if (!cores.empty()) {
+                std::ostringstream core_list;
+                for (size_t i = 0; i < cores.size(); i++) {
+                    core_list << " " << cores[i];
+                }
+                BOOST_LOG_TRIVIAL(info) << "Cores:" << core_list.str();
+                source->set_cores(cores);
+            }
+            if (preroll_time > 0) {
+                source->create_preroll(tb, preroll_time, preroll_catchup);
+            }
+            if (lazy_recorders && (preroll_time > 0)) {
+                // restarting the flow graph for a new recorder would throw
+                // off the sample counts the pre-roll is lined up with
+                BOOST_LOG_TRIVIAL(error) << "lazyRecorders can not be used with prerollTime, building the recorders now";
+                lazy_recorders = false;
+            }
+            source->set_lazy_recorders(lazy_recorders);
             source->create_digital_recorders(tb, digital_recorders, qpsk_mod);
             source->create_analog_recorders(tb, analog_recorders);
             source->create_debug_recorders(tb, debug_recorders);
@@ -237,64 +328,214 @@ bool replace(std::string& str, const std::string& from, const std::string& to) {
     return true;
 }
 
+bool is_analog(Call *call) {
+    Talkgroup * talkgroup = talkgroups->find_talkgroup(call->get_talkgroup());
+    return talkgroup && (talkgroup->mode == 'A');
+}
+
+/*
+ * Recording priority of a call, 1 is the highest. Emergencies get 0,
+ * which always takes an idle recorder and can preempt anything else.
+ */
+int get_call_priority(Call *call) {
+    if (call->get_emergency()) {
+        return 0;
+    }
+    Talkgroup * talkgroup = talkgroups->find_talkgroup(call->get_talkgroup());
+    if (talkgroup) {
+        return talkgroup->get_priority();
+    }
+    return 2;
+}
+
+Recorder *get_recorder(Source *source, bool analog, int priority) {
+    if (analog) {
+        return source->get_analog_recorder(priority);
+    }
+    return source->get_digital_recorder(priority);
+}
+
+/*
+ * The source has no idle recorder for a call of the given priority.
+ * Stop recording the lowest priority call on it that is lower than
+ * that, if there is one. The preempted call is parked, so it is not
+ * ended a second time when it is purged at callTimeout.
+ */
+bool preempt_recorder(Source *source, bool analog, int priority) {
+    int available = analog ? source->get_num_available_analog_recorders() : source->get_num_available_recorders();
+    if (available > 0) {
+        // the idle ones are held back for higher priorities
+        return false;
+    }
+
+    Call *victim = NULL;
+    for(vector<Call *>::iterator it = calls.begin(); it != calls.end(); it++) {
+        Call *call = *it;
+        if ((call->get_recording() == true) &&
+            (call->get_recorder()->get_source() == source) &&
+            (is_analog(call) == analog) &&
+            (call->get_priority() > priority) &&
+            (!victim || (call->get_priority() > victim->get_priority()))) {
+            victim = call;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "\tPreempting TG: " << victim->get_talkgroup() << " (priority " << victim->get_priority() << ") for a priority " << priority << " call";
+    victim->park();
+    priority_stats[victim->get_priority()].preempted++;
+    Metrics::add(Metrics::CALLS_PREEMPTED);
+    return true;
+}
+
+static void metric_header(std::ostream &out, const char *name, const char *type, const char *help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+/*
+ * Hands the values only the main loop may read over to the metrics
+ * server, see Metrics.
+ */
+void publish_metrics(float decode_rate, int post_call_jobs) {
+    std::ostringstream out;
+    std::string system_label = "system=\"" + system_type + "\"";
+
+    metric_header(out, "trunk_recorder_decode_rate", "gauge", "Control channel messages decoded per second.");
+    out << "trunk_recorder_decode_rate{" << system_label << "} " << decode_rate << "\n";
+    metric_header(out, "trunk_recorder_message_queue_depth", "gauge", "Control channel messages waiting to be parsed.");
+    out << "trunk_recorder_message_queue_depth{" << system_label << "} " << control_queue->count() << "\n";
+    metric_header(out, "trunk_recorder_message_queue_limit", "gauge", "Control channel messages the queue holds.");
+    out << "trunk_recorder_message_queue_limit{" << system_label << "} " << control_queue->limit() << "\n";
+    metric_header(out, "trunk_recorder_messages_dropped_total", "counter", "Control channel messages dropped because the queue was full.");
+    out << "trunk_recorder_messages_dropped_total{" << system_label << "} " << control_queue->drops() << "\n";
+    metric_header(out, "trunk_recorder_post_call_jobs_running", "gauge", "Post call scripts that have not finished.");
+    out << "trunk_recorder_post_call_jobs_running{" << system_label << "} " << post_call_jobs << "\n";
+
+    metric_header(out, "trunk_recorder_recorders", "gauge", "Recorders on each source.");
+    metric_header(out, "trunk_recorder_recorders_busy", "gauge", "Recorders on each source that are recording a call.");
+    metric_header(out, "trunk_recorder_recorder_active_seconds_total", "counter", "Time each recorder has spent recording calls.");
+    metric_header(out, "trunk_recorder_audio_dropped_samples_total", "counter", "Audio samples each recorder lost because the file writer fell behind.");
+    metric_header(out, "trunk_recorder_decode_frames_total", "counter", "P25 frames each recorder decoded.");
+    metric_header(out, "trunk_recorder_decode_sync_losses_total", "counter", "Times each recorder lost frame sync during a call.");
+    metric_header(out, "trunk_recorder_decode_voice_codewords_total", "counter", "IMBE codewords each recorder decoded.");
+    metric_header(out, "trunk_recorder_decode_voice_bit_errors_total", "counter", "Bit errors the vocoder found in those codewords.");
+    metric_header(out, "trunk_recorder_decode_mer_db", "gauge", "Modulation error ratio of the last call on each CQPSK recorder.");
+    metric_header(out, "trunk_recorder_frequency_correction_hz", "gauge", "Tuning error correction of each source.");
+    for (size_t i = 0; i < sources.size(); i++) {
+        Source *source = sources[i];
+        std::ostringstream source_label;
+        source_label << system_label << ",source=\"" << i << "\",center=\"" << source->get_center() << "\"";
+
+        for (int analog = 0; analog < 2; analog++) {
+            std::string labels = source_label.str() + (analog ? ",type=\"analog\"" : ",type=\"digital\"");
+            int total = analog ? source->get_num_analog_recorders() : source->get_num_digital_recorders();
+            int available = analog ? source->get_num_available_analog_recorders() : source->get_num_available_recorders();
+            out << "trunk_recorder_recorders{" << labels << "} " << total << "\n";
+            out << "trunk_recorder_recorders_busy{" << labels << "} " << total - available << "\n";
+
+            std::vector<Recorder *> recorders = source->get_recorders(analog);
+            for (size_t j = 0; j < recorders.size(); j++) {
+                std::ostringstream recorder_label;
+                recorder_label << labels << ",recorder=\"" << j << "\"";
+                out << "trunk_recorder_recorder_active_seconds_total{" << recorder_label.str() << "} " << recorders[j]->get_active_ms() / 1000.0 << "\n";
+                out << "trunk_recorder_audio_dropped_samples_total{" << recorder_label.str() << "} " << recorders[j]->get_audio_drops() << "\n";
+
+                DecodeTotals totals;
+                if (recorders[j]->get_decode_totals(totals)) {
+                    out << "trunk_recorder_decode_frames_total{" << recorder_label.str() << "} " << totals.frames << "\n";
+                    out << "trunk_recorder_decode_sync_losses_total{" << recorder_label.str() << "} " << totals.sync_losses << "\n";
+                    out << "trunk_recorder_decode_voice_codewords_total{" << recorder_label.str() << "} " << totals.voice_codewords << "\n";
+                    out << "trunk_recorder_decode_voice_bit_errors_total{" << recorder_label.str() << "} " << totals.voice_errors << "\n";
+                    if (totals.has_mer) {
+                        out << "trunk_recorder_decode_mer_db{" << recorder_label.str() << "} " << totals.last_mer << "\n";
+                    }
+                }
+            }
+        }
+        out << "trunk_recorder_frequency_correction_hz{" << source_label.str() << "} " << source->get_error() << "\n";
+    }
+    Metrics::set_gauges(out.str());
+}
+
+void log_priority_stats() {
+    for(std::map<int, PriorityStats>::iterator it = priority_stats.begin(); it != priority_stats.end(); it++) {
+        BOOST_LOG_TRIVIAL(info) << "\tPriority " << it->first << " - Recorded: " << it->second.recorded << "\tMissed: " << it->second.missed << "\tPreempted: " << it->second.preempted;
+    }
+}
+
 void start_recorder(Call *call) {
     Talkgroup * talkgroup = talkgroups->find_talkgroup(call->get_talkgroup());
-    bool source_found = false;
-    Recorder *recorder;
+    Recorder *recorder = NULL;
     Recorder *debug_recorder;
+    Source *source = NULL;
     call->set_recording(false); // start with the assumption that there are no recorders available.
     call->set_debug_recording(false);
 
     if (call->get_encrypted() == false) {
         //BOOST_LOG_TRIVIAL(error) << "\tCall created for: " << call->get_talkgroup() << "\tTDMA: " << call->get_tdma() <<  "\tEncrypted: " << call->get_encrypted();
+        bool analog = is_analog(call);
 
-        for(vector<Source *>::iterator it = sources.begin(); it != sources.end(); it++) {
-            Source * source = *it;
+        // every source that can hear the call, least busy first. Only
+        // one of them records it.
+        std::vector<Source *> covering = source_index->find_sources_by_load(call->get_freq(), analog);
 
-            if ((source->get_min_hz() <= call->get_freq()) && (source->get_max_hz() >= call->get_freq())) {
-                source_found = true;
-
-                 if (call->get_tdma()) {
-                    BOOST_LOG_TRIVIAL(error) << "\tTrying to record TDMA: " << call->get_freq() << " For TG: " << call->get_talkgroup();
-                 }
+        if (covering.empty()) {
+            BOOST_LOG_TRIVIAL(error) << "\tRecording not started because there was no source covering: " << call->get_freq() << " For TG: " << call->get_talkgroup();
+            Metrics::add(Metrics::CALLS_NO_SOURCE);
+            return;
+        }
 
-                if (talkgroup)
-                {
-                    if (talkgroup->mode == 'A') {
-                        recorder = source->get_analog_recorder(talkgroup->get_priority());
-                    } else {
-                        recorder = source->get_digital_recorder(talkgroup->get_priority());
-                    }
-                } else {
-                    BOOST_LOG_TRIVIAL(error) << "\tTalkgroup not found: " << call->get_freq() << " For TG: " << call->get_talkgroup();
+        if (call->get_tdma()) {
+            BOOST_LOG_TRIVIAL(error) << "\tTrying to record TDMA: " << call->get_freq() << " For TG: " << call->get_talkgroup();
+        }
 
-                    recorder = source->get_digital_recorder(2);
-                }
-                
-                int total_recorders = get_total_recorders();
-                if (recorder) {
-                    recorder->activate(call, total_recorders);
-                    call->set_recorder(recorder);
-                    call->set_recording(true);
-                } else {
-                    //BOOST_LOG_TRIVIAL(error) << "\tNot recording call";
-                }
+        if (!talkgroup) {
+            BOOST_LOG_TRIVIAL(error) << "\tTalkgroup not found: " << call->get_freq() << " For TG: " << call->get_talkgroup();
+        }
+        int priority = get_call_priority(call);
+        call->set_priority(priority);
 
-                debug_recorder = source->get_debug_recorder();
-                if (debug_recorder) {
-                    debug_recorder->activate(call, total_recorders );
-                    call->set_debug_recorder(debug_recorder);
-                    call->set_debug_recording(true);
-                } else {
-                    //BOOST_LOG_TRIVIAL(info) << "\tNot debug recording call";
-                }
+        for(vector<Source *>::iterator it = covering.begin(); !recorder && (it != covering.end()); it++) {
+            source = *it;
+            recorder = get_recorder(source, analog, priority);
+        }
 
+        // only preempt once no source has a recorder to spare
+        for(vector<Source *>::iterator it = covering.begin(); !recorder && (it != covering.end()); it++) {
+            source = *it;
+            if (preempt_recorder(source, analog, priority)) {
+                // priority 0 skips the headroom check, the recorder
+                // that was just freed is for this call
+                recorder = get_recorder(source, analog, 0);
             }
+        }
 
+        int total_recorders = get_total_recorders();
+        if (recorder) {
+            recorder->activate(call, total_recorders);
+            call->set_recorder(recorder);
+            call->set_recording(true);
+            priority_stats[priority].recorded++;
+            Metrics::add(Metrics::CALLS_RECORDED);
+        } else {
+            priority_stats[priority].missed++;
+            Metrics::add(Metrics::CALLS_NO_RECORDER);
+            source = covering.front();
         }
-        if (!source_found) {
-            BOOST_LOG_TRIVIAL(error) << "\tRecording not started because there was no source covering: " << call->get_freq() << " For TG: " << call->get_talkgroup();
+
+        debug_recorder = source->get_debug_recorder();
+        if (debug_recorder) {
+            debug_recorder->activate(call, total_recorders );
+            call->set_debug_recorder(debug_recorder);
+            call->set_debug_recording(true);
+        } else {
+            //BOOST_LOG_TRIVIAL(info) << "\tNot debug recording call";
         }
+    } else {
+        Metrics::add(Metrics::CALLS_ENCRYPTED);
     }
 }
 
@@ -305,7 +546,22 @@ void stop_inactive_recorders() {
 
     for(vector<Call *>::iterator it = calls.begin(); it != calls.end();) {
         Call *call = *it;
-        if ( call->since_last_update()  > 8.0) {
+        if (call->get_parked()) {
+            // the control channel has stopped granting it
+            if (call->since_last_update() > call_timeout) {
+                delete call;
+                it = calls.erase(it);
+            } else {
+                ++it;
+            }
+        } else if ((call->get_recording() == true) && (call->get_recorder()->since_end_of_voice() >= call_hang_time)) {
+            BOOST_LOG_TRIVIAL(trace) << "\tEnd of Transmission - TG: " << call->get_talkgroup() << "\tFreq: " << call->get_freq() << "\tElapsed: " << call->elapsed() << "ms";
+            call->park();
+            ++it;
+        } else if ((call->get_recording() == true) && (call->get_recorder()->waiting_for_voice() >= voice_timeout)) {
+            call->park();
+            ++it;
+        } else if ( call->since_last_update() > call_timeout) {
             call->end_call();
             delete call;
             it = calls.erase(it);
@@ -315,6 +571,15 @@ void stop_inactive_recorders() {
     }//foreach loggers
 }
 
+void end_all_calls() {
+    for(vector<Call *>::iterator it = calls.begin(); it != calls.end(); it++) {
+        Call *call = *it;
+        call->end_call();
+        delete call;
+    }
+    calls.clear();
+}
+
 
 
 void retune_recorder(TrunkMessage message, Call *call) {
@@ -322,7 +587,7 @@ void retune_recorder(TrunkMessage message, Call *call) {
     Recorder *recorder = call->get_recorder();
     Source *source = recorder->get_source();
 
-    BOOST_LOG_TRIVIAL(info) << "\tUpdate Retune - Elapsed: " << call->elapsed() << "s \tSince update: " << call->since_last_update() << "s \tTalkgroup: " << message.talkgroup << "\tOld Freq: " << call->get_freq() << "\tNew Freq: " << message.freq;
+    BOOST_LOG_TRIVIAL(info) << "\tUpdate Retune - Elapsed: " << call->elapsed() << "ms \tSince update: " << call->since_last_update() << "ms \tTalkgroup: " << message.talkgroup << "\tOld Freq: " << call->get_freq() << "\tNew Freq: " << message.freq;
     
     // set the call to the new Freq / TDMA slot
     call->set_freq(message.freq);
@@ -359,7 +624,15 @@ void assign_recorder(TrunkMessage message) {
         Call *call= *it;
 
         // Does the call have the same talkgroup
-        if (call->get_talkgroup() == message.talkgroup) {
+        if ((call->get_talkgroup() == message.talkgroup) && call->get_parked()) {
+
+            // a new grant for a call that has ended is a new call. If it
+            // is only a repeat of the last one, the recorder hears no
+            // voice and is freed after voiceTimeout.
+            delete call;
+            it = calls.erase(it);
+
+        } else if (call->get_talkgroup() == message.talkgroup) {
             
             // Is the freq the same?
             if (call->get_freq() != message.freq) {
@@ -398,7 +671,7 @@ void assign_recorder(TrunkMessage message) {
                 
                 // if you are recording the call, stop
                 if (call->get_recording() == true) {
-                    BOOST_LOG_TRIVIAL(info) << "\tFreq in use -  TG: " << message.talkgroup << "\tFreq: " << message.freq << "\tTDMA: " << message.tdma << "\t Ending Existing call\tTG: " << call->get_talkgroup() << "\tTMDA: " << call->get_tdma() << "\tElapsed: " << call->elapsed() << "s \tSince update: " << call->since_last_update();
+                    BOOST_LOG_TRIVIAL(info) << "\tFreq in use -  TG: " << message.talkgroup << "\tFreq: " << message.freq << "\tTDMA: " << message.tdma << "\t Ending Existing call\tTG: " << call->get_talkgroup() << "\tTMDA: " << call->get_tdma() << "\tElapsed: " << call->elapsed() << "ms \tSince update: " << call->since_last_update() << "ms";
                 //different talkgroups on the same freq, that is trouble
                 }
                 call->end_call();
@@ -412,6 +685,7 @@ void assign_recorder(TrunkMessage message) {
 
 
     if (!call_found) {
+        Metrics::add(Metrics::GRANTS);
         Call * call = new Call(message);
         start_recorder(call);
         calls.push_back(call);
@@ -538,52 +812,89 @@ void handle_message(std::vector<TrunkMessage>  messages) {
     }
 }
 
+// longest monitor_messages() waits for a control channel message before
+// it checks the recorders and the report timers anyway
+static const long MESSAGE_WAIT_MS = 500;
+
 void monitor_messages() {
-    gr::message::sptr msg;
+    trunk_msg msg;
     int messagesDecodedSinceLastReport = 0;
     float msgs_decoded_per_second = 0;
+    unsigned long lastQueueDrops = 0;
 
-    time_t lastMsgCountTime = time(NULL);;
-    time_t lastTalkgroupPurge = time(NULL);;
-    time_t currentTime = time(NULL);
+    int64_t lastMsgCountTime = monotonic_ms();
+    int64_t currentTime = lastMsgCountTime;
+    int64_t lastPriorityReportTime = lastMsgCountTime;
     std::vector<TrunkMessage> trunk_messages;
 
     while (1) {
         if(exit_flag) { // my action when signal set it 1
             printf("\n Signal caught!\n");
+            log_priority_stats();
+            source_index->log_utilization();
+            cpu_stats->log_utilization();
             return;
         }
 
 
-        msg = queue->delete_head();
-        messagesDecodedSinceLastReport++;
-        currentTime = time(NULL);
+        // with a timeout, so calls still end and the metrics are still
+        // published when the control channel goes quiet
+        bool received = control_queue->delete_head_timed(msg, MESSAGE_WAIT_MS);
+        currentTime = monotonic_ms();
 
+        // cheap enough to run on every message, which keeps the end of a
+        // call within one control channel message interval, or within
+        // MESSAGE_WAIT_MS without any
+        stop_inactive_recorders();
+        Call::start_post_call_jobs();
 
-        if ((currentTime - lastTalkgroupPurge) >= 1.0 )
-        {
-            stop_inactive_recorders();
-            lastTalkgroupPurge = currentTime;
-        }
+        if (received) {
+            messagesDecodedSinceLastReport++;
+            Metrics::add(Metrics::MESSAGES_DECODED);
 
-        if (system_type == "smartnet") {
-            trunk_messages = smartnet_parser->parse_message(msg->to_string());
-        } else if (system_type == "p25") {
-            trunk_messages = p25_parser->parse_message(msg);
-        }
-        else {
-            BOOST_LOG_TRIVIAL(error) << msg->to_string();
+            if (system_type == "smartnet") {
+                trunk_messages = smartnet_parser->parse_message(msg);
+            } else if (system_type == "p25") {
+                trunk_messages = p25_parser->parse_message(msg);
+                p25_trunking->sample_freq_error();
+            }
+            else {
+                BOOST_LOG_TRIVIAL(error) << "Unknown system type, message type " << msg.type;
+            }
+            for(vector<TrunkMessage>::iterator it = trunk_messages.begin(); it != trunk_messages.end(); it++) {
+                it->rx_time = msg.rx_time;
+            }
+            if (journal) {
+                journal->append(msg, trunk_messages);
+            }
+            handle_message(trunk_messages);
         }
-        handle_message(trunk_messages);
 
-        float timeDiff = currentTime - lastMsgCountTime;
+        float timeDiff = (currentTime - lastMsgCountTime) / 1000.0;
         if (timeDiff >= 3.0) {
+            double offset;
+            if ((system_type == "p25") && p25_trunking->get_freq_error(offset)) {
+                control_source->afc_update(offset, lastMsgCountTime);
+            }
             msgs_decoded_per_second = messagesDecodedSinceLastReport/timeDiff;
             messagesDecodedSinceLastReport = 0;
             lastMsgCountTime = currentTime;
             if (msgs_decoded_per_second < 10 ) {
                 BOOST_LOG_TRIVIAL(error) << "\tControl Channel Message Decode Rate: " << msgs_decoded_per_second << "/sec";
             }
+            unsigned long queueDrops = control_queue->drops();
+            if (queueDrops != lastQueueDrops) {
+                BOOST_LOG_TRIVIAL(error) << "\tControl Channel Message Queue Full, dropped " << queueDrops - lastQueueDrops << " messages";
+                lastQueueDrops = queueDrops;
+            }
+            publish_metrics(msgs_decoded_per_second, reap_background());
+        }
+
+        if ((currentTime - lastPriorityReportTime) >= 300000) {
+            log_priority_stats();
+            source_index->log_utilization();
+            cpu_stats->log_utilization();
+            lastPriorityReportTime = currentTime;
         }
 
 /*
@@ -592,50 +903,233 @@ void monitor_messages() {
             lastUnitCheckTime = currentTime;
         }
 */
-        msg.reset();
 
+    }
+}
 
 
+/*
+ * Runs call management on journaled messages as fast as they can be
+ * read, with the replayed messages' times as the clock. Sources get
+ * replay_recorders and nothing is written, see Call::dry_run.
+ */
+void replay_journals(const std::vector<std::string> &files) {
+    trunk_msg msg;
+    std::vector<TrunkMessage> trunk_messages;
+    unsigned long replayed = 0;
+    int64_t first_time = 0;
+    int64_t span = 0;    // control channel time replayed
+    int64_t run = 0;
+    int64_t start = monotonic_ms();
+
+    Call::dry_run = true;
+    for(std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); it++) {
+        JournalReader reader;
+        if (!reader.open(*it)) {
+            continue;
+        }
+        BOOST_LOG_TRIVIAL(info) << "Replaying " << *it;
+        if (reader.get_run_ms() != run) {
+            // the journal is from another run of the recorder, on a
+            // clock of its own; that run started without any calls
+            if (first_time) {
+                end_all_calls();
+                span += replay_time_ms - first_time;
+                first_time = 0;
+            }
+            run = reader.get_run_ms();
+        }
+        while (reader.next(msg, trunk_messages)) {
+            if (!first_time) {
+                first_time = msg.rx_time;
+            }
+            replay_time_ms = msg.rx_time;
+            replayed++;
+            Metrics::add(Metrics::MESSAGES_DECODED);
+
+            stop_inactive_recorders();
+            handle_message(trunk_messages);
+        }
+    }
+    end_all_calls();
+    if (first_time) {
+        span += replay_time_ms - first_time;
     }
+
+    int64_t took = monotonic_ms() - start;
+    BOOST_LOG_TRIVIAL(info) << "Replayed " << replayed << " messages, " << span / 1000.0 << " seconds of control channel in " << took << "ms (" << (took ? span / (double) took : 0) << "x real time)";
+    log_priority_stats();
+    source_index->log_utilization();
 }
 
+// comma separated numbers, empty if there are none
+std::vector<int64_t> parse_list(const std::string &list) {
+    std::vector<std::string> items;
+    std::vector<int64_t> values;
+    boost::split(items, list, boost::is_any_of(","), boost::token_compress_on);
+    for (size_t i = 0; i < items.size(); i++) {
+        if (!items[i].empty()) {
+            values.push_back(boost::lexical_cast<int64_t>(items[i]));
+        }
+    }
+    return values;
+}
 
-bool monitor_system() {
-    bool source_found = false;
-    Source * source = NULL;
-    double control_channel_freq = control_channels[current_control_channel];
+/*
+ * Runs the calls in history past recorder allocation again, for every
+ * combination of digital recorders per source and hang time. Only the
+ * grants and the ends of the calls are events, in time order, so a
+ * month of calls takes seconds. The sources are the ones in the
+ * config, with replay_recorders.
+ */
+void simulate_capacity(const CallHistory &history, std::vector<int64_t> recorder_counts, std::vector<int64_t> hang_times) {
+    const std::vector<HistoricalCall> &history_calls = history.get_calls();
+    std::vector<int> digital;
+    std::vector<int> analog;
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        digital.push_back(sources[i]->get_num_digital_recorders());
+        analog.push_back(sources[i]->get_num_analog_recorders());
+    }
+    if (recorder_counts.empty()) {
+        recorder_counts.push_back(-1);    // as configured
+    }
+    if (hang_times.empty()) {
+        hang_times.push_back(call_hang_time);
+    }
 
-    for(vector<Source *>::iterator it = sources.begin(); it != sources.end(); it++) {
-        source = *it;
+    Call::dry_run = true;
+    for (size_t r = 0; r < recorder_counts.size(); r++) {
+        for (size_t h = 0; h < hang_times.size(); h++) {
+            int64_t hang_time = hang_times[h];
+            int64_t start = monotonic_ms();
+            size_t peak_calls = 0;
+            int peak_busy = 0;
+            long no_source = 0;
+            // (end, call) of the calls still going, soonest first
+            std::priority_queue<std::pair<int64_t, Call *>, std::vector<std::pair<int64_t, Call *> >, std::greater<std::pair<int64_t, Call *> > > ends;
+
+            for (size_t i = 0; i < sources.size(); i++) {
+                sources[i]->create_replay_recorders(recorder_counts[r] < 0 ? digital[i] : recorder_counts[r], analog[i]);
+            }
+            priority_stats.clear();
+
+            // start_recorder() logs every call it can not record
+            boost::log::core::get()->set_logging_enabled(false);
+            for (size_t i = 0; i <= history_calls.size(); i++) {
+                int64_t next = (i < history_calls.size()) ? history_calls[i].start : std::numeric_limits<int64_t>::max();
+
+                while (!ends.empty() && (ends.top().first <= next)) {
+                    Call *call = ends.top().second;
+                    replay_time_ms = ends.top().first;
+                    ends.pop();
+                    call->end_call();
+                    calls.erase(std::find(calls.begin(), calls.end(), call));
+                    delete call;
+                }
+                if (i == history_calls.size()) {
+                    break;
+                }
 
-        if ((source->get_min_hz() <= control_channel_freq) && (source->get_max_hz() >= control_channel_freq)) {
-            source_found = true;
+                const HistoricalCall &past = history_calls[i];
+                TrunkMessage message;
+                message.message_type = GRANT;
+                message.freq = past.freq;
+                message.talkgroup = past.talkgroup;
+                message.encrypted = past.encrypted;
+                message.emergency = past.emergency;
+                message.tdma = past.tdma;
+                message.source = -1;
+                message.rx_time = past.start;
+                replay_time_ms = past.start;
+
+                Call *call = new Call(message);
+                if (!past.encrypted && source_index->find_sources(past.freq).empty()) {
+                    no_source++;
+                }
+                start_recorder(call);
+                calls.push_back(call);
+                ends.push(std::make_pair(std::max(past.end(hang_time), past.start), call));
+
+                peak_calls = std::max(peak_calls, calls.size());
+                int busy = 0;
+                for (size_t s = 0; s < sources.size(); s++) {
+                    busy += sources[s]->get_num_digital_recorders() - sources[s]->get_num_available_recorders();
+                }
+                peak_busy = std::max(peak_busy, busy);
+            }
+            boost::log::core::get()->set_logging_enabled(true);
 
-            break;
+            std::ostringstream recorders;
+            if (recorder_counts[r] < 0) {
+                recorders << "as configured";
+            } else {
+                recorders << recorder_counts[r] << " per source";
+            }
+            BOOST_LOG_TRIVIAL(info) << "Digital Recorders: " << recorders.str() << "	Hang Time: " << hang_time << "ms	Calls: " << history_calls.size() << "	Simulated in " << monotonic_ms() - start << "ms";
+            BOOST_LOG_TRIVIAL(info) << "	Peak Calls: " << peak_calls << "	Peak Busy Digital Recorders: " << peak_busy << "	No Source: " << no_source;
+            log_priority_stats();
         }
     }
+}
+
+bool monitor_system() {
+    double control_channel_freq = control_channels[current_control_channel];
+    Source * source = source_index->find_source(control_channel_freq);
+    bool source_found = (source != NULL);
+    control_source = source;
 
-    
     if (source_found) {
         
         if (system_type == "smartnet") {
             // what you really need to do is go through all of the sources to find the one with the right frequencies
-            smartnet_trunking = make_smartnet_trunking(control_channel_freq, source->get_center(), source->get_rate(),  queue);
+            smartnet_trunking = make_smartnet_trunking(control_channel_freq, source->get_center(), source->get_rate(),  control_queue);
+            if (control_channel_core >= 0) {
+                smartnet_trunking->set_processor_affinity(std::vector<int>(1, control_channel_core));
+            }
             tb->connect(source->get_src_block(),0, smartnet_trunking, 0);
         }
 
         if (system_type == "p25") {
             // what you really need to do is go through all of the sources to find the one with the right frequencies
-            p25_trunking = make_p25_trunking(control_channel_freq, source->get_center(), source->get_rate(),  queue, qpsk_mod);
+            p25_trunking = make_p25_trunking(control_channel_freq, source->get_center(), source->get_rate(),  control_queue, qpsk_mod);
+            if (control_channel_core >= 0) {
+                p25_trunking->set_processor_affinity(std::vector<int>(1, control_channel_core));
+            }
             tb->connect(source->get_src_block(),0, p25_trunking, 0);
         }
     }
     return source_found;
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
     BOOST_STATIC_ASSERT(true) __attribute__((unused));
+    namespace po = boost::program_options;
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "show this help")
+        ("config", po::value<std::string>(&config_file), "config file, config.json by default")
+        ("replay", po::value<std::vector<std::string> >()->multitoken(), "run call management on journal files instead of recording")
+        ("extract", po::value<std::string>(), "write the recording of a call in the archive to a .wav file")
+        ("output,o", po::value<std::string>(), "with --extract, the file to write, - for stdout; the call's file name by default")
+        ("simulate", po::value<std::vector<std::string> >()->multitoken(), "simulate recorder allocation for the calls in journals or call .json files, or directories of them")
+        ("recorders", po::value<std::string>()->default_value(""), "with --simulate, digital recorders per source to try, e.g. 4,6,8")
+        ("hang-time", po::value<std::string>()->default_value(""), "with --simulate, hang times in ms to try");
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        po::notify(vm);
+    } catch (po::error &e) {
+        std::cerr << e.what() << std::endl << options;
+        return 1;
+    }
+    if (vm.count("help")) {
+        std::cout << options;
+        return 0;
+    }
+    replay_mode = (vm.count("replay") > 0) || (vm.count("simulate") > 0) || (vm.count("extract") > 0);
+
     signal(SIGINT, exit_interupt);
     logging::core::get()->set_filter
     (
@@ -643,12 +1137,52 @@ int main(void)
      );
 
     tb = gr::make_top_block("Trunking");
-    queue = gr::msg_queue::make(100);
+    control_queue = trunk_msg_queue::make(100);
     smartnet_parser = new SmartnetParser(); // this has to eventually be generic;
     p25_parser = new P25Parser();
+    cpu_stats = new CpuStats();
+    int64_t startup_time = monotonic_ms();
 
     load_config();
+    if (vm.count("extract")) {
+        std::string name = vm["extract"].as<std::string>();
+        std::string output = vm.count("output") ? vm["output"].as<std::string>() : boost::filesystem::path(name).filename().string();
+        if (archive_dir.empty()) {
+            std::cerr << "archiveDir is not set in " << config_file << std::endl;
+            return 1;
+        }
+        return CallArchive::extract(archive_dir, name, output) ? 0 : 1;
+    }
+    Metrics::set_system(system_type);
+    if ((metrics_port > 0) && !replay_mode) {
+        Metrics::start_server(metrics_address, metrics_port);
+    }
+    if (!journal_dir.empty() && !replay_mode) {
+        journal = new JournalWriter(journal_dir);
+    }
+    if (!archive_dir.empty() && !replay_mode) {
+        gr::blocks::nonstop_wavfile_sink::set_archive(new CallArchive(archive_dir));
+    }
+    if (!call_index_file.empty() && !replay_mode) {
+#ifdef HAVE_SQLITE3
+        Call::index = new CallIndex();
+        if (!Call::index->open(call_index_file)) {
+            delete Call::index;
+            Call::index = NULL;
+        }
+#else
+        BOOST_LOG_TRIVIAL(error) << "callIndex is set, but this recorder was built without SQLite; calls will not be indexed, their .json files are written instead";
+        Call::write_json = true;
+#endif
+    }
+    if (system_type == "p25") {
+        p25_parser->load_state(p25_state_file);
+    }
 
+    source_index = new SourceIndex();
+    for(vector<Source *>::iterator it = sources.begin(); it != sources.end(); it++) {
+        source_index->add_source(*it);
+    }
 
 
     // Setup the talkgroups from the CSV file
@@ -658,8 +1192,27 @@ int main(void)
     talkgroups->load_talkgroups(talkgroups_file);
     //}
 
+    if (vm.count("simulate")) {
+        CallHistory history(call_timeout);
+        history.load(vm["simulate"].as<std::vector<std::string> >());
+        BOOST_LOG_TRIVIAL(info) << "Simulating " << history.get_span() / 86400000.0 << " days of calls";
+        try {
+            simulate_capacity(history, parse_list(vm["recorders"].as<std::string>()), parse_list(vm["hang-time"].as<std::string>()));
+        } catch (boost::bad_lexical_cast &e) {
+            std::cerr << "--recorders and --hang-time take comma separated numbers" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (replay_mode) {
+        replay_journals(vm["replay"].as<std::vector<std::string> >());
+        return 0;
+    }
+
     if (monitor_system()) {
         tb->start();
+        BOOST_LOG_TRIVIAL(info) << "Startup took " << monotonic_ms() - startup_time << "ms";
+        publish_metrics(0, 0);
         monitor_messages();
         //------------------------------------------------------------------
         //-- stop flow graph execution
@@ -667,6 +1220,14 @@ int main(void)
         BOOST_LOG_TRIVIAL(info) << "stopping flow graph";
         tb->stop();
         tb->wait();
+        Metrics::stop_server();
+        // stopping the sinks finished the files of the calls that ended
+        Call::start_post_call_jobs();
+#ifdef HAVE_SQLITE3
+        if (Call::index) {
+            Call::index->close();
+        }
+#endif
     } else {
         BOOST_LOG_TRIVIAL(info) << "Unable to setup Control Channel Monitor"<< std::endl;
     }
@@ -0,0 +1,190 @@
+#include "metrics.h"
+#include <sstream>
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <boost/bind.hpp>
+#include <boost/log/trivial.hpp>
+
+volatile uint64_t Metrics::counters[Metrics::NUM_COUNTERS];
+gr::thread::mutex Metrics::gauge_mutex;
+std::string Metrics::gauges;
+std::string Metrics::system_label;
+int Metrics::server_fd = -1;
+
+// longest wait between tries while accept() keeps failing, e.g. with
+// the process out of file descriptors
+static const useconds_t ACCEPT_BACKOFF_MAX_US = 1000000;
+
+struct CounterInfo {
+	const char *name;
+	const char *labels;
+	const char *help;
+};
+
+// grouped by name, the HELP and TYPE lines go before the first of each
+static const CounterInfo counter_info[Metrics::NUM_COUNTERS] = {
+	{ "trunk_recorder_messages_decoded_total", "", "Control channel messages decoded." },
+	{ "trunk_recorder_grants_total", "", "Channel grants for talkgroups that were not already on a channel." },
+	{ "trunk_recorder_calls_total", ",result=\"recorded\"", "Calls, by whether they were recorded or why not." },
+	{ "trunk_recorder_calls_total", ",result=\"no_recorder\"", "" },
+	{ "trunk_recorder_calls_total", ",result=\"no_source\"", "" },
+	{ "trunk_recorder_calls_total", ",result=\"encrypted\"", "" },
+	{ "trunk_recorder_calls_preempted_total", "", "Calls that lost their recorder to a higher priority call." },
+	{ "trunk_recorder_calls_no_voice_total", "", "Recorded calls that ended without any voice being heard." },
+	{ "trunk_recorder_file_write_seconds_count", "", "Time the recorders spent writing audio files." },
+	{ "trunk_recorder_file_write_seconds_sum", "", "" },
+	{ "trunk_recorder_post_call_jobs_total", "", "Post call scripts started." }
+};
+
+void Metrics::set_system(const std::string &type) {
+	gr::thread::scoped_lock guard(gauge_mutex);
+	system_label = "system=\"" + type + "\"";
+}
+
+void Metrics::set_gauges(const std::string &text) {
+	gr::thread::scoped_lock guard(gauge_mutex);
+	gauges = text;
+}
+
+std::string Metrics::render() {
+	std::ostringstream out;
+	std::string labels;
+	{
+		gr::thread::scoped_lock guard(gauge_mutex);
+		out << gauges;
+		labels = system_label;
+	}
+
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		const CounterInfo &info = counter_info[i];
+		if (info.help[0]) {
+			const char *type = strstr(info.name, "_seconds_") ? "summary" : "counter";
+			std::string base(info.name);
+			if (strcmp(type, "summary") == 0) {
+				base = base.substr(0, base.rfind('_'));
+			}
+			out << "# HELP " << base << " " << info.help << "\n";
+			out << "# TYPE " << base << " " << type << "\n";
+		}
+		out << info.name << "{" << labels << info.labels << "} ";
+		if (i == FILE_WRITE_US) {
+			out << get(FILE_WRITE_US) / 1000000.0 << "\n";
+		} else {
+			out << get((Counter) i) << "\n";
+		}
+	}
+	return out.str();
+}
+
+bool Metrics::start_server(const std::string &address, int port) {
+	// not inherited by the post call scripts
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		BOOST_LOG_TRIVIAL(error) << "Metrics: unable to create socket: " << strerror(errno);
+		return false;
+	}
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (!inet_aton(address.c_str(), &addr.sin_addr)) {
+		BOOST_LOG_TRIVIAL(error) << "Metrics: bad address " << address;
+		close(fd);
+		return false;
+	}
+	if ((bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) || (listen(fd, 8) < 0)) {
+		BOOST_LOG_TRIVIAL(error) << "Metrics: unable to listen on " << address << ":" << port << ": " << strerror(errno);
+		close(fd);
+		return false;
+	}
+
+	server_fd = fd;
+	gr::thread::thread server(boost::bind(&Metrics::serve, fd));
+	server.detach();
+	BOOST_LOG_TRIVIAL(info) << "Metrics: http://" << address << ":" << port << "/metrics";
+	return true;
+}
+
+void Metrics::stop_server() {
+	if (server_fd >= 0) {
+		// wakes the accept() the server thread is blocked in
+		shutdown(server_fd, SHUT_RDWR);
+		server_fd = -1;
+	}
+}
+
+void Metrics::serve(int fd) {
+	// a client that never sends its request can not hold up the next one
+	struct timeval timeout;
+	timeout.tv_sec = 1;
+	timeout.tv_usec = 0;
+	useconds_t backoff = 0;
+
+	while (1) {
+		int client = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+		if (client < 0) {
+			if ((errno == EINTR) || (errno == ECONNABORTED)) {
+				continue;
+			}
+			if ((errno == EINVAL) || (errno == EBADF) || (errno == ENOTSOCK)) {
+				// stop_server()
+				break;
+			}
+			if (!backoff) {
+				BOOST_LOG_TRIVIAL(error) << "Metrics: unable to accept a connection: " << strerror(errno);
+				backoff = 10000;
+			} else {
+				backoff = std::min(backoff * 2, ACCEPT_BACKOFF_MAX_US);
+			}
+			usleep(backoff);
+			continue;
+		}
+		if (backoff) {
+			BOOST_LOG_TRIVIAL(info) << "Metrics: accepting connections again";
+			backoff = 0;
+		}
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		char request[1024];
+		ssize_t n = recv(client, request, sizeof(request) - 1, 0);
+		request[n > 0 ? n : 0] = '\0';
+
+		std::string status = "200 OK";
+		std::string body;
+		if (strncmp(request, "GET /metrics", 12) == 0) {
+			body = render();
+		} else {
+			status = "404 Not Found";
+			body = "Not Found\n";
+		}
+
+		std::ostringstream response;
+		response << "HTTP/1.0 " << status << "\r\n"
+			<< "Content-Type: text/plain; version=0.0.4\r\n"
+			<< "Content-Length: " << body.size() << "\r\n"
+			<< "Connection: close\r\n\r\n" << body;
+		std::string text = response.str();
+		const char *p = text.data();
+		size_t left = text.size();
+		while (left > 0) {
+			ssize_t sent = send(client, p, left, MSG_NOSIGNAL);
+			if (sent <= 0) {
+				break;
+			}
+			p += sent;
+			left -= sent;
+		}
+		close(client);
+	}
+	close(fd);
+}
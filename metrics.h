@@ -0,0 +1,67 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <string>
+#include <gnuradio/thread/thread.h>
+
+/*
+ * Runtime health served over HTTP in the Prometheus text format.
+ *
+ * Counters are bumped with atomic adds from any thread, the DSP
+ * threads included, and never take a lock. Values that have to be
+ * read off the sources, recorders and message queue are gathered by
+ * the main loop, which owns them, and handed over as text with
+ * set_gauges(). A scrape only copies that text and reads the
+ * counters, so it never touches the flow graph.
+ */
+class Metrics {
+public:
+	enum Counter {
+		MESSAGES_DECODED,
+		GRANTS,
+		CALLS_RECORDED,
+		CALLS_NO_RECORDER,
+		CALLS_NO_SOURCE,
+		CALLS_ENCRYPTED,
+		CALLS_PREEMPTED,
+		CALLS_NO_VOICE,
+		FILE_WRITES,
+		FILE_WRITE_US,   // microseconds spent in FILE_WRITES
+		POST_CALL_JOBS,
+		NUM_COUNTERS
+	};
+
+	static void add(Counter c, uint64_t n = 1) {
+		__sync_fetch_and_add(&counters[c], n);
+	}
+
+	static uint64_t get(Counter c) {
+		return __sync_fetch_and_add(&counters[c], 0);
+	}
+
+	// labels every metric with the trunking system type
+	static void set_system(const std::string &type);
+
+	// replaces the gauge lines, already in Prometheus text format
+	static void set_gauges(const std::string &text);
+
+	// everything, in Prometheus text format
+	static std::string render();
+
+	// serves render() at http://address:port/metrics from a thread of its own
+	static bool start_server(const std::string &address, int port);
+
+	// shuts the listening socket, the server thread then ends
+	static void stop_server();
+
+private:
+	static volatile uint64_t counters[NUM_COUNTERS];
+	static gr::thread::mutex gauge_mutex;
+	static std::string gauges;
+	static std::string system_label;
+	static int server_fd;
+	static void serve(int fd);
+};
+
+#endif
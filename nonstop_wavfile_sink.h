@@ -25,6 +25,10 @@
 
 #include <gnuradio/blocks/api.h>
 #include <gnuradio/sync_block.h>
+#include <string>
+#include <vector>
+
+class CallArchive;
 
 namespace gr {
 namespace blocks {
@@ -44,7 +48,8 @@ public:
 	typedef boost::shared_ptr<nonstop_wavfile_sink> sptr;
 
 	/*
-	 * \param filename The .wav file to be opened
+	 * \param filename The .wav file to be opened, or NULL to start
+	 *        with no file and drop samples until open() is called
 	 * \param n_channels Number of channels (2 = stereo or I/Q output)
 	 * \param sample_rate Sample rate [S/s]
 	 * \param bits_per_sample 16 or 8 bit, default is 16
@@ -55,16 +60,50 @@ public:
 	                 int bits_per_sample = 16);
 
 	/*!
-	 * \brief Opens a new file and writes a WAV header. Thread-safe.
+	 * \brief Opens a new file and writes a WAV header. A file already
+	 * there under that name is replaced. Thread-safe.
 	 */
 	virtual bool open(const char* filename) = 0;
 
 	/*!
-	 * \brief Closes the currently active file and completes the WAV
-	 * header. Thread-safe.
+	 * \brief Opens a new file that takes over at the first sample
+	 * tagged with activation epoch \p epoch (see
+	 * gr::op25_repeater::epoch_tag_key()). Samples ahead of it belong
+	 * to the previous file, or are dropped if that was closed. If the
+	 * tag has not shown up after a second of samples the new file
+	 * takes over anyway. Thread-safe.
+	 */
+	virtual bool open(const char* filename, long epoch) = 0;
+
+	/*!
+	 * \brief Closes the currently active file once the samples still
+	 * in the chain ahead of the sink have been written to it. Until
+	 * then the file keeps taking samples. It is completed at the epoch
+	 * tag of the next open(), when no samples have come for
+	 * DRAIN_IDLE_MS, or DRAIN_MAX_MS after close() at the latest; see
+	 * finish_drained(). Thread-safe.
 	 */
 	virtual void close() = 0;
 
+	/*!
+	 * \brief Drops the file of the last open() instead of closing it,
+	 * for a call with nothing in it. It is not added to the archive,
+	 * or it is removed from disk. A file before it that is still
+	 * draining is finished as usual. Thread-safe.
+	 */
+	virtual void discard() = 0;
+
+	static const int64_t DRAIN_IDLE_MS = 250;
+	static const int64_t DRAIN_MAX_MS = 2000;
+
+	/*!
+	 * \brief Completes the files of every sink that have finished
+	 * draining, and appends the names of all the files completed since
+	 * the last call to \p closed. Call it regularly, a sink that gets
+	 * no more samples can not tell on its own.
+	 */
+	static void finish_drained(std::vector<std::string> &closed);
+
 	/*!
 	 * \brief Set the sample rate. This will not affect the WAV file
 	 * currently opened. Any following open() calls will use this new
@@ -81,6 +120,15 @@ public:
 	virtual void set_bits_per_sample(int bits_per_sample) = 0;
 
 	virtual float length_in_seconds() = 0;
+
+	/*!
+	 * \brief Keep the files in \p archive instead of on disk, for
+	 * every sink. A file is then built in memory and added to the
+	 * archive, under its file name, when it is closed. NULL, the
+	 * default, writes .wav files.
+	 */
+	static void set_archive(CallArchive *archive);
+	static CallArchive *get_archive();
 };
 
 } /* namespace blocks */
@@ -27,14 +27,22 @@
 #include "nonstop_wavfile_sink_impl.h"
 #include "nonstop_wavfile_sink.h"
 #include <gnuradio/io_signature.h>
+#include <op25_repeater/epoch_tag.h>
+#include "metrics.h"
+#include "call_archive.h"
+#include "timestamp.h"
 #include <stdexcept>
 #include <climits>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <cerrno>
 #include <fcntl.h>
+#include <unistd.h>
 #include <gnuradio/thread/thread.h>
 #include <boost/math/special_functions/round.hpp>
 #include <stdio.h>
+#include <set>
 
 // win32 (mingw/msvc) specific
 #ifdef HAVE_IO_H
@@ -56,6 +64,54 @@
 namespace gr {
 namespace blocks {
 
+static CallArchive *s_archive = NULL;
+
+// every sink, for finish_drained()
+static std::set<nonstop_wavfile_sink_impl *> s_sinks;
+static boost::mutex s_sinks_mutex;
+// files completed since the last finish_drained(); s_closed_mutex is
+// taken with a sink's d_mutex held, never the other way round
+static std::vector<std::string> s_closed;
+static boost::mutex s_closed_mutex;
+
+// as written by wavheader_write()
+static const size_t WAV_HEADER_SIZE = 44;
+
+static void put_le32(char *p, uint32_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+void
+nonstop_wavfile_sink::set_archive(CallArchive *archive)
+{
+	s_archive = archive;
+}
+
+CallArchive *
+nonstop_wavfile_sink::get_archive()
+{
+	return s_archive;
+}
+
+void
+nonstop_wavfile_sink::finish_drained(std::vector<std::string> &closed)
+{
+	int64_t now = monotonic_ms();
+	{
+		gr::thread::scoped_lock sinks_guard(s_sinks_mutex);
+		for(std::set<nonstop_wavfile_sink_impl *>::iterator it = s_sinks.begin(); it != s_sinks.end(); it++) {
+			(*it)->finish_if_drained(now);
+		}
+	}
+	gr::thread::scoped_lock guard(s_closed_mutex);
+	closed.insert(closed.end(), s_closed.begin(), s_closed.end());
+	s_closed.clear();
+}
+
 nonstop_wavfile_sink::sptr
 nonstop_wavfile_sink::make(const char *filename,
                            int n_channels,
@@ -75,7 +131,10 @@ nonstop_wavfile_sink_impl::nonstop_wavfile_sink_impl(const char *filename,
 	             io_signature::make(1, n_channels, sizeof(float)),
 	             io_signature::make(0, 0, 0)),
 	  d_sample_rate(sample_rate), d_nchans(n_channels),
-	  d_fp(0), d_new_fp(0), d_updated(false)
+	  d_sample_count(0), d_fp(0), d_new_fp(0),
+	  d_mem(0), d_new_mem(0), d_updated(false),
+	  d_draining(false), d_close_time(0), d_sample_time(0),
+	  d_new_epoch(-1), d_epoch_wait(0)
 {
 	if(bits_per_sample != 8 && bits_per_sample != 16) {
 		throw std::runtime_error("Invalid bits per sample (supports 8 and 16)");
@@ -83,7 +142,7 @@ nonstop_wavfile_sink_impl::nonstop_wavfile_sink_impl(const char *filename,
 	d_bytes_per_sample = bits_per_sample / 8;
 	d_bytes_per_sample_new = d_bytes_per_sample;
 
-	if(!open(filename)) {
+	if(filename && !open(filename)) {
 		throw std::runtime_error("can't open file");
 	}
 
@@ -102,68 +161,82 @@ nonstop_wavfile_sink_impl::nonstop_wavfile_sink_impl(const char *filename,
 			fprintf(stderr, "Invalid bits per sample value requested, using 16");
 		}
 	}
+
+	gr::thread::scoped_lock guard(s_sinks_mutex);
+	s_sinks.insert(this);
 }
 
 bool
 nonstop_wavfile_sink_impl::open(const char* filename)
 {
-    int d_first_sample_pos;
-    unsigned d_samples_per_chan;
 	gr::thread::scoped_lock guard(d_mutex);
+	return open_file(filename, -1);
+}
 
-    
-    
-	// we use the open system call to get access to the O_LARGEFILE flag.  O_APPEND|
-	int fd;
-	if((fd = ::open(filename,
-	                O_RDWR|O_CREAT|OUR_O_LARGEFILE|OUR_O_BINARY,
-	                0664)) < 0) {
-		perror(filename);
-		return false;
-	}
-    
+bool
+nonstop_wavfile_sink_impl::open(const char* filename, long epoch)
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	return open_file(filename, epoch);
+}
+
+bool
+nonstop_wavfile_sink_impl::open_file(const char* filename, long epoch)
+{
 	if(d_new_fp) {    // if we've already got a new one open, close it
-		fclose(d_new_fp);
-		d_new_fp = 0;
+		discard_new();
 	}
 
-	if((d_new_fp = fdopen (fd, "rb+")) == NULL) {
-		perror(filename);
-		::close(fd);  // don't leak file descriptor if fdopen fails.
-		return false;
+	if(s_archive) {
+		// the whole file is kept until it is closed, then it is
+		// archived in one write
+		d_new_mem = new memory_file();
+		d_new_mem->buf = NULL;
+		d_new_mem->size = 0;
+		d_new_mem->name = filename;
+		if((d_new_fp = open_memstream(&d_new_mem->buf, &d_new_mem->size)) == NULL) {
+			perror(filename);
+			delete d_new_mem;
+			d_new_mem = NULL;
+			return false;
+		}
 	}
-	d_updated = true;
-
-
-      // Scan headers, check file validity
-      if(wavheader_parse(d_new_fp,
-			  d_sample_rate,
-			  d_nchans,
-			  d_bytes_per_sample,
-			  d_first_sample_pos,
-			  d_samples_per_chan)) {
-	     
-
-          d_sample_count = d_samples_per_chan * d_nchans;
-          //fprintf(stderr, "Sample Count: %d\n", d_sample_count);
-          fseek(d_new_fp, 0, SEEK_END);
-      } else {
-          	d_sample_count = 0;
-          // you have to rewind the d_new_fp because the read failed.
-          if (fseek(d_new_fp, 0, SEEK_SET) != 0) {
-		      return false;
-	       }  
-          
-          	if(!wavheader_write(d_new_fp,
+	else {
+		// we use the open system call to get access to the O_LARGEFILE flag.
+		// A file left from an earlier call of the same name is replaced,
+		// its post call script may still be reading it.
+		int fd;
+		if(unlink(filename) < 0 && errno != ENOENT) {
+			perror(filename);
+			return false;
+		}
+		if((fd = ::open(filename,
+		                O_WRONLY|O_CREAT|O_TRUNC|OUR_O_LARGEFILE|OUR_O_BINARY,
+		                0664)) < 0) {
+			perror(filename);
+			return false;
+		}
+
+		if((d_new_fp = fdopen (fd, "wb")) == NULL) {
+			perror(filename);
+			::close(fd);  // don't leak file descriptor if fdopen fails.
+			return false;
+		}
+	}
+	// without an epoch the file is installed by the next work() call,
+	// with one work() installs it at the tagged sample
+	d_updated = (epoch < 0);
+	d_new_epoch = epoch;
+	d_epoch_wait = 0;
+	d_new_name = filename;
+
+	if(!wavheader_write(d_new_fp,
 	                    d_sample_rate,
 	                    d_nchans,
 	                    d_bytes_per_sample_new)) {
-		      fprintf(stderr, "[%s] could not write to WAV file\n", __FILE__);
-		      exit(-1);
-	       }
-      }
-    
-
+		fprintf(stderr, "[%s] could not write to WAV file\n", __FILE__);
+		exit(-1);
+	}
 
 	return true;
 }
@@ -173,10 +246,63 @@ nonstop_wavfile_sink_impl::close()
 {
 	gr::thread::scoped_lock guard(d_mutex);
 
+	// the end of the call is still in the blocks ahead of the sink, the
+	// file keeps taking samples until they have come through
+	if(!d_fp || d_draining)
+		return;
+
+	d_draining = true;
+	d_close_time = monotonic_ms();
+}
+
+void
+nonstop_wavfile_sink_impl::discard()
+{
+	gr::thread::scoped_lock guard(d_mutex);
+
+	// still waiting for its epoch tag, the file in use is another call's
+	if(d_new_fp) {
+		if(!d_new_mem) {
+			unlink(d_new_name.c_str());
+		}
+		discard_new();
+		d_updated = false;
+		d_new_epoch = -1;
+		return;
+	}
 	if(!d_fp)
 		return;
 
-	close_wav();
+	fclose(d_fp);
+	if(d_mem) {
+		free(d_mem->buf);
+		delete d_mem;
+		d_mem = NULL;
+	}
+	else {
+		unlink(d_name.c_str());
+	}
+	d_fp = NULL;
+	d_draining = false;
+}
+
+void
+nonstop_wavfile_sink_impl::finish_if_drained(int64_t now)
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	check_drained(now);
+}
+
+void
+nonstop_wavfile_sink_impl::check_drained(int64_t now)
+{
+	if(!d_fp || !d_draining)
+		return;
+
+	int64_t last = std::max(d_close_time, d_sample_time);
+	if(now - last >= DRAIN_IDLE_MS || now - d_close_time >= DRAIN_MAX_MS) {
+		close_wav();
+	}
 }
 
 void
@@ -184,25 +310,66 @@ nonstop_wavfile_sink_impl::close_wav()
 {
 	unsigned int byte_count = d_sample_count * d_bytes_per_sample;
 
-	wavheader_complete(d_fp, byte_count);
-
-	fclose(d_fp);
+	if(d_mem) {
+		// writing into the header would cut a memory stream short at
+		// the header, so the sizes are filled into its buffer instead,
+		// where wavheader_complete() puts them
+		fclose(d_fp);
+		if(d_mem->size >= WAV_HEADER_SIZE) {
+			put_le32(d_mem->buf + 4, byte_count + WAV_HEADER_SIZE - 8);
+			put_le32(d_mem->buf + 40, byte_count);
+		}
+		s_archive->append(d_mem->name, d_mem->buf, d_mem->size);
+		free(d_mem->buf);
+		delete d_mem;
+		d_mem = NULL;
+	}
+	else {
+		wavheader_complete(d_fp, byte_count);
+		fclose(d_fp);
+	}
 	d_fp = NULL;
+	d_draining = false;
+
+	gr::thread::scoped_lock guard(s_closed_mutex);
+	s_closed.push_back(d_name);
+}
+
+void
+nonstop_wavfile_sink_impl::discard_new()
+{
+	fclose(d_new_fp);
+	d_new_fp = 0;
+	if(d_new_mem) {
+		free(d_new_mem->buf);
+		delete d_new_mem;
+		d_new_mem = NULL;
+	}
 }
 
 nonstop_wavfile_sink_impl::~nonstop_wavfile_sink_impl()
 {
-	if(d_new_fp) {
-		fclose(d_new_fp);
-		d_new_fp = NULL;
+	{
+		gr::thread::scoped_lock guard(s_sinks_mutex);
+		s_sinks.erase(this);
 	}
 
-	close();
+	gr::thread::scoped_lock guard(d_mutex);
+	if(d_new_fp) {
+		discard_new();
+	}
+	if(d_fp) {
+		close_wav();
+	}
 }
 
 bool nonstop_wavfile_sink_impl::stop()
 {
-
+	// nothing more is coming through, a closed file is complete
+	gr::thread::scoped_lock guard(d_mutex);
+	if(d_fp && d_draining) {
+		close_wav();
+	}
 
 	return true;
 }
@@ -214,17 +381,60 @@ nonstop_wavfile_sink_impl::work(int noutput_items,
 {
 	float **in = (float**)&input_items[0];
 	int n_in_chans = input_items.size();
-
-	short int sample_buf_s;
-
-	int nwritten;
+	int start = 0;
 
 	gr::thread::scoped_lock guard(d_mutex);    // hold mutex for duration of this block
+	int64_t write_start = monotonic_us();
 	do_update();      // update: d_fp is reqd
+	check_drained(write_start / 1000);
+	d_sample_time = write_start / 1000;
+
+	if(d_new_fp && d_new_epoch >= 0) {
+		std::vector<tag_t> tags;
+		get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + noutput_items, gr::op25_repeater::epoch_tag_key());
+
+		int end = -1;
+		for(size_t t = 0; t < tags.size(); t++) {
+			if(pmt::to_long(tags[t].value) == d_new_epoch) {
+				end = tags[t].offset - nitems_read(0);
+				break;
+			}
+		}
+		// don't hold the new file back forever if the tag got lost
+		if(end < 0 && d_epoch_wait + noutput_items >= d_sample_rate)
+			end = 0;
+		d_epoch_wait += noutput_items;
+
+		if(end >= 0) {
+			write_samples(in, n_in_chans, 0, end);
+			d_updated = true;
+			d_new_epoch = -1;
+			do_update();
+			start = end;
+		}
+	}
+
+	write_samples(in, n_in_chans, start, noutput_items);
+
+	if(d_fp) {
+		Metrics::add(Metrics::FILE_WRITES);
+		Metrics::add(Metrics::FILE_WRITE_US, monotonic_us() - write_start);
+	}
+
+   // fflush (d_fp);  // this is added so unbuffered content is written.
+    
+	return noutput_items;
+}
+
+void
+nonstop_wavfile_sink_impl::write_samples(float **in, int n_in_chans, int start, int end)
+{
+	short int sample_buf_s;
+
 	if(!d_fp)         // drop output on the floor
-		return noutput_items;
+		return;
 
-	for(nwritten = 0; nwritten < noutput_items; nwritten++) {
+	for(int nwritten = start; nwritten < end; nwritten++) {
 		for(int chan = 0; chan < d_nchans; chan++) {
 			// Write zeros to channels which are in the WAV file
 			// but don't have any inputs here
@@ -240,16 +450,12 @@ nonstop_wavfile_sink_impl::work(int noutput_items,
 
 			if(feof(d_fp) || ferror(d_fp)) {
 				fprintf(stderr, "[%s] file i/o error\n", __FILE__);
-				close();
+				close_wav();	// d_mutex is already held
 				exit(-1);
 			}
 			d_sample_count++;
 		}
 	}
-
-   // fflush (d_fp);  // this is added so unbuffered content is written.
-    
-	return nwritten;
 }
 
 short int
@@ -314,6 +520,10 @@ nonstop_wavfile_sink_impl::do_update()
 
 	d_fp = d_new_fp;                    // install new file pointer
 	d_new_fp  = 0;
+	d_mem = d_new_mem;
+	d_new_mem = NULL;
+	d_name = d_new_name;
+	d_sample_count = 0;
 
 	d_bytes_per_sample = d_bytes_per_sample_new;
 
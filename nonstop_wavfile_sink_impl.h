@@ -25,6 +25,7 @@
 
 #include "nonstop_wavfile_sink.h"
 #include <gnuradio/blocks/wavfile.h>
+#include <string>
 
 namespace gr {
 namespace blocks {
@@ -44,7 +45,23 @@ private:
 
 	FILE *d_fp;
 	FILE *d_new_fp;
+	// with an archive the files are memory streams, written to the
+	// archive when they are closed; NULL for files on disk
+	struct memory_file {
+		char *buf;          // updated by the stream on fflush()/fclose()
+		size_t size;
+		std::string name;
+	};
+	memory_file *d_mem;
+	memory_file *d_new_mem;
 	bool d_updated;
+	std::string d_name;         // of d_fp
+	std::string d_new_name;     // of d_new_fp
+	bool d_draining;            // close() was called, d_fp is finishing
+	int64_t d_close_time;       // monotonic_ms() of the close()
+	int64_t d_sample_time;      // monotonic_ms() of the last samples in
+	long d_new_epoch;           // epoch tag d_new_fp waits for, -1 if none
+	unsigned d_epoch_wait;      // samples seen while waiting for it
 	boost::mutex d_mutex;
 
 	/*!
@@ -68,6 +85,13 @@ private:
 	 */
 	void close_wav();
 
+	// finish d_fp if it has drained, d_mutex must be held
+	void check_drained(int64_t now);
+
+	bool open_file(const char* filename, long epoch);
+	void discard_new();
+	void write_samples(float **in, int n_in_chans, int start, int end);
+
 protected:
 	bool stop();
 
@@ -79,7 +103,12 @@ public:
 	~nonstop_wavfile_sink_impl();
 
 	bool open(const char* filename);
+	bool open(const char* filename, long epoch);
 	void close();
+	void discard();
+
+	// for finish_drained()
+	void finish_if_drained(int64_t now);
 
 	void set_sample_rate(unsigned int sample_rate);
 	void set_bits_per_sample(int bits_per_sample);
@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OP25_REPEATER_DECODE_STATS_H
+#define INCLUDED_OP25_REPEATER_DECODE_STATS_H
+
+#include <stdint.h>
+#include <string.h>
+
+namespace gr {
+  namespace op25_repeater {
+
+    /*!
+     * \brief Error counts of a P25 Phase 1 receive chain.
+     *
+     * Counted as the frames are decoded, starting over at every
+     * activation epoch (see epoch_tag_key()). Plain counters so
+     * keeping them costs an increment per frame or codeword.
+     */
+    struct decode_stats {
+      long epoch;                // activation counted, -1 before the first
+      uint64_t symbols;          // dibits received
+      uint32_t frame_syncs;      // frame sync patterns found
+      uint32_t nid_errors;       // syncs whose NID could not be BCH decoded
+      uint32_t sync_losses;      // sync regained after two frames without one
+      uint32_t frames;           // frames with a good NID
+      uint32_t bch_errors;       // bit errors corrected in those NIDs
+      uint32_t voice_frames;     // LDU1 and LDU2
+      uint32_t voice_codewords;  // IMBE codewords, 9 per LDU
+      uint32_t voice_e0_errors;  // sum of E0, errors in the first Golay word
+      uint32_t voice_et_errors;  // sum of ET, errors in the whole codeword
+      uint32_t tsbk_blocks;      // trunking / data blocks deinterleaved
+      uint32_t tsbk_errors;      // ... that failed the trellis decode or CRC
+
+      decode_stats() { clear(-1); }
+
+      void clear(long e)
+      {
+        memset(this, 0, sizeof(*this));
+        epoch = e;
+      }
+    };
+
+  } // namespace op25_repeater
+} // namespace gr
+
+#endif /* INCLUDED_OP25_REPEATER_DECODE_STATS_H */
@@ -0,0 +1,46 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OP25_REPEATER_EPOCH_TAG_H
+#define INCLUDED_OP25_REPEATER_EPOCH_TAG_H
+
+#include <pmt/pmt.h>
+
+namespace gr {
+  namespace op25_repeater {
+
+    /*!
+     * \brief Key of the stream tag that marks the first sample of a
+     * new activation of a receive chain.
+     *
+     * The value is the activation number as a pmt long. Blocks that
+     * keep tracking state (symbol timing, carrier loop, framer,
+     * vocoder) reset it at the tagged sample and put the tag on the
+     * first output item that depends only on the new input, so the
+     * boundary reaches the sink on the exact sample.
+     */
+    static inline pmt::pmt_t epoch_tag_key()
+    {
+      static const pmt::pmt_t key = pmt::intern("rx_epoch");
+      return key;
+    }
+
+  } // namespace op25_repeater
+} // namespace gr
+
+#endif /* INCLUDED_OP25_REPEATER_EPOCH_TAG_H */
@@ -48,6 +48,12 @@ namespace gr {
        */
       static sptr make(float samples_per_symbol, float gain_mu, float gain_omega, float alpha, float beta, float max_freq, float min_freq);
       virtual void set_omega(float omega) {}
+
+      /*!
+       * Frequency the costas loop is correcting for, in radians per
+       * input sample. The input is that far below where it should be.
+       */
+      virtual float get_freq() { return 0; }
     };
 
   } // namespace op25_repeater
@@ -24,7 +24,8 @@
 
 #include <op25_repeater/api.h>
 #include <gnuradio/block.h>
-#include <gnuradio/msg_queue.h>
+#include <op25_repeater/trunk_msg_queue.h>
+#include <op25_repeater/decode_stats.h>
 
 namespace gr {
   namespace op25_repeater {
@@ -47,9 +48,21 @@ namespace gr {
        * class. op25_repeater::p25_frame_assembler::make is the public interface for
        * creating new instances.
        */
-      static sptr make(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, gr::msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma);
+      static sptr make(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, trunk_msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma);
       virtual void set_xormask(const char*p) {}
       virtual void set_slotid(int slotid) {}
+
+      /*!
+       * \brief Phase 1 error counts of the current activation epoch,
+       * as of the last block of symbols processed. Thread-safe.
+       */
+      virtual void get_decode_stats(decode_stats &stats) {}
+
+      /*!
+       * \brief Audio samples dropped since startup because the output
+       * queue was full, downstream not keeping up. Thread-safe.
+       */
+      virtual uint64_t get_audio_overflows() { return 0; }
     };
 
   } // namespace op25_repeater
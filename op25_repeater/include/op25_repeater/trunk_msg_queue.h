@@ -0,0 +1,218 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_OP25_REPEATER_TRUNK_MSG_QUEUE_H
+#define INCLUDED_OP25_REPEATER_TRUNK_MSG_QUEUE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <gnuradio/thread/thread.h>
+
+namespace gr {
+  namespace op25_repeater {
+
+    /*!
+     * \brief Fixed size control channel message passed from the decoder
+     * blocks to the trunking parsers.
+     *
+     * type is the P25 DUID of the data unit (0 for SmartNet OSWs) or
+     * one of the negative TRUNK_MSG_* values. For P25 Phase 1 nac is
+     * the received NAC, Phase 2 uses 0xffff.
+     */
+    struct trunk_msg {
+      enum {
+        TRUNK_MSG_TIMEOUT = -1,
+        MAX_DATA = 32
+      };
+
+      int32_t type;
+      uint32_t nac;
+      uint32_t errors;      // bit errors corrected while decoding
+      uint32_t len;         // number of valid bytes in data
+      int64_t rx_time;      // clock_ms() when the decoder completed the message
+      uint8_t data[MAX_DATA];
+
+      /*! Milliseconds on CLOCK_MONOTONIC. */
+      static int64_t clock_ms()
+      {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+      }
+
+      void set(int32_t t, uint32_t n, uint32_t e, const void *buf, size_t l)
+      {
+        type = t;
+        nac = n;
+        errors = e;
+        if (l > MAX_DATA)
+          l = MAX_DATA;
+        len = l;
+        if (buf && l)
+          memcpy(data, buf, l);
+        rx_time = clock_ms();
+      }
+    };
+
+    /*!
+     * \brief Bounded multi producer / single consumer queue of
+     * trunk_msg records.
+     *
+     * All slots are allocated up front, records are copied in and
+     * out so no allocation happens per message. A full queue drops
+     * the new message and counts it, the same as a producer checking
+     * gr::msg_queue::full_p() before inserting.
+     */
+    class trunk_msg_queue : public boost::noncopyable
+    {
+    public:
+      typedef boost::shared_ptr<trunk_msg_queue> sptr;
+
+      static sptr make(unsigned int limit)
+      {
+        return sptr(new trunk_msg_queue(limit));
+      }
+
+      ~trunk_msg_queue()
+      {
+        delete[] d_slots;
+      }
+
+      /*!
+       * Copy msg to the tail of the queue. Never blocks.
+       *
+       * \return false if the queue was full and msg was dropped.
+       */
+      bool insert_tail(const trunk_msg &msg)
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        if (d_count == d_limit) {
+          d_drops++;
+          return false;
+        }
+        d_slots[d_tail] = msg;
+        d_tail = (d_tail + 1) % d_limit;
+        d_count++;
+        d_not_empty.notify_one();
+        return true;
+      }
+
+      /*!
+       * Remove the head of the queue into msg, blocking until a
+       * message is available.
+       */
+      void delete_head(trunk_msg &msg)
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        while (d_count == 0)
+          d_not_empty.wait(guard);
+        pop(msg);
+      }
+
+      /*!
+       * Remove the head of the queue into msg, blocking for up to
+       * timeout_ms milliseconds until a message is available.
+       *
+       * \return false if the queue was still empty after timeout_ms.
+       */
+      bool delete_head_timed(trunk_msg &msg, long timeout_ms)
+      {
+        boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout_ms);
+        gr::thread::scoped_lock guard(d_mutex);
+        while (d_count == 0) {
+          if (!d_not_empty.timed_wait(guard, deadline) && d_count == 0)
+            return false;
+        }
+        pop(msg);
+        return true;
+      }
+
+      /*!
+       * Remove the head of the queue into msg if there is one.
+       *
+       * \return false if the queue was empty.
+       */
+      bool delete_head_nowait(trunk_msg &msg)
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        if (d_count == 0)
+          return false;
+        pop(msg);
+        return true;
+      }
+
+      void flush()
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        d_head = d_tail = d_count = 0;
+      }
+
+      bool empty_p() const { return count() == 0; }
+      bool full_p() const { return count() == d_limit; }
+
+      unsigned int count() const
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        return d_count;
+      }
+
+      unsigned int limit() const { return d_limit; }
+
+      /*! Number of messages dropped because the queue was full. */
+      unsigned long drops() const
+      {
+        gr::thread::scoped_lock guard(d_mutex);
+        return d_drops;
+      }
+
+    private:
+      trunk_msg_queue(unsigned int limit) :
+        d_limit(limit ? limit : 1),
+        d_slots(new trunk_msg[d_limit]),
+        d_head(0),
+        d_tail(0),
+        d_count(0),
+        d_drops(0)
+      {
+      }
+
+      void pop(trunk_msg &msg)
+      {
+        msg = d_slots[d_head];
+        d_head = (d_head + 1) % d_limit;
+        d_count--;
+      }
+
+      mutable gr::thread::mutex d_mutex;
+      gr::thread::condition_variable d_not_empty;
+      const unsigned int d_limit;
+      trunk_msg *d_slots;
+      unsigned int d_head;
+      unsigned int d_tail;
+      unsigned int d_count;
+      unsigned long d_drops;
+    };
+
+  } // namespace op25_repeater
+} // namespace gr
+
+#endif /* INCLUDED_OP25_REPEATER_TRUNK_MSG_QUEUE_H */
@@ -0,0 +1,206 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Throughput of the decoders, on random input, for comparing builds:
+ *
+ *   bench-op25_repeater [name ...]
+ *
+ * runs the named benchmarks, all of them without any, and prints how
+ * many items a second each got through. Not run by ctest.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "imbe_vocoder/imbe_vocoder.h"
+#include "rs.h"
+
+// each benchmark runs at least this long
+static const double MIN_SECONDS = 2.0;
+
+static double
+now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t
+lcg(uint32_t &seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 8;
+}
+
+static void
+report(const char *name, const char *unit, double items, double seconds)
+{
+  printf("%-16s %12.0f %s/s\n", name, items / seconds, unit);
+}
+
+// IMBE codewords decoded to audio by the fixed-point vocoder
+static void
+bench_imbe()
+{
+  static const int bits[8] = { 12, 12, 12, 12, 11, 11, 11, 7 };
+  static const int CORPUS = 1024;
+  int16_t corpus[CORPUS][8];
+  int16_t u[8], snd[160];
+  imbe_vocoder vocoder;
+  uint32_t seed = 1;
+
+  for (int f = 0; f < CORPUS; f++) {
+    for (int i = 0; i < 8; i++)
+      corpus[f][i] = lcg(seed) & ((1 << bits[i]) - 1);
+    corpus[f][7] >>= 1;
+  }
+
+  long frames = 0;
+  double start = now();
+  double elapsed;
+  do {
+    for (int f = 0; f < CORPUS; f++) {
+      memcpy(u, corpus[f], sizeof(u));
+      vocoder.imbe_decode(u, snd);
+    }
+    frames += CORPUS;
+    elapsed = now() - start;
+  } while (elapsed < MIN_SECONDS);
+  report("imbe_decode", "frames", frames, elapsed);
+}
+
+/*
+ * HDU words, RS(36,20,17) as rsDec(16, 27), and Phase 2 FACCH words,
+ * RS(63,35) with its 9 punctured symbols erased
+ */
+static void
+bench_rs()
+{
+  static const int CORPUS = 256;
+  uint8_t hdu[CORPUS][63], facch[CORPUS][63], HB[63];
+  uint32_t seed = 1;
+
+  // random symbols are not codewords, but the decoder does the same
+  // work either way until it finds the error locator
+  for (int w = 0; w < CORPUS; w++) {
+    for (int i = 0; i < 63; i++) {
+      hdu[w][i] = (i < 27) ? 0 : (lcg(seed) & 63);
+      facch[w][i] = (i < RS_FACCH_FIRST) ? 0 : (lcg(seed) & 63);
+    }
+  }
+
+  long words = 0;
+  double start = now();
+  double elapsed;
+  do {
+    for (int w = 0; w < CORPUS; w++) {
+      memcpy(HB, hdu[w], sizeof(HB));
+      rsDec(16, 27, HB);
+    }
+    words += CORPUS;
+    elapsed = now() - start;
+  } while (elapsed < MIN_SECONDS);
+  report("rsDec(16,27)", "words", words, elapsed);
+
+  words = 0;
+  start = now();
+  do {
+    for (int w = 0; w < CORPUS; w++) {
+      memcpy(HB, facch[w], sizeof(HB));
+      rsDecAcch(true, HB);
+    }
+    words += CORPUS;
+    elapsed = now() - start;
+  } while (elapsed < MIN_SECONDS);
+  report("rsDecAcch", "words", words, elapsed);
+}
+
+// Golay (24,12) words a frame at a time, as ProcLDU1 decodes them
+static void
+bench_golay()
+{
+  static const int CORPUS = 4096;
+  static uint32_t cw[CORPUS], data[CORPUS];
+  uint32_t seed = 1;
+
+  for (int i = 0; i < CORPUS; i++)
+    cw[i] = lcg(seed) & 0xffffff;
+
+  long words = 0;
+  double start = now();
+  double elapsed;
+  do {
+    gly24128DecBatch(cw, data, CORPUS);
+    words += CORPUS;
+    elapsed = now() - start;
+  } while (elapsed < MIN_SECONDS);
+  report("gly24128Dec", "words", words, elapsed);
+}
+
+// Hamming (10,6,3) words, as the HDU and LDU hexbits are decoded
+static void
+bench_hamming()
+{
+  static const int CORPUS = 4096;
+  static uint32_t cw[CORPUS];
+  static uint8_t hb[CORPUS];
+  uint32_t seed = 1;
+
+  for (int i = 0; i < CORPUS; i++)
+    cw[i] = lcg(seed) & 0x3ff;
+
+  long words = 0;
+  double start = now();
+  double elapsed;
+  do {
+    hmg1063DecBatch(cw, hb, CORPUS);
+    words += CORPUS;
+    elapsed = now() - start;
+  } while (elapsed < MIN_SECONDS);
+  report("hmg1063Dec", "words", words, elapsed);
+}
+
+struct benchmark {
+  const char *name;
+  void (*run)();
+};
+
+static const benchmark benchmarks[] = {
+  { "imbe", bench_imbe },
+  { "rs", bench_rs },
+  { "golay", bench_golay },
+  { "hamming", bench_hamming },
+};
+
+int
+main(int argc, char **argv)
+{
+  int n = sizeof(benchmarks) / sizeof(benchmarks[0]);
+  for (int i = 0; i < n; i++) {
+    bool wanted = (argc < 2);
+    for (int j = 1; j < argc; j++)
+      wanted |= (strcmp(argv[j], benchmarks[i].name) == 0);
+    if (wanted)
+      benchmarks[i].run();
+  }
+  return 0;
+}
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <gnuradio/io_signature.h>
 #include "fsk4_demod_ff_impl.h"
+#include <op25_repeater/epoch_tag.h>
 
 /*
  * This table was machine-generated by gen_interpolator_taps.
@@ -197,6 +198,23 @@ namespace gr {
       coarse_frequency_correction = 0.0;
 
       std::fill(&d_history[0], &d_history[NTAPS], 0.0);
+      // epoch tags are moved to the output by hand, see general_work
+      set_tag_propagation_policy(TPP_DONT);
+    }
+
+    /*
+     * A new activation is a different signal, start the symbol clock
+     * and level tracking over instead of pulling in from the last one.
+     */
+    void
+    fsk4_demod_ff_impl::reset()
+    {
+      d_symbol_clock = 0.0;
+      d_symbol_spread = 2.0;
+      fine_frequency_correction = 0.0;
+      coarse_frequency_correction = 0.0;
+      std::fill(&d_history[0], &d_history[NTAPS], 0.0);
+      d_history_last = 0;
     }
 
     /*
@@ -224,8 +242,17 @@ namespace gr {
       const float *in = (const float *)input_items[0];
       float *out = (float *)output_items[0];
 
+      std::vector<gr::tag_t> tags;
+      get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + noutput_items, epoch_tag_key());
+      size_t next_tag = 0;
+
       // first we run through all provided data
       for(int i = 0; i < noutput_items; i++) {
+	if(next_tag < tags.size() && nitems_read(0) + i >= tags[next_tag].offset) {
+	  reset();
+	  add_item_tag(0, nitems_written(0) + n, tags[next_tag].key, tags[next_tag].value);
+	  next_tag++;
+	}
 	if(tracking_loop_mmse(in[i], &out[n])) {
 	  ++n;
 	}
@@ -47,6 +47,11 @@ namespace gr {
        */
       void send_frequency_correction();
 
+      /**
+       * Start tracking over at an epoch tag.
+       */
+      void reset();
+
       /**
        * Tracking loop.
        */
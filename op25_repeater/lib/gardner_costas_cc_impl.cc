@@ -37,6 +37,7 @@
 #include <string.h>
 
 #include "p25_frame.h"
+#include <op25_repeater/epoch_tag.h>
 
 #define ENABLE_COSTAS_CQPSK_HACK 0
 
@@ -132,6 +133,8 @@ uint8_t gardner_costas_cc_impl::slicer(float sym) {
   set_omega(samples_per_symbol);
   set_relative_rate (1.0 / d_omega);
   set_history(d_twice_sps);			// ensure extra input is available
+  // epoch tags are moved to the output by hand, see general_work
+  set_tag_propagation_policy(TPP_DONT);
     }
 
     /*
@@ -157,6 +160,19 @@ void gardner_costas_cc_impl::set_omega (float omega) {
 }
 
 
+/*
+ * A new activation is a different signal; the loops start over from
+ * the nominal rate instead of pulling in from the last call's offset.
+ */
+void gardner_costas_cc_impl::reset_loops()
+{
+  d_omega = d_omega_mid;
+  d_phase = 0;
+  d_freq = 0;
+  d_last_sample = 0;
+  d_interp_counter = 0;
+}
+
 void
 gardner_costas_cc_impl::forecast(int noutput_items, gr_vector_int &ninput_items_required)
 {
@@ -230,8 +246,17 @@ gardner_costas_cc_impl::general_work (int noutput_items,
   int i=0, o=0;
   gr_complex symbol, sample, nco;
 
+  std::vector<gr::tag_t> tags;
+  get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + ninput_items[0], epoch_tag_key());
+  size_t next_tag = 0;
+
   while((o < noutput_items) && (i < ninput_items[0])) {
     while((d_mu > 1.0) && (i < ninput_items[0]))  {
+	if (next_tag < tags.size() && nitems_read(0) + i >= tags[next_tag].offset) {
+		reset_loops();
+		add_item_tag(0, nitems_written(0) + o, tags[next_tag].key, tags[next_tag].value);
+		next_tag++;
+	}
 	d_mu --;
 
         d_phase += d_freq;
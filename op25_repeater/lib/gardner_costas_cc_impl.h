@@ -68,6 +68,8 @@ namespace gr {
   //! Sets value of omega and its min and max values 
   void set_omega (float omega);
 
+  float get_freq() { return d_freq; }
+
 protected:
   bool input_sample0(gr_complex, gr_complex& outp);
   bool input_sample(gr_complex, gr_complex& outp);
@@ -100,6 +102,7 @@ protected:
 
   uint64_t			nid_accum;
 
+  void reset_loops();
   float phase_error_detector_qpsk(gr_complex sample);
   void phase_error_tracking(gr_complex sample);
   };
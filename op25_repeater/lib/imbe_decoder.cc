@@ -7,6 +7,7 @@ imbe_decoder::~imbe_decoder()
 imbe_decoder::imbe_decoder() :
    d_audio()
 {
+   d_audio.reserve(2 * 160);
 }
 
 audio_samples*
@@ -14,3 +15,13 @@ imbe_decoder::audio()
 {
    return &d_audio;
 }
+
+void
+imbe_decoder::consume(size_t n)
+{
+   if(n >= d_audio.size()) {
+      d_audio.clear();
+   } else {
+      d_audio.erase(d_audio.begin(), d_audio.begin() + n);
+   }
+}
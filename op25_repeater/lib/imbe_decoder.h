@@ -26,10 +26,9 @@
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
-#include <deque>
 #include <vector>
 
-typedef std::deque<float> audio_samples;
+typedef std::vector<float> audio_samples;
 typedef std::vector<bool> voice_codeword;
 
 typedef boost::shared_ptr<class imbe_decoder> imbe_decoder_sptr;
@@ -64,11 +63,20 @@ public:
    /**
     * Returns the audio_samples samples. These are mono samples at
     * 8KS/s represented as a float in the range -1.0 .. +1.0.
+    * Samples are stored contiguously, the caller consumes them
+    * with consume().
     *
-    * \return A non-null pointer to a deque<float> of audio samples.
+    * \return A non-null pointer to a vector<float> of audio samples.
     */
    audio_samples *audio();
 
+   /**
+    * Remove the oldest n samples from the audio buffer.
+    *
+    * \param n The number of samples consumed by the caller.
+    */
+   void consume(size_t n);
+
 protected:
 
    /**
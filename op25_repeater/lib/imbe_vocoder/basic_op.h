@@ -37,9 +37,27 @@ extern Flag Carry;
 /*___________________________________________________________________________
  |                                                                           |
  |   Prototypes for basic arithmetic operators                               |
+ |                                                                           |
+ |   With IMBE_FAST_BASICOP defined the operators are replaced by the        |
+ |   bit-exact inline versions from basic_op_fast.h. basicop2.cc defines     |
+ |   IMBE_BASICOP_REFERENCE so the reference versions are always built.      |
  |___________________________________________________________________________|
 */
 
+#if defined(IMBE_FAST_BASICOP) && !defined(IMBE_BASICOP_REFERENCE)
+
+#include "basic_op_fast.h"
+
+Word32 L_macNs (Word32 L_var3, Word16 var1, Word16 var2); /* Mac without
+                                                             sat, 1   */
+Word32 L_msuNs (Word32 L_var3, Word16 var1, Word16 var2); /* Msu without
+                                                             sat, 1   */
+Word32 L_add_c (Word32 L_var1, Word32 L_var2);  /* Long add with c, 2 */
+Word32 L_sub_c (Word32 L_var1, Word32 L_var2);  /* Long sub with c, 2 */
+Word32 L_sat (Word32 L_var1);            /* Long saturation,       4  */
+
+#else
+
 Word16 add (Word16 var1, Word16 var2);    /* Short add,           1   */
 Word16 sub (Word16 var1, Word16 var2);    /* Short sub,           1   */
 Word16 abs_s (Word16 var1);               /* Short abs,           1   */
@@ -82,4 +100,5 @@ Word16 norm_s (Word16 var1);             /* Short norm,           15  */
 Word16 div_s (Word16 var1, Word16 var2); /* Short division,       18  */
 Word16 norm_l (Word32 L_var1);           /* Long norm,            30  */   
 
+#endif /* IMBE_FAST_BASICOP */
 
@@ -0,0 +1,318 @@
+/*
+ * Project 25 IMBE Encoder/Decoder Fixed-Point implementation
+ * Developed by Pavel Yazev E-mail: pyazev@gmail.com
+ * Version 1.0 (c) Copyright 2009
+ *
+ * This is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * The software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this; see the file COPYING.  If not, write to the Free
+ * Software Foundation, Inc., 51 Franklin Street, Boston, MA
+ * 02110-1301, USA.
+ */
+/*___________________________________________________________________________
+ |                                                                           |
+ |   Inline native versions of the basic arithmetic operators                |
+ |                                                                           |
+ |   Every operator returns exactly the same value as the reference          |
+ |   implementation in basicop2.cc, so the vocoder output is bit-exact.      |
+ |   They are plain static inline functions which lets the compiler fold     |
+ |   them into the DSP loops instead of calling out to basicop2.cc for       |
+ |   every multiply and add.                                                 |
+ |                                                                           |
+ |   These versions do NOT update the global Overflow / Carry flags. The     |
+ |   vocoder never reads them; the few operators whose result depends on     |
+ |   the flags (L_macNs, L_msuNs, L_add_c, L_sub_c, L_sat) are left out of   |
+ |   line in basicop2.cc.                                                    |
+ |___________________________________________________________________________|
+*/
+#ifndef INCLUDED_IMBE_BASIC_OP_FAST_H
+#define INCLUDED_IMBE_BASIC_OP_FAST_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+static inline Word16 saturate (Word32 L_var1)
+{
+    if (L_var1 > 0x00007fffL)
+        return MAX_16;
+    if (L_var1 < (Word32) 0xffff8000L)
+        return MIN_16;
+    return (Word16) L_var1;
+}
+
+static inline Word16 add (Word16 var1, Word16 var2)
+{
+    return saturate ((Word32) var1 + var2);
+}
+
+static inline Word16 sub (Word16 var1, Word16 var2)
+{
+    return saturate ((Word32) var1 - var2);
+}
+
+static inline Word16 abs_s (Word16 var1)
+{
+    if (var1 == MIN_16)
+        return MAX_16;
+    return var1 < 0 ? -var1 : var1;
+}
+
+static inline Word16 negate (Word16 var1)
+{
+    return (var1 == MIN_16) ? MAX_16 : -var1;
+}
+
+static inline Word16 extract_h (Word32 L_var1)
+{
+    return (Word16) (L_var1 >> 16);
+}
+
+static inline Word16 extract_l (Word32 L_var1)
+{
+    return (Word16) L_var1;
+}
+
+static inline Word16 shr (Word16 var1, Word16 var2);
+
+static inline Word16 shl (Word16 var1, Word16 var2)
+{
+    Word32 result;
+
+    if (var2 < 0)
+    {
+        if (var2 < -16)
+            var2 = -16;
+        return shr (var1, -var2);
+    }
+    if (var2 > 15)
+        return var1 == 0 ? 0 : (var1 > 0 ? MAX_16 : MIN_16);
+    result = (Word32) var1 * ((Word32) 1 << var2);
+    if (result != (Word32) ((Word16) result))
+        return var1 > 0 ? MAX_16 : MIN_16;
+    return extract_l (result);
+}
+
+static inline Word16 shr (Word16 var1, Word16 var2)
+{
+    if (var2 < 0)
+    {
+        if (var2 < -16)
+            var2 = -16;
+        return shl (var1, -var2);
+    }
+    if (var2 >= 15)
+        return (var1 < 0) ? -1 : 0;
+    return (Word16) (var1 >> var2);
+}
+
+static inline Word16 mult (Word16 var1, Word16 var2)
+{
+    return saturate (((Word32) var1 * (Word32) var2) >> 15);
+}
+
+static inline Word32 L_mult (Word16 var1, Word16 var2)
+{
+    Word32 L_var_out = (Word32) var1 * (Word32) var2;
+
+    if (L_var_out == (Word32) 0x40000000L)
+        return MAX_32;
+    return L_var_out * 2;
+}
+
+static inline Word32 L_add (Word32 L_var1, Word32 L_var2)
+{
+    int32_t L_var_out;
+
+    if (__builtin_add_overflow ((int32_t) L_var1, (int32_t) L_var2, &L_var_out))
+        return (L_var1 < 0) ? MIN_32 : MAX_32;
+    return L_var_out;
+}
+
+static inline Word32 L_sub (Word32 L_var1, Word32 L_var2)
+{
+    int32_t L_var_out;
+
+    if (__builtin_sub_overflow ((int32_t) L_var1, (int32_t) L_var2, &L_var_out))
+        return (L_var1 < 0) ? MIN_32 : MAX_32;
+    return L_var_out;
+}
+
+static inline Word32 L_negate (Word32 L_var1)
+{
+    return (L_var1 == MIN_32) ? MAX_32 : -L_var1;
+}
+
+static inline Word16 round (Word32 L_var1)
+{
+    return extract_h (L_add (L_var1, (Word32) 0x00008000L));
+}
+
+static inline Word32 L_mac (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return L_add (L_var3, L_mult (var1, var2));
+}
+
+static inline Word32 L_msu (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return L_sub (L_var3, L_mult (var1, var2));
+}
+
+static inline Word16 mult_r (Word16 var1, Word16 var2)
+{
+    return saturate (((Word32) var1 * (Word32) var2 + (Word32) 0x00004000L) >> 15);
+}
+
+static inline Word32 L_shr (Word32 L_var1, Word16 var2);
+
+static inline Word32 L_shl (Word32 L_var1, Word16 var2)
+{
+    int64_t L_result;
+
+    if (var2 <= 0)
+    {
+        if (var2 < -32)
+            var2 = -32;
+        return L_shr (L_var1, -var2);
+    }
+    if (L_var1 == 0)
+        return 0;
+    if (var2 > 31)
+        return (L_var1 > 0) ? MAX_32 : MIN_32;
+    L_result = (int64_t) L_var1 * ((int64_t) 1 << var2);
+    if (L_result > (int64_t) MAX_32)
+        return MAX_32;
+    if (L_result < (int64_t) MIN_32)
+        return MIN_32;
+    return (Word32) L_result;
+}
+
+static inline Word32 L_shr (Word32 L_var1, Word16 var2)
+{
+    if (var2 < 0)
+    {
+        if (var2 < -32)
+            var2 = -32;
+        return L_shl (L_var1, -var2);
+    }
+    if (var2 >= 31)
+        return (L_var1 < 0L) ? -1 : 0;
+    return L_var1 >> var2;
+}
+
+static inline Word16 shr_r (Word16 var1, Word16 var2)
+{
+    Word16 var_out;
+
+    if (var2 > 15)
+        return 0;
+    var_out = shr (var1, var2);
+    if (var2 > 0 && (var1 & ((Word16) 1 << (var2 - 1))) != 0)
+        var_out++;
+    return var_out;
+}
+
+static inline Word16 mac_r (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return extract_h (L_add (L_mac (L_var3, var1, var2), (Word32) 0x00008000L));
+}
+
+static inline Word16 msu_r (Word32 L_var3, Word16 var1, Word16 var2)
+{
+    return extract_h (L_add (L_msu (L_var3, var1, var2), (Word32) 0x00008000L));
+}
+
+static inline Word32 L_deposit_h (Word16 var1)
+{
+    return (Word32) var1 << 16;
+}
+
+static inline Word32 L_deposit_l (Word16 var1)
+{
+    return (Word32) var1;
+}
+
+static inline Word32 L_shr_r (Word32 L_var1, Word16 var2)
+{
+    Word32 L_var_out;
+
+    if (var2 > 31)
+        return 0;
+    L_var_out = L_shr (L_var1, var2);
+    if (var2 > 0 && (L_var1 & ((Word32) 1 << (var2 - 1))) != 0)
+        L_var_out++;
+    return L_var_out;
+}
+
+static inline Word32 L_abs (Word32 L_var1)
+{
+    if (L_var1 == MIN_32)
+        return MAX_32;
+    return L_var1 < 0 ? -L_var1 : L_var1;
+}
+
+static inline Word16 norm_s (Word16 var1)
+{
+    if (var1 == 0)
+        return 0;
+    if (var1 == (Word16) 0xffff)
+        return 15;
+    if (var1 < 0)
+        var1 = ~var1;
+    return (Word16) (__builtin_clz ((uint32_t) var1) - 17);
+}
+
+static inline Word16 norm_l (Word32 L_var1)
+{
+    if (L_var1 == 0)
+        return 0;
+    if (L_var1 == (Word32) 0xffffffffL)
+        return 31;
+    if (L_var1 < 0)
+        L_var1 = ~L_var1;
+    return (Word16) (__builtin_clz ((uint32_t) L_var1) - 1);
+}
+
+static inline Word16 div_s (Word16 var1, Word16 var2)
+{
+    Word16 var_out = 0;
+    Word16 iteration;
+    Word32 L_num, L_denom;
+
+    if ((var1 > var2) || (var1 < 0) || (var2 < 0))
+    {
+        printf ("Division Error var1=%d  var2=%d\n", var1, var2);
+    }
+    if (var2 == 0)
+    {
+        printf ("Division by 0, Fatal error \n");
+    }
+    if (var1 == 0)
+        return 0;
+    if (var1 == var2)
+        return MAX_16;
+
+    L_num = var1;
+    L_denom = var2;
+    for (iteration = 0; iteration < 15; iteration++)
+    {
+        var_out <<= 1;
+        L_num <<= 1;
+        if (L_num >= L_denom)
+        {
+            L_num = L_sub (L_num, L_denom);
+            var_out = add (var_out, 1);
+        }
+    }
+    return var_out;
+}
+
+#endif /* INCLUDED_IMBE_BASIC_OP_FAST_H */
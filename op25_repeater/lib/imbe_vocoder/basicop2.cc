@@ -34,6 +34,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#define IMBE_BASICOP_REFERENCE
 #include "typedef.h"
 #include "basic_op.h"
 
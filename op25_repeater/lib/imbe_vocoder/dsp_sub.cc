@@ -147,6 +147,7 @@ void imbe_vocoder::dct(Word16 *in, Word16 m_lim, Word16 i_lim, Word16 *out)
 void imbe_vocoder::fft_init(void)
 {
 	Word16 i, fft_len2, shift, step, theta;
+	Word16 n, m, j, k;
 
 	fft_len2 = shr(FFTLENGTH, 1);
 	shift    = norm_s(fft_len2);
@@ -162,6 +163,28 @@ void imbe_vocoder::fft_init(void)
 		else
 			theta = add(theta, step);
 	}
+
+	// Precompute the bit-reversal swaps for a FFTLENGTH point transform
+	// so fft() does not have to walk the bit-reversed counter every call
+	n = 2 * FFTLENGTH;
+	j = 1;
+	k = 0;
+	for(i = 1; i < n; i += 2)
+	{
+		if(j > i)
+		{
+			fft_swap[k++] = i;
+			fft_swap[k++] = j;
+		}
+		m = FFTLENGTH;
+		while(m >= 2 && j > m)
+		{
+			j -= m;
+			m >>= 1;
+		}
+		j += m;
+	}
+	fft_nswap = k;
 }
 
 
@@ -203,21 +226,34 @@ void imbe_vocoder::fft(Word16 *datam1, Word16 nn, Word16 isign)
 	data = &datam1[-1];
 
 	n = shl(nn,1);
-	j = 1;
-	for( i = 1; i < n; i+=2 ) 
+	if (nn == FFTLENGTH)
 	{
-		if ( j > i) 
+		for( m = 0; m < fft_nswap; m+=2 ) 
 		{
+			i = fft_swap[m];
+			j = fft_swap[m+1];
 			SWAP(data[j],data[i]);    
 			SWAP(data[j+1],data[i+1]);   
 		}
-		m = nn;
-		while ( m >= 2 && j > m ) 
+	}
+	else
+	{
+		j = 1;
+		for( i = 1; i < n; i+=2 ) 
 		{
-			j = sub(j,m);
-			m = shr(m,1);
+			if ( j > i) 
+			{
+				SWAP(data[j],data[i]);    
+				SWAP(data[j+1],data[i+1]);   
+			}
+			m = nn;
+			while ( m >= 2 && j > m ) 
+			{
+				j = sub(j,m);
+				m = shr(m,1);
+			}
+			j = add(j,m);
 		}
-		j = add(j,m);
 	}
 	mmax = 2;
 
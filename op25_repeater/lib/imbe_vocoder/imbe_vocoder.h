@@ -52,6 +52,8 @@ private:
 	Word16 v_uv_dsn[NUM_BANDS_MAX];
 	Word16 wr_array[FFTLENGTH / 2 + 1];
 	Word16 wi_array[FFTLENGTH / 2 + 1];
+	Word16 fft_swap[FFTLENGTH];
+	Word16 fft_nswap;
 	Word16 pitch_est_buf[PITCH_EST_BUF_SIZE];
 	Word16 pitch_ref_buf[PITCH_EST_BUF_SIZE];
 	Word32 dc_rmv_mem;
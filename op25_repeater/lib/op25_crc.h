@@ -0,0 +1,142 @@
+#ifndef INCLUDED_OP25_CRC_H
+#define INCLUDED_OP25_CRC_H
+
+#include <cstddef>
+#include <stdint.h>
+
+/*
+ * Packed bit buffers are MSB first: bit 0 is the MSB of buf[0].
+ */
+
+/**
+ * Read n (<= 25) bits starting at bit pos of a packed buffer. The
+ * buffer must extend at least 3 bytes past the last bit read.
+ */
+static inline uint32_t
+get_packed_bits(const uint8_t buf[], unsigned int pos, unsigned int n)
+{
+	const uint8_t *p = buf + (pos >> 3);
+	uint32_t w = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+	return (w << (pos & 7)) >> (32 - n);
+}
+
+/**
+ * Write the low n bits of v at bit pos of a packed buffer.
+ */
+static inline void
+put_packed_bits(uint8_t buf[], unsigned int pos, unsigned int n, uint32_t v)
+{
+	for (unsigned int i = 0; i < n; i++, pos++) {
+		uint8_t m = 0x80 >> (pos & 7);
+		if ((v >> (n - 1 - i)) & 1)
+			buf[pos >> 3] |= m;
+		else
+			buf[pos >> 3] &= ~m;
+	}
+}
+
+/**
+ * P25 Phase 2 CRC-12 (x^12+x^11+x^7+x^4+x^2+x+1) of the first nbits of
+ * a packed buffer, inverted.
+ */
+static inline uint16_t
+crc12_packed(const uint8_t buf[], unsigned int nbits)
+{
+	static const uint16_t table[256] = {
+		0x000, 0x897, 0x9b9, 0x12e, 0xbe5, 0x372, 0x25c, 0xacb,
+		0xf5d, 0x7ca, 0x6e4, 0xe73, 0x4b8, 0xc2f, 0xd01, 0x596,
+		0x62d, 0xeba, 0xf94, 0x703, 0xdc8, 0x55f, 0x471, 0xce6,
+		0x970, 0x1e7, 0x0c9, 0x85e, 0x295, 0xa02, 0xb2c, 0x3bb,
+		0xc5a, 0x4cd, 0x5e3, 0xd74, 0x7bf, 0xf28, 0xe06, 0x691,
+		0x307, 0xb90, 0xabe, 0x229, 0x8e2, 0x075, 0x15b, 0x9cc,
+		0xa77, 0x2e0, 0x3ce, 0xb59, 0x192, 0x905, 0x82b, 0x0bc,
+		0x52a, 0xdbd, 0xc93, 0x404, 0xecf, 0x658, 0x776, 0xfe1,
+		0x023, 0x8b4, 0x99a, 0x10d, 0xbc6, 0x351, 0x27f, 0xae8,
+		0xf7e, 0x7e9, 0x6c7, 0xe50, 0x49b, 0xc0c, 0xd22, 0x5b5,
+		0x60e, 0xe99, 0xfb7, 0x720, 0xdeb, 0x57c, 0x452, 0xcc5,
+		0x953, 0x1c4, 0x0ea, 0x87d, 0x2b6, 0xa21, 0xb0f, 0x398,
+		0xc79, 0x4ee, 0x5c0, 0xd57, 0x79c, 0xf0b, 0xe25, 0x6b2,
+		0x324, 0xbb3, 0xa9d, 0x20a, 0x8c1, 0x056, 0x178, 0x9ef,
+		0xa54, 0x2c3, 0x3ed, 0xb7a, 0x1b1, 0x926, 0x808, 0x09f,
+		0x509, 0xd9e, 0xcb0, 0x427, 0xeec, 0x67b, 0x755, 0xfc2,
+		0x046, 0x8d1, 0x9ff, 0x168, 0xba3, 0x334, 0x21a, 0xa8d,
+		0xf1b, 0x78c, 0x6a2, 0xe35, 0x4fe, 0xc69, 0xd47, 0x5d0,
+		0x66b, 0xefc, 0xfd2, 0x745, 0xd8e, 0x519, 0x437, 0xca0,
+		0x936, 0x1a1, 0x08f, 0x818, 0x2d3, 0xa44, 0xb6a, 0x3fd,
+		0xc1c, 0x48b, 0x5a5, 0xd32, 0x7f9, 0xf6e, 0xe40, 0x6d7,
+		0x341, 0xbd6, 0xaf8, 0x26f, 0x8a4, 0x033, 0x11d, 0x98a,
+		0xa31, 0x2a6, 0x388, 0xb1f, 0x1d4, 0x943, 0x86d, 0x0fa,
+		0x56c, 0xdfb, 0xcd5, 0x442, 0xe89, 0x61e, 0x730, 0xfa7,
+		0x065, 0x8f2, 0x9dc, 0x14b, 0xb80, 0x317, 0x239, 0xaae,
+		0xf38, 0x7af, 0x681, 0xe16, 0x4dd, 0xc4a, 0xd64, 0x5f3,
+		0x648, 0xedf, 0xff1, 0x766, 0xdad, 0x53a, 0x414, 0xc83,
+		0x915, 0x182, 0x0ac, 0x83b, 0x2f0, 0xa67, 0xb49, 0x3de,
+		0xc3f, 0x4a8, 0x586, 0xd11, 0x7da, 0xf4d, 0xe63, 0x6f4,
+		0x362, 0xbf5, 0xadb, 0x24c, 0x887, 0x010, 0x13e, 0x9a9,
+		0xa12, 0x285, 0x3ab, 0xb3c, 0x1f7, 0x960, 0x84e, 0x0d9,
+		0x54f, 0xdd8, 0xcf6, 0x461, 0xeaa, 0x63d, 0x713, 0xf84
+	};
+	uint16_t crc = 0;
+	unsigned int i;
+
+	for (i = 0; i < nbits / 8; i++)
+		crc = ((crc << 8) ^ table[((crc >> 4) ^ buf[i]) & 0xff]) & 0xfff;
+	for (i = i * 8; i < nbits; i++) {
+		uint16_t bit = ((buf[i >> 3] >> (7 - (i & 7))) & 1) ^ (crc >> 11);
+		crc = (crc << 1) & 0xfff;
+		if (bit)
+			crc ^= 0x897;
+	}
+	return crc ^ 0xfff;
+}
+
+/**
+ * CCITT CRC-16 (x^16+x^12+x^5+1) remainder of len bytes, message bits
+ * (including the transmitted CRC) divided directly, inverted.
+ * Returns 0 for a good P25 Phase 1 TSBK / header block.
+ */
+static inline uint16_t
+crc16_packed(const uint8_t buf[], int len)
+{
+	static const uint16_t table[256] = {
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+		0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+		0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+		0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+		0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+		0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+		0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+		0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+		0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+		0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+		0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+		0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+		0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+		0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+		0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+		0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+		0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+		0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+		0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+		0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+		0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+		0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+		0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+		0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+		0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+		0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+		0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+		0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+		0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+		0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+		0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+		0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
+	};
+	uint16_t crc = 0;
+
+	for (int i = 0; i < len; i++)
+		crc = ((crc << 8) | buf[i]) ^ table[crc >> 8];
+	return crc ^ 0xffff;
+}
+
+#endif /* INCLUDED_OP25_CRC_H */
@@ -0,0 +1,151 @@
+#ifndef INCLUDED_OP25_RING_BUFFER_H
+#define INCLUDED_OP25_RING_BUFFER_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string.h>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+/**
+ * Fixed capacity single-producer / single-consumer ring buffer used
+ * to pass decoded audio (or packed bytes) from the frame decoders to
+ * the output side of p25_frame_assembler / vocoder.
+ *
+ * Storage is allocated once and never grows: when the consumer
+ * stalls, items that do not fit are dropped and counted in
+ * overflows() instead. Capacity is rounded up to a power of two so
+ * that indexing is a mask, and bulk reads / writes are done with at
+ * most two memcpy() calls.
+ *
+ * T must be a POD type.
+ */
+template <class T>
+class op25_ring_buffer : public boost::noncopyable
+{
+public:
+	explicit op25_ring_buffer(size_t capacity) :
+		d_capacity(round_pow2(capacity)),
+		d_mask(d_capacity - 1),
+		d_buf(new T[d_capacity]),
+		d_head(0),
+		d_tail(0),
+		d_overflows(0)
+	{
+	}
+
+	~op25_ring_buffer()
+	{
+		delete[] d_buf;
+	}
+
+	/** Number of items that can be read. */
+	size_t size() const
+	{
+		return d_head.load(boost::memory_order_acquire) - d_tail.load(boost::memory_order_relaxed);
+	}
+
+	/** Number of items that can be written without overflowing. */
+	size_t space() const
+	{
+		return d_capacity - (d_head.load(boost::memory_order_relaxed) - d_tail.load(boost::memory_order_acquire));
+	}
+
+	size_t capacity() const { return d_capacity; }
+
+	bool empty() const { return size() == 0; }
+
+	/** Total number of items dropped because the buffer was full. */
+	uint64_t overflows() const
+	{
+		return d_overflows.load(boost::memory_order_relaxed);
+	}
+
+	/**
+	 * Append up to n items. Items that do not fit are dropped and
+	 * counted as overflows.
+	 *
+	 * \return The number of items actually written.
+	 */
+	size_t write(const T *src, size_t n)
+	{
+		size_t head = d_head.load(boost::memory_order_relaxed);
+		size_t avail = d_capacity - (head - d_tail.load(boost::memory_order_acquire));
+		if (n > avail) {
+			d_overflows.fetch_add(n - avail, boost::memory_order_relaxed);
+			n = avail;
+		}
+		size_t pos = head & d_mask;
+		size_t first = d_capacity - pos;
+		if (first > n)
+			first = n;
+		memcpy(&d_buf[pos], src, first * sizeof(T));
+		memcpy(&d_buf[0], src + first, (n - first) * sizeof(T));
+		d_head.store(head + n, boost::memory_order_release);
+		return n;
+	}
+
+	/** Append a single item, or count an overflow when full. */
+	bool push_back(const T &v)
+	{
+		size_t head = d_head.load(boost::memory_order_relaxed);
+		if (head - d_tail.load(boost::memory_order_acquire) >= d_capacity) {
+			d_overflows.fetch_add(1, boost::memory_order_relaxed);
+			return false;
+		}
+		d_buf[head & d_mask] = v;
+		d_head.store(head + 1, boost::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Remove up to n items, copying them to dst.
+	 *
+	 * \return The number of items actually read.
+	 */
+	size_t read(T *dst, size_t n)
+	{
+		size_t tail = d_tail.load(boost::memory_order_relaxed);
+		size_t avail = d_head.load(boost::memory_order_acquire) - tail;
+		if (n > avail)
+			n = avail;
+		size_t pos = tail & d_mask;
+		size_t first = d_capacity - pos;
+		if (first > n)
+			first = n;
+		memcpy(dst, &d_buf[pos], first * sizeof(T));
+		memcpy(dst + first, &d_buf[0], (n - first) * sizeof(T));
+		d_tail.store(tail + n, boost::memory_order_release);
+		return n;
+	}
+
+	/** Discard everything currently queued. Consumer side only. */
+	void clear()
+	{
+		d_tail.store(d_head.load(boost::memory_order_acquire), boost::memory_order_release);
+	}
+
+private:
+	static size_t round_pow2(size_t n)
+	{
+		size_t p = 1;
+		while (p < n)
+			p <<= 1;
+		return p;
+	}
+
+	const size_t d_capacity;
+	const size_t d_mask;
+	T *d_buf;
+	// head and tail live on separate cache lines so the producer and
+	// consumer do not false-share
+	boost::atomic<size_t> d_head;
+	char d_pad0[64 - sizeof(boost::atomic<size_t>)];
+	boost::atomic<size_t> d_tail;
+	char d_pad1[64 - sizeof(boost::atomic<size_t>)];
+	boost::atomic<uint64_t> d_overflows;
+};
+
+typedef op25_ring_buffer<int16_t> sample_ring;
+
+#endif /* INCLUDED_OP25_RING_BUFFER_H */
@@ -24,6 +24,7 @@
 
 #include <gnuradio/io_signature.h>
 #include "p25_frame_assembler_impl.h"
+#include <op25_repeater/epoch_tag.h>
 
 #include <errno.h>
 #include <stdio.h>
@@ -32,6 +33,7 @@
 #include <string.h>
 #include <errno.h>
 #include <vector>
+#include <algorithm>
 #include <sys/time.h>
 
 namespace gr {
@@ -39,12 +41,10 @@ namespace gr {
 
     void p25_frame_assembler_impl::p25p2_queue_msg(int duid)
     {
-	static const char wbuf[2] = {0xff, 0xff}; // dummy NAC
+	trunk_msg msg;
 	if (!d_do_msgq)
 		return;
-	if (d_msg_queue->full_p())
-		return;
-	gr::message::sptr msg = gr::message::make_from_string(std::string(wbuf, 2), duid, 0, 0);
+	msg.set(duid, 0xffff, 0, NULL, 0); // dummy NAC
 	d_msg_queue->insert_tail(msg);
     }
 
@@ -57,7 +57,7 @@ namespace gr {
     }
 
     p25_frame_assembler::sptr
-    p25_frame_assembler::make(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, gr::msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma)
+    p25_frame_assembler::make(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, trunk_msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma)
     {
       return gnuradio::get_initial_sptr
         (new p25_frame_assembler_impl(udp_host, port, debug, do_imbe, do_output, do_msgq, queue, do_audio_output, do_phase2_tdma));
@@ -80,20 +80,23 @@ static const int MAX_IN = 1;	// maximum number of input streams
 /*
  * The private constructor
  */
-    p25_frame_assembler_impl::p25_frame_assembler_impl(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, gr::msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma)
+    p25_frame_assembler_impl::p25_frame_assembler_impl(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, trunk_msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma)
       : gr::block("p25_frame_assembler",
 		   gr::io_signature::make (MIN_IN, MAX_IN, sizeof (char)),
 		   gr::io_signature::make ((do_output || do_audio_output) ? 1 : 0, (do_output || do_audio_output) ? 1 : 0, (do_audio_output) ? sizeof(int16_t) : ((do_output) ? sizeof(char) : 0 ))),
+	output_queue(OUTPUT_QUEUE_SIZE),
 	d_do_imbe(do_imbe),
 	d_do_output(do_output),
-	output_queue(),
 	p1fdma(udp_host, port, debug, do_imbe, do_output, do_msgq, queue, output_queue, do_audio_output),
 	d_do_audio_output(do_audio_output),
 	d_do_phase2_tdma(do_phase2_tdma),
 	p2tdma(0, debug, output_queue),
 	d_do_msgq(do_msgq),
-	d_msg_queue(queue)
+	d_msg_queue(queue),
+	d_epoch(-1)
 {
+	// epoch tags are moved to the output by hand, see general_work
+	set_tag_propagation_policy(TPP_DONT);
 	if (d_do_audio_output && !d_do_output)
 		fprintf(stderr, "p25_frame_assembler: error: do_output must be enabled if do_audio_output is enabled\n");
 	if (d_do_audio_output && !d_do_imbe)
@@ -123,19 +126,25 @@ p25_frame_assembler_impl::forecast(int nof_output_items, gr_vector_int &nof_inpu
     }     
 }
 
-
-int 
-p25_frame_assembler_impl::general_work (int noutput_items,
-                               gr_vector_int &ninput_items,
-                               gr_vector_const_void_star &input_items,
-                               gr_vector_void_star &output_items)
+void
+p25_frame_assembler_impl::get_decode_stats(decode_stats &stats)
 {
+  gr::thread::scoped_lock guard(d_stats_mutex);
+  stats = d_stats;
+}
 
-  const uint8_t *in = (const uint8_t *) input_items[0];
+uint64_t
+p25_frame_assembler_impl::get_audio_overflows()
+{
+  return output_queue.overflows();
+}
 
-  p1fdma.rx_sym(in, ninput_items[0]);
+void
+p25_frame_assembler_impl::rx_syms(const uint8_t *in, int nsyms)
+{
+  p1fdma.rx_sym(in, nsyms);
   if(d_do_phase2_tdma) {
-	for (int i = 0; i < ninput_items[0]; i++) {
+	for (int i = 0; i < nsyms; i++) {
 		if(p2tdma.rx_sym(in[i])) {
 			int rc = p2tdma.handle_frame();
 			if (rc > -1)
@@ -143,6 +152,42 @@ p25_frame_assembler_impl::general_work (int noutput_items,
 		}
 	}
   }
+}
+
+int 
+p25_frame_assembler_impl::general_work (int noutput_items,
+                               gr_vector_int &ninput_items,
+                               gr_vector_const_void_star &input_items,
+                               gr_vector_void_star &output_items)
+{
+
+  const uint8_t *in = (const uint8_t *) input_items[0];
+  std::vector<gr::tag_t> tags;
+  get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + ninput_items[0], epoch_tag_key());
+
+  // symbols before an epoch tag belong to the previous activation;
+  // everything decoded from them is already in output_queue, so the
+  // new activation starts right after it
+  int start = 0;
+  for (size_t t = 0; t <= tags.size(); t++) {
+    int end = ninput_items[0];
+    if (t < tags.size())
+      end = std::max(start, (int) (tags[t].offset - nitems_read(0)));
+    rx_syms(in + start, end - start);
+    start = end;
+    if (t < tags.size()) {
+      p1fdma.reset();
+      d_epoch = pmt::to_long(tags[t].value);
+      if (d_do_output)
+        add_item_tag(0, nitems_written(0) + output_queue.size(), tags[t].key, tags[t].value);
+    }
+  }
+  {
+    gr::thread::scoped_lock guard(d_stats_mutex);
+    p1fdma.get_stats(d_stats);
+    d_stats.epoch = d_epoch;
+  }
+
   int amt_produce = 0;
   if (d_do_output) {
     amt_produce = noutput_items;
@@ -151,16 +196,17 @@ p25_frame_assembler_impl::general_work (int noutput_items,
     if (amt_produce > 0) {
       if (d_do_audio_output) {
         int16_t *out = (int16_t *) output_items[0];
-        for (int i=0; i < amt_produce; i++) {
-          out[i] = output_queue[i];
-        }
+        output_queue.read(out, amt_produce);
       } else {
         unsigned char *out = (unsigned char *) output_items[0];
-        for (int i=0; i < amt_produce; i++) {
-          out[i] = output_queue[i];
+        int16_t chunk[512];
+        for (int i=0; i < amt_produce; ) {
+          int n = output_queue.read(chunk, std::min(amt_produce - i, (int)(sizeof(chunk)/sizeof(chunk[0]))));
+          for (int j=0; j < n; j++)
+            out[i + j] = chunk[j];
+          i += n;
         }
       }
-      output_queue.erase(output_queue.begin(), output_queue.begin() + amt_produce);
     }
   }
   consume_each(ninput_items[0]);
@@ -23,13 +23,16 @@
 
 #include <op25_repeater/p25_frame_assembler.h>
 
-#include <gnuradio/msg_queue.h>
+#include <op25_repeater/trunk_msg_queue.h>
+#include <op25_repeater/decode_stats.h>
+#include <gnuradio/thread/thread.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <deque>
 
+#include "op25_ring_buffer.h"
 #include "p25p1_fdma.h"
 #include "p25p2_tdma.h"
 
@@ -41,6 +44,10 @@ namespace gr {
     class p25_frame_assembler_impl : public p25_frame_assembler
     {
      private:
+	// 4 seconds of 8 KS/s audio; declared ahead of p1fdma / p2tdma
+	// because both hold a reference to it
+	static const size_t OUTPUT_QUEUE_SIZE = 32768;
+	sample_ring output_queue;
 	bool d_do_imbe;
 	bool d_do_output;
 	p25p1_fdma p1fdma;
@@ -48,22 +55,27 @@ namespace gr {
 	bool d_do_phase2_tdma;
 	p25p2_tdma p2tdma;
 	bool d_do_msgq;
-	gr::msg_queue::sptr d_msg_queue;
+	trunk_msg_queue::sptr d_msg_queue;
 
   // internal functions
 
     void p25p2_queue_msg(int duid);
+    void rx_syms(const uint8_t *in, int nsyms);
     void set_xormask(const char*p) ;
     void set_slotid(int slotid) ;
+    void get_decode_stats(decode_stats &stats);
+    uint64_t get_audio_overflows();
 	typedef std::vector<bool> bit_vector;
-	std::deque<int16_t> output_queue;
+	long d_epoch;			// last epoch tag seen, -1 before the first
+	gr::thread::mutex d_stats_mutex;
+	decode_stats d_stats;		// copy of p1fdma's, published once per work call
 
  public:
    virtual void forecast(int nof_output_items, gr_vector_int &nof_input_items_reqd);
       // Nothing to declare in this block.
 
      public:
-      p25_frame_assembler_impl(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, gr::msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma);
+      p25_frame_assembler_impl(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, trunk_msg_queue::sptr queue, bool do_audio_output, bool do_phase2_tdma);
       ~p25_frame_assembler_impl();
 
       // Where all the action really happens
@@ -30,6 +30,9 @@ static const int max_frame_lengths[16] = {
 	432	// f - tdu
 };
 
+// dibits the symbol clock may slip by between two syncs
+static const size_t SYNC_SLIP = 8;
+
 // constructor
 p25_framer::p25_framer() :
 	reverse_p(0),
@@ -37,8 +40,15 @@ p25_framer::p25_framer() :
 	next_bit(0),
 	nid_accum(0),
 	frame_size_limit(0),
+	syms_since_sync(0),
 	symbols_received(0),
-	frame_body(P25_VOICE_FRAME_SIZE)
+	frame_body(P25_VOICE_FRAME_SIZE),
+	bch_errors(0),
+	frame_syncs(0),
+	nid_errors(0),
+	sync_losses(0),
+	frames(0),
+	bch_error_total(0)
 {
 }
 
@@ -78,10 +88,13 @@ bool p25_framer::nid_codeword(uint64_t acc) {
 
 	// check if bch decode unsuccessful
 	if (rc < 0) {
+		nid_errors++;
 		return false;
 	}
 
 	bch_errors = rc;
+	frames++;
+	bch_error_total += rc;
 
 	// load corrected bch bits into acc
 	acc = 0;
@@ -99,6 +112,15 @@ bool p25_framer::nid_codeword(uint64_t acc) {
 	return true;
 }
 
+void p25_framer::found_sync() {
+	// a voice frame is P25_VOICE_FRAME_SIZE / 2 dibits, a longer gap
+	// between syncs means at least one frame's sync was missed
+	if (frame_syncs && syms_since_sync > P25_VOICE_FRAME_SIZE / 2 + SYNC_SLIP)
+		sync_losses++;
+	frame_syncs++;
+	syms_since_sync = 0;
+}
+
 /*
  * rx_sym: called once per received symbol
  * 1. looks for flags sequences
@@ -110,6 +132,7 @@ bool p25_framer::nid_codeword(uint64_t acc) {
  */
 bool p25_framer::rx_sym(uint8_t dibit) {
 	symbols_received++;
+	syms_since_sync++;
         bool rc = false;
 	dibit ^= reverse_p;
 	// FIXME assert(dibit >= 0 && dibit <= 3)
@@ -136,9 +159,11 @@ bool p25_framer::rx_sym(uint8_t dibit) {
 
 	if(check_frame_sync((nid_accum & P25_FRAME_SYNC_MASK) ^ P25_FRAME_SYNC_MAGIC, 6)) {
 		nid_syms = 1;
+		found_sync();
 	}
 	if(check_frame_sync((nid_accum & P25_FRAME_SYNC_MASK) ^ P25_FRAME_SYNC_REV_P, 0)) {
 		nid_syms = 1;
+		found_sync();
 		reverse_p ^= 0x02;   // auto flip polarity reversal
 		fprintf(stderr, "Reversed FS polarity detected - autocorrecting\n");
 	}
@@ -26,6 +26,8 @@ private:
 	uint64_t nid_accum;
 
 	uint32_t frame_size_limit;
+	uint32_t syms_since_sync;
+	void found_sync();
 
 public:
 	p25_framer();  	// constructor
@@ -41,6 +43,13 @@ public:
 	bit_vector frame_body;	// all bits in frame
 	uint32_t frame_size;		// number of bits in frame_body
 	uint32_t bch_errors;		// number of errors detected in bch
+
+	// totals since construction
+	uint32_t frame_syncs;		// frame sync patterns found
+	uint32_t nid_errors;		// NIDs the bch could not decode
+	uint32_t sync_losses;		// sync found again after more than a voice frame
+	uint32_t frames;		// NIDs decoded
+	uint32_t bch_error_total;	// bch_errors summed over those
 };
 
 #endif /* INCLUDED_P25_FRAMER_H */
@@ -37,11 +37,12 @@
 #include "p25_frame.h"
 #include "p25_framer.h"
 #include "rs.h"
+#include "op25_crc.h"
 
 namespace gr {
   namespace op25_repeater {
 
-static const int64_t TIMEOUT_THRESHOLD = 1000000;
+static const int64_t TIMEOUT_THRESHOLD = 1000;	// ms
 
     p25p1_fdma::~p25p1_fdma()
     {
@@ -50,22 +51,6 @@ static const int64_t TIMEOUT_THRESHOLD = 1000000;
 	delete framer;
     }
 
-static uint16_t crc16(uint8_t buf[], int len) {
-        uint32_t poly = (1<<12) + (1<<5) + (1<<0);
-        uint32_t crc = 0;
-        for(int i=0; i<len; i++) {
-                uint8_t bits = buf[i];
-                for (int j=0; j<8; j++) {
-                        uint8_t bit = (bits >> (7-j)) & 1;
-                        crc = ((crc << 1) | bit) & 0x1ffff;
-                        if (crc & 0x10000)
-                                crc = (crc & 0xffff) ^ poly;
-		}
-	}
-        crc = crc ^ 0xffff;
-        return crc & 0xffff;
-}
-
 /* translated from p25craft.py Michael Ossmann <mike@ossmann.com>  */
 static uint32_t crc32(uint8_t buf[], int len) {	/* length is nr. of bits */
         uint32_t g = 0x04c11db7;
@@ -187,7 +172,7 @@ block_deinterleave(bit_vector& bv, unsigned int start, uint8_t* buf)
 			buf[d >> 2] |= state << (6 - ((d%4) * 2));
 		}
 	}
-	crc = crc16(buf, 12);
+	crc = crc16_packed(buf, 12);
 	if (crc == 0)
 		return 0;	// return OK code
 	crc1 = crc32(buf, 8*8);	// try crc32
@@ -197,7 +182,7 @@ block_deinterleave(bit_vector& bv, unsigned int start, uint8_t* buf)
 	return -2;	// trellis decode OK, but CRC error occurred
 }
 
-p25p1_fdma::p25p1_fdma(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, gr::msg_queue::sptr queue, std::deque<int16_t> &output_queue, bool do_audio_output) :
+p25p1_fdma::p25p1_fdma(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, trunk_msg_queue::sptr queue, sample_ring &output_queue, bool do_audio_output) :
 	write_bufp(0),
 	write_sock(0),
 	d_udp_host(udp_host),
@@ -212,37 +197,52 @@ p25p1_fdma::p25p1_fdma(const char* udp_host, int port, int debug, bool do_imbe,
 	d_do_audio_output(do_audio_output),
 	p1voice_decode((debug > 0), udp_host, port, output_queue)
 {
-	gettimeofday(&last_qtime, 0);
+	last_qtime = trunk_msg::clock_ms();
 	if (port > 0)
 		init_sock(d_udp_host, d_port);
 }
 
+/*
+ * Start over at an activation boundary: throw away any partial frame
+ * and the vocoder state of the previous call.
+ */
+void
+p25p1_fdma::reset()
+{
+	delete framer;
+	framer = new p25_framer();
+	p1voice_decode.reset();
+	last_qtime = trunk_msg::clock_ms();
+	d_stats.clear(-1);
+}
+
+void
+p25p1_fdma::get_stats(decode_stats &stats)
+{
+	stats = d_stats;
+	stats.symbols = framer->symbols_received;
+	stats.frame_syncs = framer->frame_syncs;
+	stats.nid_errors = framer->nid_errors;
+	stats.sync_losses = framer->sync_losses;
+	stats.frames = framer->frames;
+	stats.bch_errors = framer->bch_error_total;
+}
+
 void 
 p25p1_fdma::process_duid(uint32_t const duid, uint32_t const nac, uint8_t const buf[], int const len)
 {
-	char wbuf[256];
-	int p = 0;
+	trunk_msg msg;
 	if (!d_do_msgq)
 		return;
-	if (d_msg_queue->full_p())
-		return;
-	assert (len+2 <= sizeof(wbuf));
-	wbuf[p++] = (nac >> 8) & 0xff;
-	wbuf[p++] = nac & 0xff;
-	if (buf) {
-		memcpy(&wbuf[p], buf, len);	// copy data
-		p += len;
-	}
-	gr::message::sptr msg = gr::message::make_from_string(std::string(wbuf, p), duid, 0, 0);
+	assert (len <= trunk_msg::MAX_DATA);
+	msg.set(duid, nac, framer->bch_errors, buf, len);
 	d_msg_queue->insert_tail(msg);
-	gettimeofday(&last_qtime, 0);
-//	msg.reset();
+	last_qtime = msg.rx_time;
 }
 
 void 
 p25p1_fdma::rx_sym (const uint8_t *syms, int nsyms)
 {
-  struct timeval currtime;
   for (int i1 = 0; i1 < nsyms; i1++){
     if(framer->rx_sym(syms[i1])) {   // complete frame was detected
 		if (d_debug >= 10) {
@@ -274,6 +274,9 @@ p25p1_fdma::rx_sym (const uint8_t *syms, int nsyms)
 			for(int sz=0; sz < 3; sz++) {
 				if (framer->frame_size >= sizes[sz]) {
 					rc[sz] = block_deinterleave(bv1,48+64+sz*196  , deinterleave_buf[sz]);
+					d_stats.tsbk_blocks++;
+					if (rc[sz] != 0)
+						d_stats.tsbk_errors++;
 					if (framer->duid == 0x07 && rc[sz] == 0)
 						process_duid(framer->duid, framer->nac, deinterleave_buf[sz], 10);
 				}
@@ -303,6 +306,7 @@ p25p1_fdma::rx_sym (const uint8_t *syms, int nsyms)
 		if (d_debug >= 10)
 			fprintf(stderr, "\n");
 		if ((d_do_imbe || d_do_audio_output) && (framer->duid == 0x5 || framer->duid == 0xa)) {  // if voice - ldu1 or ldu2
+			d_stats.voice_frames++;
 			for(size_t i = 0; i < nof_voice_codewords; ++i) {
 				voice_codeword cw(voice_codeword_sz);
 				uint32_t E0, ET;
@@ -311,6 +315,9 @@ p25p1_fdma::rx_sym (const uint8_t *syms, int nsyms)
 				imbe_deinterleave(framer->frame_body, cw, i);
 				// recover 88-bit IMBE voice code word
 				imbe_header_decode(cw, u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7], E0, ET);
+				d_stats.voice_codewords++;
+				d_stats.voice_e0_errors += E0;
+				d_stats.voice_et_errors += ET;
 				// output one 32-byte msg per 0.020 sec.
 				// also, 32*9 = 288 byte pkts (for use via UDP)
 				sprintf(s, "%03x %03x %03x %03x %03x %03x %03x %03x\n", u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7]);
@@ -354,26 +361,21 @@ p25p1_fdma::rx_sym (const uint8_t *syms, int nsyms)
 				sendto(write_sock, obuf, obuf_ct, 0, (struct sockaddr*)&write_sock_addr, sizeof(write_sock_addr));
 			}
 			if (d_do_output) {
+				int16_t qbuf[P25_VOICE_FRAME_SIZE/2];
 				for (size_t j=0; j < obuf_ct; j++) {
-					output_queue.push_back(obuf[j]);
+					qbuf[j] = obuf[j];
 				}
+				output_queue.write(qbuf, obuf_ct);
 			}
 		}
     }  // end of complete frame
   }
-  if (d_do_msgq && !d_msg_queue->full_p()) {
+  if (d_do_msgq) {
     // check for timeout
-    gettimeofday(&currtime, 0);
-    int64_t diff_usec = currtime.tv_usec - last_qtime.tv_usec;
-    int64_t diff_sec  = currtime.tv_sec  - last_qtime.tv_sec ;
-    if (diff_usec < 0) {
-      diff_usec += 1000000;
-      diff_sec  -= 1;
-    }
-    diff_usec += diff_sec * 1000000;
-    if (diff_usec >= TIMEOUT_THRESHOLD) {
-      gettimeofday(&last_qtime, 0);
-      gr::message::sptr msg = gr::message::make(-1, 0, 0);
+    if (trunk_msg::clock_ms() - last_qtime >= TIMEOUT_THRESHOLD) {
+      trunk_msg msg;
+      msg.set(trunk_msg::TRUNK_MSG_TIMEOUT, 0, 0, NULL, 0);
+      last_qtime = msg.rx_time;
       d_msg_queue->insert_tail(msg);
     }
   }
@@ -21,12 +21,13 @@
 #ifndef INCLUDED_OP25_REPEATER_P25P1_FDMA_H
 #define INCLUDED_OP25_REPEATER_P25P1_FDMA_H
 
-#include <gnuradio/msg_queue.h>
+#include <op25_repeater/trunk_msg_queue.h>
+#include <op25_repeater/decode_stats.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include <deque>
+#include "op25_ring_buffer.h"
 
 #include "p25_framer.h"
 #include "p25p1_voice_encode.h"
@@ -56,16 +57,20 @@ namespace gr {
 	bool d_do_imbe;
 	bool d_do_output;
 	bool d_do_msgq;
-	gr::msg_queue::sptr d_msg_queue;
-	std::deque<int16_t> &output_queue;
+	trunk_msg_queue::sptr d_msg_queue;
+	sample_ring &output_queue;
 	p25_framer* framer;
-	struct timeval last_qtime;
+	int64_t last_qtime;	// trunk_msg::clock_ms() of the last queued message
 	bool d_do_audio_output;
         p25p1_voice_decode p1voice_decode;
+	decode_stats d_stats;	// the counts p25_framer does not keep
 
      public:
 	void rx_sym (const uint8_t *syms, int nsyms);
-      p25p1_fdma(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, gr::msg_queue::sptr queue, std::deque<int16_t> &output_queue, bool do_audio_output);
+	void reset();
+	// error counts since construction or the last reset()
+	void get_stats(decode_stats &stats);
+      p25p1_fdma(const char* udp_host, int port, int debug, bool do_imbe, bool do_output, bool do_msgq, trunk_msg_queue::sptr queue, sample_ring &output_queue, bool do_audio_output);
       ~p25p1_fdma();
 
       // Where all the action really happens
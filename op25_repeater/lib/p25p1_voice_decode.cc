@@ -29,6 +29,7 @@
 #include "p25p1_voice_decode.h"
 
 #include <vector>
+#include <algorithm>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -50,7 +51,7 @@ static void clear_bits(bit_vector& v) {
 	}
 }
 
-p25p1_voice_decode::p25p1_voice_decode(bool verbose_flag, const char* udp_host, int udp_port, std::deque<int16_t> &_output_queue) :
+p25p1_voice_decode::p25p1_voice_decode(bool verbose_flag, const char* udp_host, int udp_port, sample_ring &_output_queue) :
 	write_sock(0),
 	write_bufp(0),
 	rxbufp(0),
@@ -86,14 +87,12 @@ void p25p1_voice_decode::rxframe(const uint32_t u[])
 		imbe_header_encode(cw, u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7]);
 		software_decoder.decode(cw);
 		audio_samples *samples = software_decoder.audio();
-		for (int i=0; i < FRAME; i++) {
-			if (samples->size() > 0) {
-				snd[i] = (int16_t)(samples->front() * 32768.0);
-				samples->pop_front();
-			} else {
-				snd[i] = 0;
-			}
-		}
+		size_t n = std::min(samples->size(), (size_t) FRAME);
+		for (size_t i=0; i < n; i++)
+			snd[i] = (int16_t)((*samples)[i] * 32768.0);
+		for (size_t i=n; i < FRAME; i++)
+			snd[i] = 0;
+		software_decoder.consume(n);
 	} else {
 		for (int i=0; i < 8; i++) {
 			frame_vector[i] = u[i];
@@ -105,12 +104,20 @@ void p25p1_voice_decode::rxframe(const uint32_t u[])
 		sendto(write_sock, snd, FRAME * sizeof(int16_t), 0, (struct sockaddr*)&write_sock_addr, sizeof(write_sock_addr));
 	} else {
 		// add generated samples to output queue
-		for (int i = 0; i < FRAME; i++) {
-			output_queue.push_back(snd[i]);
-		}
+		output_queue.write(snd, FRAME);
 	}
 }
 
+/*
+ * Drop the synthesis history so the next call does not start with
+ * the tail of the last one.
+ */
+void p25p1_voice_decode::reset()
+{
+	rxbufp = 0;
+	vocoder = imbe_vocoder();
+}
+
 void p25p1_voice_decode::rxchar(const char* c, int len)
 {
 	uint32_t u[8];
@@ -25,7 +25,7 @@
 #include <netinet/in.h>
 #include <stdint.h>
 #include <vector>
-#include <deque>
+#include "op25_ring_buffer.h"
 
 #include "imbe_vocoder/imbe_vocoder.h"
 
@@ -42,10 +42,11 @@ namespace gr {
       // Nothing to declare in this block.
 
      public:
-      p25p1_voice_decode(bool verbose_flag, const char* udp_host, int udp_port, std::deque<int16_t> &_output_queue);
+      p25p1_voice_decode(bool verbose_flag, const char* udp_host, int udp_port, sample_ring &_output_queue);
       ~p25p1_voice_decode();
 	void rxframe(const uint32_t u[]);
 	void rxchar(const char* c, int len);
+	void reset();
 
   private:
 	static const int RXBUF_MAX = 80;
@@ -61,7 +62,7 @@ namespace gr {
 	software_imbe_decoder software_decoder;
 	bool d_software_imbe_decoder;
 
-	std::deque<int16_t> &output_queue;
+	sample_ring &output_queue;
 
 	bool opt_verbose;
 	int opt_udp_port;
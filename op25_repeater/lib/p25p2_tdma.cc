@@ -23,6 +23,7 @@
 #include <string>
 #include <iostream>
 #include <assert.h>
+#include <algorithm>
 
 #include "p25p2_duid.h"
 #include "p25p2_sync.h"
@@ -30,42 +31,30 @@
 #include "p25p2_vf.h"
 #include "mbelib.h"
 #include "ambe.h"
+#include "rs.h"
+#include "op25_crc.h"
 
 static const int BURST_SIZE = 180;
 static const int SUPERFRAME_SIZE = (12*BURST_SIZE);
 
-static uint16_t crc12(const uint8_t bits[], unsigned int len) {
-	uint16_t crc=0;
-	static const unsigned int K = 12;
-	static const uint8_t poly[K+1] = {1,1,0,0,0,1,0,0,1,0,1,1,1}; // p25 p2 crc 12 poly
-	uint8_t buf[256];
-	if (len+K > sizeof(buf)) {
-		fprintf (stderr, "crc12: buffer length %u exceeds maximum %lu\n", len+K, sizeof(buf));
-		return 0;
-	}
-	memset (buf, 0, sizeof(buf));
-	for (int i=0; i<len; i++){
-		buf[i] = bits[i];
-	}
-	for (int i=0; i<len; i++)
-		if (buf[i])
-			for (int j=0; j<K+1; j++)
-				buf[i+j] ^= poly[j];
-	for (int i=0; i<K; i++){
-		crc = (crc << 1) + buf[len + i];
-	}
-	return crc ^ 0xfff;
+static inline bool crc12_ok(const uint8_t buf[], unsigned int len) {
+	return (crc12_packed(buf, len) == get_packed_bits(buf, len, 12));
 }
 
-static bool crc12_ok(const uint8_t bits[], unsigned int len) {
-	uint16_t crc = 0;
-	for (int i=0; i < 12; i++) {
-		crc = (crc << 1) + bits[len+i];
-	}
-	return (crc == crc12(bits,len));
+// append count dibits to the packed bit buffer out[] at bit nbits,
+// a whole byte at a time once the write position is byte aligned
+static unsigned int pack_dibits(uint8_t out[], unsigned int nbits, const uint8_t dibits[], int count) {
+	int i = 0;
+	for (; i < count && (nbits & 7); i++, nbits += 2)
+		put_packed_bits(out, nbits, 2, dibits[i] & 3);
+	for (; i + 4 <= count; i += 4, nbits += 8)
+		out[nbits >> 3] = ((dibits[i] & 3) << 6) + ((dibits[i+1] & 3) << 4) + ((dibits[i+2] & 3) << 2) + (dibits[i+3] & 3);
+	for (; i < count; i++, nbits += 2)
+		put_packed_bits(out, nbits, 2, dibits[i] & 3);
+	return nbits;
 }
 
-p25p2_tdma::p25p2_tdma(int slotid, int debug, std::deque<int16_t> &qptr) :	// constructor
+p25p2_tdma::p25p2_tdma(int slotid, int debug, sample_ring &qptr) :	// constructor
 	tdma_xormask(new uint8_t[SUPERFRAME_SIZE]),
 	symbols_received(0),
 	packets(0),
@@ -73,6 +62,7 @@ p25p2_tdma::p25p2_tdma(int slotid, int debug, std::deque<int16_t> &qptr) :	// co
 	output_queue_decode(qptr),
 	d_debug(debug),
 	crc_errors(0),
+	rs_corrections(0),
 	p2framer()
 {
 	assert (slotid == 0 || slotid == 1);
@@ -112,54 +102,58 @@ int p25p2_tdma::process_mac_pdu(const uint8_t byte_buf[], unsigned int len)
 	// TODO: decode MAC PDU's
 }
 
+/*
+ * FACCH and SACCH are both sent as RS(63,35) over GF(64), shortened and
+ * punctured to (45,26) and (52,30) respectively. The received hexbits
+ * are placed after the shortened symbols, which are zero, and the
+ * punctured parity symbols are decoded as erasures. On success the
+ * corrected info hexbits (MAC PDU + CRC) are written back to buf[].
+ */
+bool p25p2_tdma::rs_correct_acch(uint8_t buf[], unsigned int nbits, bool fast)
+{
+	const int first = fast ? RS_FACCH_FIRST : RS_SACCH_FIRST;
+	const int ninfo = fast ? 26 : 30;
+	uint8_t HB[63];
+
+	memset(HB, 0, sizeof(HB));
+	for (unsigned int i=0; i + 6 <= nbits; i += 6)
+		HB[first + i/6] = get_packed_bits(buf, i, 6);
+	if (rsDecAcch(fast, HB) < 0)
+		return false;
+	for (int i=0; i < ninfo; i++)
+		put_packed_bits(buf, i*6, 6, HB[first + i]);
+	return true;
+}
+
 int p25p2_tdma::handle_acch_frame(const uint8_t dibits[], bool fast) 
 {
 	int rc = -1;
-	uint8_t bits[512];
-	uint8_t byte_buf[32];
-	unsigned int bufl=0;
+	uint8_t buf[48];	// 312 bits packed, plus slack for get_packed_bits()
+	unsigned int nbits=0;
 	unsigned int len=0;
+	memset(buf, 0, sizeof(buf));
 	if (fast) {
-		for (int i=11; i < 11+36; i++) {
-			bits[bufl++] = (dibits[i] >> 1) & 1;
-			bits[bufl++] = dibits[i] & 1;
-		}
-		for (int i=48; i < 48+31; i++) {
-			bits[bufl++] = (dibits[i] >> 1) & 1;
-			bits[bufl++] = dibits[i] & 1;
-		}
-		for (int i=100; i < 100+32; i++) {
-			bits[bufl++] = (dibits[i] >> 1) & 1;
-			bits[bufl++] = dibits[i] & 1;
-		}
-		for (int i=133; i < 133+36; i++) {
-			bits[bufl++] = (dibits[i] >> 1) & 1;
-			bits[bufl++] = dibits[i] & 1;
-		}
+		nbits = pack_dibits(buf, nbits, &dibits[11], 36);
+		nbits = pack_dibits(buf, nbits, &dibits[48], 31);
+		nbits = pack_dibits(buf, nbits, &dibits[100], 32);
+		nbits = pack_dibits(buf, nbits, &dibits[133], 36);
 	} else {
-		for (int i=11; i < 11+36; i++) {
-			bits[bufl++] = (dibits[i] >> 1) & 1;
-			bits[bufl++] = dibits[i] & 1;
-		}
-		for (int i=48; i < 48+84; i++) {
-			bits[bufl++] = (dibits[i] >> 1) & 1;
-			bits[bufl++] = dibits[i] & 1;
-		}
-		for (int i=133; i < 133+36; i++) {
-			bits[bufl++] = (dibits[i] >> 1) & 1;
-			bits[bufl++] = dibits[i] & 1;
-		}
+		nbits = pack_dibits(buf, nbits, &dibits[11], 36);
+		nbits = pack_dibits(buf, nbits, &dibits[48], 84);
+		nbits = pack_dibits(buf, nbits, &dibits[133], 36);
 	}
-	// FIXME: TODO: add RS decode
 	if (fast)
 		len = 144;
 	else
 		len = 168;
-	if (crc12_ok(bits, len)) {
-		for (int i=0; i<len/8; i++) {
-			byte_buf[i] = (bits[i*8 + 0] << 7) + (bits[i*8 + 1] << 6) + (bits[i*8 + 2] << 5) + (bits[i*8 + 3] << 4) + (bits[i*8 + 4] << 3) + (bits[i*8 + 5] << 2) + (bits[i*8 + 6] << 1) + (bits[i*8 + 7] << 0);
-		}
-		rc = process_mac_pdu(byte_buf, len/8);
+	bool crc_ok = crc12_ok(buf, len);
+	if (!crc_ok && rs_correct_acch(buf, nbits, fast) && crc12_ok(buf, len)) {
+		crc_ok = true;
+		rs_corrections++;
+	}
+	if (crc_ok) {
+		// the MAC PDU is the leading len bits, already packed MSB first
+		rc = process_mac_pdu(buf, len/8);
 	} else {
 		crc_errors++;
 	}
@@ -170,7 +164,7 @@ void p25p2_tdma::handle_voice_frame(const uint8_t dibits[])
 {
 	static const int NSAMP_OUTPUT=160;
 	int b[9];
-	int16_t snd;
+	int16_t snd[NSAMP_OUTPUT];
 	int K;
 	int rc = -1;
 
@@ -184,15 +178,13 @@ void p25p2_tdma::handle_voice_frame(const uint8_t dibits[])
 	if (rc == 0)
 		software_decoder.decode_tap(cur_mp.L, K, cur_mp.w0, &cur_mp.Vl[1], &cur_mp.Ml[1]);
 	audio_samples *samples = software_decoder.audio();
-	for (int i=0; i < NSAMP_OUTPUT; i++) {
-		if (samples->size() > 0) {
-			snd = (int16_t)(samples->front());
-			samples->pop_front();
-		} else {
-			snd = 0;
-		}
-		output_queue_decode.push_back(snd);
-	}
+	size_t n = std::min(samples->size(), (size_t) NSAMP_OUTPUT);
+	for (size_t i=0; i < n; i++)
+		snd[i] = (int16_t)((*samples)[i]);
+	for (size_t i=n; i < NSAMP_OUTPUT; i++)
+		snd[i] = 0;
+	software_decoder.consume(n);
+	output_queue_decode.write(snd, NSAMP_OUTPUT);
 	mbe_moveMbeParms (&cur_mp, &prev_mp);
 	mbe_moveMbeParms (&cur_mp, &enh_mp);
 }
@@ -21,7 +21,7 @@
 #define INCLUDED_P25P2_TDMA_H
 
 #include <stdint.h>
-#include <deque>
+#include "op25_ring_buffer.h"
 #include "mbelib.h"
 #include "imbe_decoder.h"
 #include "software_imbe_decoder.h"
@@ -34,7 +34,7 @@ class p25p2_tdma;
 class p25p2_tdma
 {
 public:
-	p25p2_tdma(int slotid, int debug, std::deque<int16_t> &qptr) ;	// constructor
+	p25p2_tdma(int slotid, int debug, sample_ring &qptr) ;	// constructor
 	int handle_packet(const uint8_t dibits[]) ;
 	void set_slotid(int slotid);
 	uint8_t* tdma_xormask;
@@ -53,14 +53,16 @@ private:
 	mbe_parms prev_mp;
 	mbe_parms enh_mp;
 	software_imbe_decoder software_decoder;
-	std::deque<int16_t> &output_queue_decode;
+	sample_ring &output_queue_decode;
 
 	int d_debug;
 	unsigned long int crc_errors;
+	unsigned long int rs_corrections;
 
 	p25p2_framer p2framer;
 
 	int handle_acch_frame(const uint8_t dibits[], bool fast) ;
+	bool rs_correct_acch(uint8_t buf[], unsigned int nbits, bool fast) ;
 	void handle_voice_frame(const uint8_t dibits[]) ;
 	int process_mac_pdu(const uint8_t byte_buf[], unsigned int len) ;
 };
@@ -0,0 +1,159 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "qa_imbe_vocoder.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+// the reference operators are declared globally, as basicop2.cc sees
+// them, and the inline ones are put in a namespace of their own
+#define IMBE_BASICOP_REFERENCE
+#include "imbe_vocoder/typedef.h"
+#include "imbe_vocoder/basic_op.h"
+namespace fast {
+#include "imbe_vocoder/basic_op_fast.h"
+}
+#include "imbe_vocoder/imbe_vocoder.h"
+
+static uint32_t
+lcg(uint32_t &seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 8;
+}
+
+static const Word16 edge16[] = {
+  MIN_16, MIN_16 + 1, -16384, -256, -2, -1, 0, 1, 2, 255, 16384, MAX_16 - 1, MAX_16
+};
+static const Word32 edge32[] = {
+  MIN_32, MIN_32 + 1, -1073741824, -65536, -32769, -32768, -2, -1,
+  0, 1, 2, 32767, 32768, 65536, 1073741824, MAX_32 - 1, MAX_32
+};
+static const int n_edge16 = sizeof(edge16) / sizeof(edge16[0]);
+static const int n_edge32 = sizeof(edge32) / sizeof(edge32[0]);
+
+#define CHECK_OP(op, ...) \
+  CPPUNIT_ASSERT_EQUAL(::op(__VA_ARGS__), fast::op(__VA_ARGS__))
+
+static void
+check_ops(Word16 a, Word16 b, Word32 la, Word32 lb)
+{
+  CHECK_OP(add, a, b);
+  CHECK_OP(sub, a, b);
+  CHECK_OP(abs_s, a);
+  CHECK_OP(negate, a);
+  CHECK_OP(extract_h, la);
+  CHECK_OP(extract_l, la);
+  CHECK_OP(mult, a, b);
+  CHECK_OP(L_mult, a, b);
+  CHECK_OP(L_add, la, lb);
+  CHECK_OP(L_sub, la, lb);
+  CHECK_OP(L_negate, la);
+  CHECK_OP(round, la);
+  CHECK_OP(L_mac, la, a, b);
+  CHECK_OP(L_msu, la, a, b);
+  CHECK_OP(mult_r, a, b);
+  CHECK_OP(mac_r, la, a, b);
+  CHECK_OP(msu_r, la, a, b);
+  CHECK_OP(L_deposit_h, a);
+  CHECK_OP(L_deposit_l, a);
+  CHECK_OP(L_abs, la);
+  CHECK_OP(norm_s, a);
+  CHECK_OP(norm_l, la);
+
+  // shift counts past the word size in both directions
+  Word16 shift = (Word16) (b % 40);
+  CHECK_OP(shl, a, shift);
+  CHECK_OP(shr, a, shift);
+  CHECK_OP(shr_r, a, shift);
+  CHECK_OP(L_shl, la, shift);
+  CHECK_OP(L_shr, la, shift);
+  CHECK_OP(L_shr_r, la, shift);
+
+  // div_s is only defined for 0 <= num <= den, den > 0
+  if (a != MIN_16 && b != MIN_16 && a != 0) {
+    Word16 num = fast::abs_s(b) < fast::abs_s(a) ? fast::abs_s(b) : fast::abs_s(a);
+    Word16 den = fast::abs_s(b) < fast::abs_s(a) ? fast::abs_s(a) : fast::abs_s(b);
+    CHECK_OP(div_s, num, den);
+  }
+}
+
+void
+qa_imbe_vocoder::t_basic_ops()
+{
+  for (int i = 0; i < n_edge16; i++)
+    for (int j = 0; j < n_edge16; j++)
+      for (int k = 0; k < n_edge32; k++)
+        check_ops(edge16[i], edge16[j], edge32[k], edge32[n_edge32 - 1 - k]);
+
+  uint32_t seed = 1;
+  for (int i = 0; i < 200000; i++) {
+    Word16 a = (Word16) lcg(seed);
+    Word16 b = (Word16) lcg(seed);
+    Word32 la = (Word32) ((lcg(seed) << 16) ^ lcg(seed));
+    Word32 lb = (Word32) ((lcg(seed) << 16) ^ lcg(seed));
+    check_ops(a, b, la, lb);
+  }
+}
+
+// FNV-1a over the samples, as little endian 16 bit words
+static void
+hash_words(uint64_t &hash, const int16_t *p, int n)
+{
+  for (int i = 0; i < n; i++) {
+    hash ^= (uint16_t) p[i];
+    hash *= 1099511628211ULL;
+  }
+}
+
+/*
+ * 1000 frames of random u0..u7 vectors, with every 50th all zeros or
+ * all ones, are decoded, and the decoded audio encoded again. The
+ * hashes are of the output of the vocoder before the inline
+ * operators and FFT tables went in; whichever way IMBE_FAST_BASICOP
+ * is set, the output has to be the same to the bit.
+ */
+void
+qa_imbe_vocoder::t_codeword_corpus()
+{
+  static const int bits[8] = { 12, 12, 12, 12, 11, 11, 11, 7 };
+  imbe_vocoder decoder, encoder;
+  int16_t u[8], snd[160];
+  uint64_t decoded = 14695981039346656037ULL;
+  uint64_t encoded = decoded;
+  uint32_t seed = 1;
+
+  for (int f = 0; f < 1000; f++) {
+    for (int i = 0; i < 8; i++)
+      u[i] = lcg(seed) & ((1 << bits[i]) - 1);
+    if (f % 50 == 0)
+      for (int i = 0; i < 8; i++)
+        u[i] = (f % 100) ? ((1 << bits[i]) - 1) : 0;
+    // as p25p1_voice_decode::rxframe() passes it
+    u[7] >>= 1;
+
+    decoder.imbe_decode(u, snd);
+    hash_words(decoded, snd, 160);
+    encoder.imbe_encode(u, snd);
+    hash_words(encoded, u, 8);
+  }
+
+  CPPUNIT_ASSERT_EQUAL((unsigned long long) 0xeafd39672d7f5fb9ULL, (unsigned long long) decoded);
+  CPPUNIT_ASSERT_EQUAL((unsigned long long) 0xe2d881647794a072ULL, (unsigned long long) encoded);
+}
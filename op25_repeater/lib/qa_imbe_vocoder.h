@@ -0,0 +1,42 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_IMBE_VOCODER_H_
+#define _QA_IMBE_VOCODER_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * The inline basic operators in basic_op_fast.h against the ETSI
+ * reference ones in basicop2.cc, and the vocoder as built against
+ * the output of the decoder before they were added.
+ */
+class qa_imbe_vocoder : public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(qa_imbe_vocoder);
+  CPPUNIT_TEST(t_basic_ops);
+  CPPUNIT_TEST(t_codeword_corpus);
+  CPPUNIT_TEST_SUITE_END();
+
+ private:
+  void t_basic_ops();
+  void t_codeword_corpus();
+};
+
+#endif /* _QA_IMBE_VOCODER_H_ */
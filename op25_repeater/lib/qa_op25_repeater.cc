@@ -26,11 +26,17 @@
  */
 
 #include "qa_op25_repeater.h"
+#include "qa_imbe_vocoder.h"
+#include "qa_rs.h"
+#include "qa_p25_framer.h"
 
 CppUnit::TestSuite *
 qa_op25_repeater::suite()
 {
   CppUnit::TestSuite *s = new CppUnit::TestSuite("op25_repeater");
+  s->addTest(qa_imbe_vocoder::suite());
+  s->addTest(qa_rs::suite());
+  s->addTest(qa_p25_framer::suite());
 
   return s;
 }
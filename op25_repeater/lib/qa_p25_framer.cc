@@ -0,0 +1,152 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "qa_p25_framer.h"
+
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include <bch.h>
+#include <op25_p25_frame.h>
+#include <p25_framer.h>
+
+static const uint32_t NAC = 0x293;
+static const uint32_t DUID = 5;  // ldu1
+
+// dibits in a voice frame, status dibits included
+static const int FRAME_DIBITS = P25_VOICE_FRAME_SIZE / 2;
+
+static uint32_t
+lcg(uint32_t &seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 8;
+}
+
+/*
+ * The 64 bit NID: NAC and DUID, BCH (63,16) parity worked out from the
+ * generator polynomial, and the parity bit bch.cc leaves alone.
+ */
+static uint64_t
+nid_word(uint32_t nac, uint32_t duid)
+{
+  static const int g[48] = {
+    1, 1, 0, 1, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1, 0, 0,
+    1, 0, 1, 1, 1, 0, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0,
+    1, 1, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 0, 0, 1, 1
+  };
+  uint64_t gen = 0;
+  for (int i = 0; i < 48; i++)
+    gen |= (uint64_t) g[i] << i;
+
+  uint64_t data = (nac << 4) | duid;
+  uint64_t rem = data << 47;
+  for (int i = 62; i >= 47; i--)
+    if ((rem >> i) & 1)
+      rem ^= gen << (i - 47);
+  return ((data << 47) | rem) << 1;
+}
+
+/*
+ * One frame as dibits: frame sync (left out if sync is false), the NID
+ * with the status dibit after its first 11 dibits, and random dibits
+ * for the rest of the voice frame.
+ */
+static void
+add_frame(std::vector<uint8_t> &dibits, uint32_t &seed, bool sync, uint64_t nid)
+{
+  size_t start = dibits.size();
+  for (int i = 23; i >= 0; i--)
+    dibits.push_back(sync ? (P25_FRAME_SYNC_MAGIC >> (i * 2)) & 3 : lcg(seed) & 3);
+  for (int i = 31; i >= 0; i--) {
+    dibits.push_back((nid >> (i * 2)) & 3);
+    if (i == 21)
+      dibits.push_back(lcg(seed) & 3);
+  }
+  while (dibits.size() < start + FRAME_DIBITS)
+    dibits.push_back(lcg(seed) & 3);
+}
+
+static void
+run(p25_framer &framer, const std::vector<uint8_t> &dibits)
+{
+  for (size_t i = 0; i < dibits.size(); i++)
+    framer.rx_sym(dibits[i]);
+}
+
+/*
+ * Four frames with the third one's sync lost: three syncs, and the
+ * gap before the last one counts as one loss. The NIDs all decode.
+ */
+void
+qa_p25_framer::t_sync_loss()
+{
+  uint32_t seed = 1;
+  std::vector<uint8_t> dibits;
+  for (int i = 0; i < 4; i++)
+    add_frame(dibits, seed, i != 2, nid_word(NAC, DUID));
+  // the last frame is only complete when the next sync turns up
+  add_frame(dibits, seed, true, nid_word(NAC, DUID));
+
+  p25_framer framer;
+  run(framer, dibits);
+  CPPUNIT_ASSERT_EQUAL(dibits.size(), (size_t) framer.symbols_received);
+  CPPUNIT_ASSERT_EQUAL(4u, framer.frame_syncs);
+  CPPUNIT_ASSERT_EQUAL(1u, framer.sync_losses);
+  CPPUNIT_ASSERT_EQUAL(4u, framer.frames);
+  CPPUNIT_ASSERT_EQUAL(0u, framer.nid_errors);
+  CPPUNIT_ASSERT_EQUAL(0u, framer.bch_error_total);
+  CPPUNIT_ASSERT_EQUAL(NAC, framer.nac);
+  CPPUNIT_ASSERT_EQUAL(DUID, framer.duid);
+
+  // a sync in every frame is never a loss
+  p25_framer steady;
+  dibits.clear();
+  for (int i = 0; i < 20; i++)
+    add_frame(dibits, seed, true, nid_word(NAC, DUID));
+  run(steady, dibits);
+  CPPUNIT_ASSERT_EQUAL(20u, steady.frame_syncs);
+  CPPUNIT_ASSERT_EQUAL(0u, steady.sync_losses);
+}
+
+/*
+ * NIDs with a few bit errors are corrected and the corrections added
+ * up; one with far too many is counted as a NID error, not a frame.
+ */
+void
+qa_p25_framer::t_nid_errors()
+{
+  uint32_t seed = 2;
+  uint64_t nid = nid_word(NAC, DUID);
+  std::vector<uint8_t> dibits;
+  // bit 0 is the parity bit, which the BCH does not cover
+  add_frame(dibits, seed, true, nid ^ (1ULL << 9));
+  add_frame(dibits, seed, true, nid ^ (1ULL << 20) ^ (1ULL << 41) ^ (1ULL << 63));
+  add_frame(dibits, seed, true, nid ^ 0x5555555555555554ULL);
+  add_frame(dibits, seed, true, nid);
+
+  p25_framer framer;
+  run(framer, dibits);
+  CPPUNIT_ASSERT_EQUAL(4u, framer.frame_syncs);
+  CPPUNIT_ASSERT_EQUAL(0u, framer.sync_losses);
+  CPPUNIT_ASSERT_EQUAL(3u, framer.frames);
+  CPPUNIT_ASSERT_EQUAL(1u, framer.nid_errors);
+  CPPUNIT_ASSERT_EQUAL(4u, framer.bch_error_total);
+  CPPUNIT_ASSERT_EQUAL(NAC, framer.nac);
+  CPPUNIT_ASSERT_EQUAL(DUID, framer.duid);
+}
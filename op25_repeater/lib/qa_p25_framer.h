@@ -0,0 +1,42 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_P25_FRAMER_H_
+#define _QA_P25_FRAMER_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * The decode counters of p25_framer: frame syncs, syncs missed
+ * between them, and NIDs decoded with and without BCH corrections,
+ * on dibit streams of frames built here.
+ */
+class qa_p25_framer : public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(qa_p25_framer);
+  CPPUNIT_TEST(t_sync_loss);
+  CPPUNIT_TEST(t_nid_errors);
+  CPPUNIT_TEST_SUITE_END();
+
+ private:
+  void t_sync_loss();
+  void t_nid_errors();
+};
+
+#endif /* _QA_P25_FRAMER_H_ */
@@ -0,0 +1,255 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "qa_rs.h"
+#include "rs.h"
+#include "op25_golay.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static uint32_t
+lcg(uint32_t &seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 8;
+}
+
+/*
+ * GF(64) from x^6 + x + 1, the field of the P25 RS codes, worked out
+ * here the slow way so the test does not share rs.cc's tables.
+ */
+static int
+gf_mul(int a, int b)
+{
+  int p = 0;
+  while (b) {
+    if (b & 1)
+      p ^= a;
+    b >>= 1;
+    a <<= 1;
+    if (a & 0x40)
+      a ^= 0x43;
+  }
+  return p;
+}
+
+/*
+ * Systematic RS(63,63-nroots) encode with generator roots a^1 ..
+ * a^nroots, as the P25 codes are defined. HB[0..k-1] is the data,
+ * highest order first, and the parity goes in HB[k..62].
+ */
+static void
+rs_encode(int nroots, uint8_t HB[63])
+{
+  int g[RS_MAX_ROOTS + 1];
+  int alpha = 1;
+  memset(g, 0, sizeof(g));
+  g[0] = 1;
+  for (int r = 1; r <= nroots; r++) {
+    alpha = gf_mul(alpha, 2);
+    for (int i = r; i > 0; i--)
+      g[i] = g[i - 1] ^ gf_mul(g[i], alpha);
+    g[0] = gf_mul(g[0], alpha);
+  }
+
+  int k = 63 - nroots;
+  uint8_t rem[RS_MAX_ROOTS];
+  memset(rem, 0, sizeof(rem));
+  for (int i = 0; i < k; i++) {
+    int feedback = HB[i] ^ rem[nroots - 1];
+    for (int j = nroots - 1; j > 0; j--)
+      rem[j] = rem[j - 1] ^ gf_mul(feedback, g[j]);
+    rem[0] = gf_mul(feedback, g[0]);
+  }
+  for (int j = 0; j < nroots; j++)
+    HB[k + j] = rem[nroots - 1 - j];
+}
+
+// a shortened codeword: zeros before first, random data up to the parity
+static void
+random_codeword(uint32_t &seed, int nroots, int first, uint8_t HB[63])
+{
+  memset(HB, 0, 63);
+  for (int i = first; i < 63 - nroots; i++)
+    HB[i] = lcg(seed) & 63;
+  rs_encode(nroots, HB);
+}
+
+// n symbol errors at distinct positions from first on
+static void
+add_errors(uint32_t &seed, uint8_t HB[63], int first, int n, const bool skip[63] = NULL)
+{
+  bool hit[63];
+  memset(hit, 0, sizeof(hit));
+  while (n > 0) {
+    int p = first + lcg(seed) % (63 - first);
+    if (hit[p] || (skip && skip[p]))
+      continue;
+    hit[p] = true;
+    HB[p] ^= 1 + lcg(seed) % 63;
+    n--;
+  }
+}
+
+/*
+ * Every code in use - the HDU (36,20,17), LDU1 (24,12,13), TDU (24,16,9)
+ * and the Phase 2 mother code (63,35,29) - with up to nroots/2 errors
+ * is corrected and the count returned. With one too many it has to
+ * fail or at least not claim the original codeword.
+ */
+void
+qa_rs::t_rs_errors()
+{
+  static const int nroots[] = { 16, 12, 8, 28 };
+  static const int first[] = { 27, 39, 39, 0 };
+  uint32_t seed = 1;
+
+  for (int c = 0; c < 4; c++) {
+    for (int t = 0; t < 5000; t++) {
+      uint8_t sent[63], HB[63];
+      random_codeword(seed, nroots[c], first[c], sent);
+      memcpy(HB, sent, 63);
+      int errors = t % (nroots[c] / 2 + 1);
+      add_errors(seed, HB, first[c], errors);
+
+      CPPUNIT_ASSERT_EQUAL(errors, rsDec(nroots[c], first[c], HB));
+      CPPUNIT_ASSERT(memcmp(HB, sent, 63) == 0);
+
+      memcpy(HB, sent, 63);
+      add_errors(seed, HB, first[c], nroots[c] / 2 + 1);
+      if (rsDec(nroots[c], first[c], HB) >= 0)
+        CPPUNIT_ASSERT(memcmp(HB, sent, 63) != 0);
+    }
+  }
+}
+
+/*
+ * The Phase 2 FACCH and SACCH, RS(63,35) shortened to (45,26) and
+ * (52,30) and punctured, decoded with rsDecAcch as p25p2_tdma does:
+ * with the 9 or 6 punctured parity symbols erased that leaves room for
+ * (28 - 9) / 2 = 9 and (28 - 6) / 2 = 11 errors. With more than that
+ * a decode can still come out, but never by putting anything in the
+ * shortened symbols, which are known to be zero.
+ */
+void
+qa_rs::t_rs_erasures()
+{
+  static const bool fast[] = { true, false };
+  static const int first[] = { RS_FACCH_FIRST, RS_SACCH_FIRST };
+  static const int punctured[] = { 9, 6 };
+  static const int max_errors[] = { 9, 11 };
+  uint32_t seed = 2;
+
+  for (int c = 0; c < 2; c++) {
+    bool erased[63];
+    memset(erased, 0, sizeof(erased));
+    for (int i = 63 - punctured[c]; i < 63; i++)
+      erased[i] = true;
+
+    for (int t = 0; t < 5000; t++) {
+      uint8_t sent[63], HB[63];
+      random_codeword(seed, 28, first[c], sent);
+      memcpy(HB, sent, 63);
+      // whatever is there, the punctured symbols were never sent
+      for (int i = 63 - punctured[c]; i < 63; i++)
+        HB[i] = lcg(seed) & 63;
+      add_errors(seed, HB, first[c], t % (max_errors[c] + 1), erased);
+
+      CPPUNIT_ASSERT(rsDecAcch(fast[c], HB) >= 0);
+      CPPUNIT_ASSERT(memcmp(HB, sent, 63) == 0);
+
+      memcpy(HB, sent, 63);
+      add_errors(seed, HB, first[c], max_errors[c] + 1 + t % 4, erased);
+      if (rsDecAcch(fast[c], HB) >= 0) {
+        for (int i = 0; i < first[c]; i++)
+          CPPUNIT_ASSERT_EQUAL(0, (int) HB[i]);
+      }
+    }
+  }
+}
+
+// every 12 bit value with every error pattern of up to 3 bits
+void
+qa_rs::t_golay()
+{
+  static const int MAX_PATTERNS = 2048;
+  uint32_t patterns[MAX_PATTERNS];
+  int n = 0;
+  patterns[n++] = 0;
+  for (int a = 0; a < 23; a++) {
+    patterns[n++] = 1 << a;
+    for (int b = a + 1; b < 23; b++) {
+      patterns[n++] = (1 << a) | (1 << b);
+      for (int c = b + 1; c < 23; c++)
+        patterns[n++] = (1 << a) | (1 << b) | (1 << c);
+    }
+  }
+  CPPUNIT_ASSERT_EQUAL(MAX_PATTERNS, n);
+
+  uint32_t batch_in[MAX_PATTERNS], batch_out[MAX_PATTERNS];
+  for (uint32_t data = 0; data < 4096; data++) {
+    uint32_t cw23 = golay_23_encode(data);
+    uint32_t cw24 = golay_24_encode(data);
+    for (int i = 0; i < n; i++) {
+      CPPUNIT_ASSERT_EQUAL(data, gly23127Dec(cw23 ^ patterns[i]));
+      // the (24,12) parity bit is thrown away, flip it as well
+      batch_in[i] = cw24 ^ (patterns[i] << 1) ^ (i & 1);
+    }
+    gly24128DecBatch(batch_in, batch_out, n);
+    for (int i = 0; i < n; i++) {
+      CPPUNIT_ASSERT_EQUAL(data, batch_out[i]);
+      CPPUNIT_ASSERT_EQUAL(data, gly24128Dec(batch_in[i]));
+    }
+  }
+}
+
+/*
+ * Hamming (10,6,3): each of the 6 data bits, most significant first,
+ * adds a row of the generator matrix's parity to the 4 check bits.
+ */
+static uint32_t
+hamming_parity(uint32_t data)
+{
+  static const uint32_t rows[6] = { 016, 015, 013, 007, 003, 014 };
+  uint32_t parity = 0;
+  for (int i = 0; i < 6; i++)
+    if (data & (040 >> i))
+      parity ^= rows[i];
+  return parity;
+}
+
+// every 6 bit value with no error and with each single bit error
+void
+qa_rs::t_hamming()
+{
+  for (uint32_t data = 0; data < 64; data++) {
+    uint32_t cw = (data << 4) | hamming_parity(data);
+    uint32_t in[11];
+    uint8_t out[11];
+    in[0] = cw;
+    for (int bit = 0; bit < 10; bit++)
+      in[bit + 1] = cw ^ (1 << bit);
+
+    hmg1063DecBatch(in, out, 11);
+    for (int i = 0; i < 11; i++) {
+      CPPUNIT_ASSERT_EQUAL((int) data, (int) out[i]);
+      CPPUNIT_ASSERT_EQUAL((int) data, hmg1063Dec(in[i] >> 4, in[i] & 0xF));
+    }
+  }
+}
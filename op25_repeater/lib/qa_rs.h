@@ -0,0 +1,46 @@
+/* -*- c++ -*- */
+/*
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _QA_RS_H_
+#define _QA_RS_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * The table-driven decoders in rs.cc: Reed-Solomon with and without
+ * erasures, Golay (23,12) / (24,12) and Hamming (10,6,3), against
+ * codewords encoded here from the generator polynomials.
+ */
+class qa_rs : public CppUnit::TestCase
+{
+  CPPUNIT_TEST_SUITE(qa_rs);
+  CPPUNIT_TEST(t_rs_errors);
+  CPPUNIT_TEST(t_rs_erasures);
+  CPPUNIT_TEST(t_golay);
+  CPPUNIT_TEST(t_hamming);
+  CPPUNIT_TEST_SUITE_END();
+
+ private:
+  void t_rs_errors();
+  void t_rs_erasures();
+  void t_golay();
+  void t_hamming();
+};
+
+#endif /* _QA_RS_H_ */
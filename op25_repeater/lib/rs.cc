@@ -5,6 +5,7 @@
 #include <vector>
 #include <assert.h>
 #include <op25_imbe_frame.h>
+#include "rs.h"
 
 #ifdef DEBUG
 /*
@@ -222,46 +223,102 @@ static const uint32_t rsGFlog[64] = {
 	5, 62, 25, 11, 34, 31, 17, 47, 15, 23, 53, 51, 37, 44, 55, 40, 
 	10, 61, 46, 30, 50, 22, 39, 43, 29, 60, 42, 21, 20, 59, 57, 58 };
 
+/*
+ * Lookup tables built once at startup:
+ *  - exp table extended past 63 so index form sums need no modulo
+ *  - per-position syndrome exponents, (i+1)*(62-j) mod 63
+ *  - Golay (23,12) syndrome of the 12 high order bits
+ */
+class fec_tables {
+public:
+	uint8_t gf_exp[2 * 63];
+	uint8_t syn_exp[63][RS_MAX_ROOTS];
+	uint16_t gly_syn[4096];
+
+	fec_tables() {
+		for (int i = 0; i < 2 * 63; i++)
+			gf_exp[i] = rsGFexp[i % 63];
+		for (int j = 0; j < 63; j++)
+			for (int i = 0; i < RS_MAX_ROOTS; i++)
+				syn_exp[j][i] = ((i + 1) * (62 - j)) % 63;
+		for (uint32_t hi = 0; hi < 4096; hi++) {
+			uint32_t pattern = hi << 11;
+			uint32_t aux = 0x400000;
+			while(pattern & 0xFFFFF800) {
+				while ((aux & pattern) == 0)
+					aux = aux >> 1;
+				pattern = pattern ^ (aux / 0x800 * 0xC75) ;//generator is C75
+			}
+			gly_syn[hi] = pattern;
+		}
+	}
+};
+
+static const fec_tables fec;
+static const uint8_t *const gfExp = fec.gf_exp;
+
 int hmg1063Dec (uint32_t Dat, uint32_t Par) {
 	assert ((Dat < 64) && (Par < 16));
 	return Dat ^ hmg1063DecTbl [ hmg1063EncTbl[Dat] ^ Par];
 }
 
+void hmg1063DecBatch (const uint32_t CW[], uint8_t HB[], int n) {
+	for (int i = 0; i < n; i++)
+		HB[i] = (CW[i] >> 4) ^ hmg1063DecTbl [ hmg1063EncTbl[CW[i] >> 4] ^ (CW[i] & 0xF)];
+}
+
 int
 rsDec (int nroots, int FirstInfo, uint8_t HB[]) {
+	return rsDecErasures(nroots, FirstInfo, HB, NULL, 0);
+}
+
+int
+rsDecAcch (bool fast, uint8_t HB[]) {
+	// only the punctured parity is unknown, the shortened symbols are
+	// known to be zero and a correction there is a failure
+	static const int facch_eras[] = {54,55,56,57,58,59,60,61,62};
+	static const int sacch_eras[] = {57,58,59,60,61,62};
+	if (fast)
+		return rsDecErasures(28, RS_FACCH_FIRST, HB, facch_eras, sizeof(facch_eras)/sizeof(int));
+	return rsDecErasures(28, RS_SACCH_FIRST, HB, sacch_eras, sizeof(sacch_eras)/sizeof(int));
+}
+
+int
+rsDecErasures (int nroots, int FirstInfo, uint8_t HB[], const int Eras[], int NoEras) {
 
 //RS (63,63-nroots,nroots+1) decoder where nroots = number of parity bits
 // rsDec(8, 39) rsDec(16, 27) rsDec(12, 39)
+//Eras[] holds the positions (HB index) of up to nroots erased symbols
 
+int lambda[RS_MAX_ROOTS + 2]   ;//Err+Eras Locator poly
+int S[RS_MAX_ROOTS + 1]        ;//syndrome poly
+int b[RS_MAX_ROOTS + 2] ;
+int t[RS_MAX_ROOTS + 2] ;
+int omega[RS_MAX_ROOTS + 2] ;
+int root[RS_MAX_ROOTS + 1] ;
+int reg[RS_MAX_ROOTS + 2] ;
+int locn[RS_MAX_ROOTS + 1] ;
 
-int lambda[18]   ;//Err+Eras Locator poly
-int S[17]        ;//syndrome poly
-int b[18] ;
-int t[18] ;
-int omega[18] ;
-int root[17] ;
-int reg[18] ;
-int locn[17] ;
+int i,j, count, r, el, SynError, DiscrR, q, DegOmega, tmp, num1, den, DegLambda, u;
 
-int i,j, count, r, el, SynError, DiscrR, q, DegOmega, tmp, num1, num2, den, DegLambda;
+assert (nroots <= RS_MAX_ROOTS && NoEras <= nroots);
 
 //form the syndromes; i.e., evaluate HB(x) at roots of g(x)
+//zero symbols (all of the shortened part of the code) cost nothing
 
 for (i = 0; i <= nroots - 1; i++) {
-  S[i] = HB[0];
+  S[i] = 0;
 }
-for (j = 1; j <= 62; j++) {
+for (j = 0; j <= 62; j++) {
+  if (HB[j] == 0)
+    continue;
+  const int lv = rsGFlog[HB[j]];
+  const uint8_t *se = fec.syn_exp[j];
   for (i = 0; i <= nroots - 1; i++) {
-    if (S[i] == 0) {
-      S[i] = HB[j];
-    } else {
-      S[i] = HB[j] ^ rsGFexp[(rsGFlog[S[i]] + i + 1) % 63];
-    }
+    S[i] ^= gfExp[lv + se[i]];
   }
 }
 
-
-
 //convert syndromes to index form, checking for nonzero condition
 
 SynError = 0;
@@ -274,33 +331,44 @@ for (i = 0; i <= nroots - 1; i++) {
 if (SynError == 0) {
   //if syndrome is zero, rsData[] is a codeword and there are
   //no errors to correct. So return rsData[] unmodified
-  count = 0;
-  goto rsDecFinish;
+  return 0;
 }
 
-for (i = 1; i <= nroots; i++) {
+for (i = 1; i <= nroots + 1; i++) {
 	lambda[i] = 0;
 }
 lambda[0] = 1;
 
+//init lambda to the erasure locator polynomial
+if (NoEras > 0) {
+  lambda[1] = gfExp[62 - Eras[0]];
+  for (i = 1; i < NoEras; i++) {
+    u = 62 - Eras[i];
+    for (j = i + 1; j > 0; j--) {
+      tmp = rsGFlog[lambda[j - 1]];
+      if (tmp != 63) {
+        lambda[j] ^= gfExp[u + tmp];
+      }
+    }
+  }
+}
+
 for (i = 0; i <= nroots; i++) {
   b[i] = rsGFlog[lambda[i]];
 }
 
-
-
 //begin Berlekamp-Massey algorithm to determine error+erasure
 //locator polynomial
 
-r = 0;
-el = 0;
+r = NoEras;
+el = NoEras;
 while ( r < nroots) { //r is the step number
   r = r + 1;
   //compute discrepancy at the r-th step in poly-form
   DiscrR = 0;
   for (i = 0; i <= r - 1; i++) {
     if ((lambda[i] != 0) && (S[r - i - 1] != 63)) {
-      DiscrR = DiscrR ^ rsGFexp[(rsGFlog[lambda[i]] + S[r - i - 1]) % 63];
+      DiscrR = DiscrR ^ gfExp[rsGFlog[lambda[i]] + S[r - i - 1]];
     }
   }
   DiscrR = rsGFlog[DiscrR] ;//index form
@@ -313,16 +381,16 @@ while ( r < nroots) { //r is the step number
     t[0] = lambda[0];
     for (i = 0; i <= nroots - 1; i++) {
       if (b[i] != 63) {
-        t[i + 1] = lambda[i + 1] ^ rsGFexp[(DiscrR + b[i]) % 63];
+        t[i + 1] = lambda[i + 1] ^ gfExp[DiscrR + b[i]];
       } else {
         t[i + 1] = lambda[i + 1];
       }
     }
-    if (2 * el <= r - 1) {
-      el = r - el;
+    if (2 * el <= r + NoEras - 1) {
+      el = r + NoEras - el;
       //b(x) <-- inv(DiscrR) * lambda(x)
       for (i = 0; i <= nroots; i++) {
-        if (lambda[i]) { b[i] = (rsGFlog[lambda[i]] - DiscrR + 63) % 63; } else { b[i] = 63; }
+        if (lambda[i]) { b[i] = rsGFlog[lambda[i]] - DiscrR + 63; if (b[i] >= 63) b[i] -= 63; } else { b[i] = 63; }
       }
     } else {
       //shift elements upward one step
@@ -332,8 +400,6 @@ while ( r < nroots) { //r is the step number
   }
 }   /* end while() */
 
-
-
 //convert lambda to index form and compute deg(lambda(x))
 
 DegLambda = 0;
@@ -342,8 +408,6 @@ for (i = 0; i <= nroots; i++) {
   if (lambda[i] != 63) { DegLambda = i; }
 }
 
-
-
 //Find roots of the error+erasure locator polynomial by Chien search
 
 for (i = 1; i <= nroots; i++) { reg[i] = lambda[i]; }
@@ -352,8 +416,9 @@ for (i = 1; i <= 63; i++) {
   q = 1 ;//lambda[0] is always 0
   for (j = DegLambda; j >= 1; j += -1) {
     if (reg[j] != 63) {
-      reg[j] = (reg[j] + j) % 63;
-      q = q ^ rsGFexp[reg[j]];
+      reg[j] += j;
+      if (reg[j] >= 63) reg[j] -= 63;
+      q = q ^ gfExp[reg[j]];
     }
   }
   if (q == 0) { //it is a root
@@ -367,12 +432,9 @@ for (i = 1; i <= 63; i++) {
 
 if (DegLambda != count) {
   //deg(lambda) unequal to number of roots => uncorrectable error detected
-  count = -1;
-  goto rsDecFinish;
+  return -1;
 }
 
-
-
 //compute err+eras evaluator poly omega(x)
 // = s(x)*lambda(x) (modulo x**nroots). in index form. Also find deg(omega).
 
@@ -382,7 +444,7 @@ for (i = 0; i <= nroots - 1; i++) {
   if (DegLambda < i) { j = DegLambda; } else { j = i; }
   for ( /* j = j */ ; j >= 0; j += -1) {
     if ((S[i - j] != 63) && (lambda[j] != 63)) {
-      tmp = tmp ^ rsGFexp[(S[i - j] + lambda[j]) % 63];
+      tmp = tmp ^ gfExp[S[i - j] + lambda[j]];
     }
   }
   if (tmp) { DegOmega = i; }
@@ -390,40 +452,36 @@ for (i = 0; i <= nroots - 1; i++) {
 }
 omega[nroots] = 63;
 
-
 //compute error values in poly-form:
 // num1 = omega(inv(X(l)))
-// num2 = inv(X(l))**(FCR - 1)
+// num2 = inv(X(l))**(FCR - 1) = 1 for FCR 1
 // den = lambda_pr(inv(X(l)))
 
 for (j = count - 1; j >= 0; j += -1) {
   num1 = 0;
   for (i = DegOmega; i >= 0; i += -1) {
     if (omega[i] != 63) {
-      num1 = num1 ^ rsGFexp[(omega[i] + i * root[j]) % 63];
+      num1 = num1 ^ gfExp[(omega[i] + i * root[j]) % 63];
     }
   }
-  num2 = rsGFexp[0];
   den = 0;
 
   // lambda[i+1] for i even is the formal derivative lambda_pr of lambda[i]
-  if (DegLambda < nroots) { i = DegLambda; } else { i = nroots; }
+  if (DegLambda < nroots - 1) { i = DegLambda; } else { i = nroots - 1; }
   for (i = i & ~1; i >= 0; i += -2) {
     if (lambda[i + 1] != 63) {
-      den = den ^ rsGFexp[(lambda[i + 1] + i * root[j]) % 63];
+      den = den ^ gfExp[(lambda[i + 1] + i * root[j]) % 63];
     }
   }
-  if (den == 0) { count = -1; goto rsDecFinish; }
- 
+  if (den == 0) { return -1; }
+
   // apply error to data
   if (num1 != 0) {
-    if (locn[j] < FirstInfo) { count = -1; goto rsDecFinish ; } //added by me 
-    HB[locn[j]] = HB[locn[j]] ^ (rsGFexp[(rsGFlog[num1] + rsGFlog[num2] + 63 - rsGFlog[den]) % 63]);
+    if (locn[j] < FirstInfo) { return -1; } //added by me
+    HB[locn[j]] = HB[locn[j]] ^ gfExp[rsGFlog[num1] + 63 - rsGFlog[den]];
   }
 }
 
-
-rsDecFinish:
 return (count);
 
 }
@@ -434,16 +492,9 @@ return (count);
 
 uint32_t gly23127GetSyn (uint32_t pattern) {
 
-uint32_t aux = 0x400000;
-
-while(pattern & 0xFFFFF800) {
-  while ((aux & pattern) == 0) {
-    aux = aux >> 1;
-  }
-  pattern = pattern ^ (aux / 0x800 * 0xC75) ;//generator is C75
-}
-
-return pattern;
+// the syndrome is linear: reduce the 12 high bits by table and
+// fold in the 11 low (parity) bits as they are already reduced
+return fec.gly_syn[(pattern >> 11) & 0xFFF] ^ (pattern & 0x7FF);
 
 }
 
@@ -464,6 +515,13 @@ uint32_t gly23127Dec (uint32_t CW) {
 	return CW;
 }
 
+void gly24128DecBatch (const uint32_t CW[], uint32_t D[], int n) {
+	for (int i = 0; i < n; i++) {
+		uint32_t c = CW[i] >> 1;
+		D[i] = (c ^ gly23127DecTbl[gly23127GetSyn(c)]) >> 11;
+	}
+}
+
 void ProcHDU(const_bit_vector A) {
 int i, j, k, ec;
 uint8_t HB[63];   // "hexbit" array
@@ -475,13 +533,18 @@ uint8_t HB[63];   // "hexbit" array
 for (i = 0; i <= 26; i++) {
   HB[i] = 0;
 }
+uint32_t CW[36];
+uint32_t D[36];
 k = 0;
 for (i = 0; i < 36; i ++) { // 36 codewords
-  uint32_t CW = 0;
+  CW[i] = 0;
   for (j = 0; j < 18; j++) {  // 18 bits / cw
-    CW = (CW << 1) + A [ hdu_codeword_bits[k++] ];
+    CW[i] = (CW[i] << 1) + A [ hdu_codeword_bits[k++] ];
   }
-  HB[27 + i] = gly24128Dec(CW) & 63;
+}
+gly24128DecBatch(CW, D, 36);
+for (i = 0; i < 36; i ++) {
+  HB[27 + i] = D[i] & 63;
 }
 
 //do (36,20,17) RS decode
@@ -507,14 +570,15 @@ int i, j, k;
 for (i = 0; i <= 38; i++) {
   HB[i] = 0;
 }
+uint32_t CW[24];
 k = 0;
 for (i = 0; i < 24; i ++) { // 24 10-bit codewords
-  uint32_t CW = 0;
+  CW[i] = 0;
   for (j = 0; j < 10; j++) {  // 10 bits / cw
-    CW = (CW << 1) + A [ imbe_ldu_ls_data_bits[k++] ];
+    CW[i] = (CW[i] << 1) + A [ imbe_ldu_ls_data_bits[k++] ];
   }
-  HB[39 + i] = hmg1063Dec( CW >> 4, CW & 0xF );
 }
+hmg1063DecBatch(CW, &HB[39], 24);
 
 }
 
@@ -556,16 +620,20 @@ int i, j, k;
 for (i = 0; i <= 38; i++) {
   HB[i] = 0;
 }
+uint32_t CW[12];
+uint32_t D[12];
 k = 0;
-for (i = 0; i <= 22; i += 2) {
-  uint32_t CW = 0;
+for (i = 0; i < 12; i++) {
+  CW[i] = 0;
   for (j = 0; j < 12; j++) {   // 12 24-bit codewords
-    CW = (CW << 1) + A [ hdu_codeword_bits[k++] ];
-    CW = (CW << 1) + A [ hdu_codeword_bits[k++] ];
+    CW[i] = (CW[i] << 1) + A [ hdu_codeword_bits[k++] ];
+    CW[i] = (CW[i] << 1) + A [ hdu_codeword_bits[k++] ];
   }
-  uint32_t D = gly24128Dec(CW);
-  HB[39 + i] = D >> 6;
-  HB[40 + i] = D & 63;
+}
+gly24128DecBatch(CW, D, 12);
+for (i = 0; i < 12; i++) {
+  HB[39 + 2 * i] = D[i] >> 6;
+  HB[40 + 2 * i] = D[i] & 63;
 }
 ProcLC(HB);
 }
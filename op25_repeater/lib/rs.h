@@ -14,4 +14,31 @@ void ProcLDU2(const_bit_vector A);
 uint32_t gly24128Dec (uint32_t n) ;
 uint32_t gly23127Dec (uint32_t n) ;
 
+// maximum number of RS(63,k) parity symbols handled by the decoders
+// (28 for the P25 Phase 2 FACCH / SACCH mother code, RS(63,35))
+static const int RS_MAX_ROOTS = 28;
+
+// in-place RS(63,63-nroots) decode of hexbits HB[63], HB[0] is the
+// highest order symbol. Corrections below FirstInfo are treated as
+// failures. Returns the number of symbols corrected, or -1.
+int rsDec (int nroots, int FirstInfo, uint8_t HB[]);
+// as rsDec, with NoEras symbols at positions Eras[] marked as erased
+int rsDecErasures (int nroots, int FirstInfo, uint8_t HB[], const int Eras[], int NoEras);
+
+// the Phase 2 FACCH (45,26) and SACCH (52,30) are the RS(63,35) mother
+// code shortened by this many symbols and with the last 9 or 6 parity
+// symbols punctured; they correct 9 and 11 errors
+static const int RS_FACCH_FIRST = 9;
+static const int RS_SACCH_FIRST = 5;
+// in-place decode of a FACCH (fast) or SACCH in HB[63], the received
+// symbols from HB[RS_FACCH_FIRST] or HB[RS_SACCH_FIRST] on and the
+// shortened ones zero. Returns as rsDec.
+int rsDecAcch (bool fast, uint8_t HB[]);
+
+int hmg1063Dec (uint32_t Dat, uint32_t Par);
+
+// decode n codewords of a frame at once
+void gly24128DecBatch (const uint32_t CW[], uint32_t D[], int n);
+void hmg1063DecBatch (const uint32_t CW[], uint8_t HB[], int n);
+
 #endif
@@ -753,6 +753,14 @@ software_imbe_decoder::software_imbe_decoder()
    for(i=1; i < 211; i++) {
       u[i] = next_u(u[i-1]);
    }
+   for(i=0; i < 128; i++) {
+      Wi[i] = cos(M_PI * i / 128);
+      Wq[i] = -sin(M_PI * i / 128);
+      BitRev[i] = 0;
+      for(j=0; j < 7; j++) {
+         if(i & (1 << j)) BitRev[i] |= 1 << (6 - j);
+      }
+   }
 }
 
 uint32_t
@@ -829,31 +837,28 @@ software_imbe_decoder::adaptive_smoothing(float SE, float ER, float ET)
 void
 software_imbe_decoder::fft(float REX[], float IMX[])
 {
+   // 128-point in-place complex FFT, twiddles and bit-reversal order
+   // are precomputed in the constructor
    int I;
    int J;
    int K;
    int H;
    int KpH;
-   int Ht2;
+   int Step;
    float tmp_f;
-   float l_Ui, l_Uq, Theta, Si, Sq, Ti, Xi, Tq, Xq;
+   float l_Ui, l_Uq, Ti, Xi, Tq, Xq;
 
-   J = 64;
    for(I = 1; I <= 126; I++) {
+      J = BitRev[I];
 #define SWAP(x,y) tmp_f=x;x=y;y=tmp_f
       if(I < J) { SWAP(REX[J], REX[I]); SWAP(IMX[J], IMX[I]); }
 #undef SWAP
-      K = 64;
-      while(K <= J) { J = J - K; K = K / 2; }
-      J = J + K;
    }
 
-   H = 1;
-   for(I = 1; I <= 7; I++) {
-      Ht2 = H * 2; l_Ui = 1; l_Uq = 0;
-      Theta = M_PI / H; Si = cos(Theta); Sq = -sin(Theta);
-      for(J = 1; J <= H; J++) {
-         for(K = J - 1; K <= 127; K+=Ht2) {
+   for(H = 1, Step = 128; H < 128; H *= 2, Step /= 2) {
+      for(J = 0; J < H; J++) {
+         l_Ui = Wi[J * Step]; l_Uq = Wq[J * Step];
+         for(K = J; K <= 127; K += 2 * H) {
             KpH = K + H;
 
             Ti = REX[KpH] * l_Ui - IMX[KpH] * l_Uq; Xi = REX[K];
@@ -862,13 +867,48 @@ software_imbe_decoder::fft(float REX[], float IMX[])
             REX[KpH] = Xi - Ti; REX[K] = Xi + Ti;
             IMX[KpH] = Xq - Tq; IMX[K] = Xq + Tq;
          }
-         Ti = l_Ui;
-         l_Ui = Ti * Si - l_Uq * Sq;
-         l_Uq = Ti * Sq + l_Uq * Si;
       }
-      H = Ht2;
    }
+}
+
+void
+software_imbe_decoder::rfft(const float TD[], float FDi[], float FDq[])
+{
+   // Forward FFT of a real 256-point sequence (TD) to its 256-point
+   // spectrum (FDx), done as one 128-point complex FFT of the
+   // even / odd samples followed by the usual split step.
+   float Zi[128];
+   float Zq[128];
+   float Ei, Eq, Oi, Oq, Ci, Cq;
 
+   int I;
+   int K;
+
+   for(I = 0; I <= 127; I++) {
+      Zi[I] = TD[2 * I];
+      Zq[I] = TD[2 * I + 1];
+   }
+
+   fft(Zi, Zq);
+
+   for(I = 0; I <= 64; I++) {
+      K = (128 - I) & 127;
+      // even part (Z[I] + conj(Z[K])) / 2, odd part (Z[I] - conj(Z[K])) / 2j
+      Ei = (Zi[I] + Zi[K]) / 2; Eq = (Zq[I] - Zq[K]) / 2;
+      Oi = (Zq[I] + Zq[K]) / 2; Oq = -(Zi[I] - Zi[K]) / 2;
+      Ci = Oi * Wi[I] - Oq * Wq[I];
+      Cq = Oi * Wq[I] + Oq * Wi[I];
+      FDi[I] = Ei + Ci; FDq[I] = Eq + Cq;
+      // bin 128 - I is conj(E - W * O) of the same pair
+      if(I != 0 && I != 64) {
+         FDi[128 - I] = Ei - Ci; FDq[128 - I] = Cq - Eq;
+      }
+   }
+   // Nyquist bin
+   FDi[128] = Zi[0] - Zq[0]; FDq[128] = 0;
+   for(I = 1; I <= 127; I++) {
+      FDi[256 - I] = FDi[I]; FDq[256 - I] = -FDq[I];
+   }
 }
 
 void
@@ -908,6 +948,9 @@ software_imbe_decoder::decode_audio(uint8_t *A)
 
       //output:
       audio_samples *samples = audio();
+      size_t base = samples->size();
+      samples->resize(base + 160);
+      float *out = &(*samples)[base];
       for(en = 0; en <= 159; en++) {
          // The unvoiced samples are loud and the voiced are low...I don't know why.
          // Most of the difference is compensated by removing the 146.6433 factor
@@ -917,8 +960,7 @@ software_imbe_decoder::decode_audio(uint8_t *A)
 //         if(abs((int)sample) > 32767) {
 //            sample = 32767 * (sample < 0) ? -1 : 1; // * sgn(sample)
 //         }
-         sample /= 32768.0;
-         samples->push_back(sample);
+         out[en] = sample / 32768.0;
       }
    }
    OldL = L;
@@ -953,6 +995,9 @@ software_imbe_decoder::decode_tap(int _L, int _K, float _w0, const int * _v, con
 
       //output:
       audio_samples *samples = audio();
+      size_t base = samples->size();
+      samples->resize(base + 160);
+      float *out = &(*samples)[base];
       for(en = 0; en <= 159; en++) {
          // The unvoiced samples are loud and the voiced are low...I don't know why.
          // Most of the difference is compensated by removing the 146.6433 factor
@@ -962,7 +1007,7 @@ software_imbe_decoder::decode_tap(int _L, int _K, float _w0, const int * _v, con
          if(abs((int)sample) > 32767) {
             sample = (sample < 0) ? -32767 : 32767; // * sgn(sample)
          }
-         samples->push_back((short)sample);
+         out[en] = (short)sample;
       }
    OldL = L;
    Oldw0 = w0;
@@ -1124,7 +1169,7 @@ software_imbe_decoder::enhance_spectral_amplitudes(float& SE)
 }
 
 void
-software_imbe_decoder::ifft(float FDi[], float FDq[], float TD[]) // ToDo: replace "real IFFT" with fftw3 IFFT proc!
+software_imbe_decoder::ifft(float FDi[], float FDq[], float TD[])
 {
 	//Inverse FFT:
 	//  transform 129-point freq domain(FDx) to 256-point time domain(TD)
@@ -1136,7 +1181,7 @@ software_imbe_decoder::ifft(float FDi[], float FDq[], float TD[]) // ToDo: repla
    int J;
    int K;
    int H;
-   float l_Ui, l_Uq, Si, Sq, Ti, Tq, Xi, Xq;
+   float l_Ui, l_Uq, Ti, Tq, Xi, Xq;
 
    for(I = 0; I <= 63; I++) {
       J = I + 64;    //64 to 127
@@ -1176,10 +1221,9 @@ software_imbe_decoder::ifft(float FDi[], float FDq[], float TD[]) // ToDo: repla
    FDi[0] = Ai[0]   ; //c (new)
    FDq[0] = 0       ; //d
 
-   l_Ui = 1; l_Uq = 0;
-   Si = cos(M_PI / 128); Sq = -sin(M_PI / 128);
    for(I = 0; I <= 127; I++) {
       J = I + 128  ;   //128 TO 255
+      l_Ui = Wi[I]; l_Uq = Wq[I];
 
       Ti = FDi[J] * l_Ui - FDq[J] * l_Uq; Xi = FDi[I];
       Tq = FDi[J] * l_Uq + FDq[J] * l_Ui; Xq = FDq[I];
@@ -1187,10 +1231,6 @@ software_imbe_decoder::ifft(float FDi[], float FDq[], float TD[]) // ToDo: repla
 
       TD[I + 128] =((Xi + Ti) -(Xq + Tq));
       TD[I      ] =((Xi - Ti) -(Xq - Tq));
-
-      Ti = l_Ui;
-      l_Ui = Ti * Si - l_Uq * Sq;
-      l_Uq = Ti * Sq + l_Uq * Si;
    }
 }
 
@@ -1309,8 +1349,11 @@ software_imbe_decoder::synth_unvoiced()
    float Uwi[256];
    float Uwq[256];
    float uw[256];
+   float Nwi[256];
+   float Nwq[256];
 
    float Tmp;
+   bool have_noise = false;
 
    int ell, bl, em, al, en;
 
@@ -1337,14 +1380,21 @@ software_imbe_decoder::synth_unvoiced()
          }
       } else {
          Luv = Luv + 1;
-         for(em = al; em <= bl - 1; em++) {
-            Uwi[em] = 0;
-            Uwq[em] = 0;
-            for (en = 0; en < 211; en++) {
-               float exp = -0.0078125 * M_PI * em * (en - 105);
-               Uwi[em] = Uwi[em] + u[en] * ws[en] * cos(exp);
-               Uwq[em] = Uwq[em] + u[en] * ws[en] * sin(exp);
+         if(!have_noise) {
+            // Spectrum of the windowed noise, u(n) * ws(n) for n = -105..105
+            // placed circularly in 256 points, computed once per frame
+            for(en = 0; en < 256; en++) {
+               uw[en] = 0;
             }
+            for(en = 0; en < 211; en++) {
+               uw[(en - 105) & 255] = u[en] * ws[en];
+            }
+            rfft(uw, Nwi, Nwq);
+            have_noise = true;
+         }
+         for(em = al; em <= bl - 1; em++) {
+            Uwi[em] = Nwi[em & 255];
+            Uwq[em] = Nwq[em & 255];
          }
          //precompute Tmp = <most of big hairy equation>
          Tmp = 0;
@@ -1389,6 +1439,27 @@ software_imbe_decoder::synth_unvoiced()
    }
 }
 
+// out[n] += amp * win[n] * cos(w * n + ph), n = 0 .. N-1
+//
+// The oscillator is run as a rotating phasor rather than calling cos()
+// for every sample; it is kept in double so the drift over a frame is
+// far below the float output precision.
+static void
+add_harmonic(float *out, const float *win, float amp, double w, double ph, int N)
+{
+   double pr = cos(ph), pq = sin(ph);
+   double dr = cos(w), dq = sin(w);
+   double t;
+   int en;
+
+   for(en = 0; en < N; en++) {
+      out[en] += amp * win[en] * pr;
+      t = pr * dr - pq * dq;
+      pq = pr * dq + pq * dr;
+      pr = t;
+   }
+}
+
 void
 software_imbe_decoder::synth_voiced()
 {
@@ -1447,31 +1518,27 @@ software_imbe_decoder::synth_voiced()
                THa = (Oldw0 * (float)ell + Dwl);
                THb = (w0 - Oldw0) * ell * .003125;
                Mb = .00625 *(MNew - MOld);
+               // phase is quadratic in en: step the phasor by a phase
+               // increment that itself advances by 2 * THb every sample
+               double pr = cos(phi[ell][ Old]), pq = sin(phi[ell][ Old]);
+               double dr = cos(THa + THb), dq = sin(THa + THb);
+               double ddr = cos(2 * THb), ddq = sin(2 * THb);
+               double t;
                for(en = 0; en <= 159; en++) {
-                  sv[en] = sv[en] +(MOld + en * Mb) * cos(phi[ell][ Old] +(THa + THb * en) * en);
+                  sv[en] = sv[en] +(MOld + en * Mb) * pr;
+                  t = pr * dr - pq * dq; pq = pr * dq + pq * dr; pr = t;
+                  t = dr * ddr - dq * ddq; dq = dr * ddq + dq * ddr; dr = t;
                }
             } else { // (coarse transition)
-               for(en = 0; en <= 55; en++) {
-                  sv[en] = sv[en] + ws[en+105] * MOld * cos(Oldw0 * en * ell + phi[ell] [ Old]);
-               }
-               for(en = 56; en <= 105; en++) {
-                  sv[en] = sv[en] + ws[en+105] * MOld * cos(Oldw0 * en * ell + phi[ell][ Old]);
-                  sv[en] = sv[en] + ws[en-55] * MNew * cos(w0 *(en - 160) * ell + phi[ell][ New]);
-               }
-               for(en = 106; en <= 159; en++) {
-                  sv[en] = sv[en] + ws[en-55] * MNew * cos(w0 *(en - 160) * ell + phi[ell][ New]);
-               }
+               add_harmonic(&sv[0], &ws[105], MOld, Oldw0 * ell, phi[ell][ Old], 106);
+               add_harmonic(&sv[56], &ws[1], MNew, w0 * ell, w0 * (56 - 160) * ell + phi[ell][ New], 104);
             }
          } else {
-            for(en = 56; en <= 159; en++) {
-               sv[en] = sv[en] + ws[en-55] * MNew * cos(w0 *(en - 160) * ell + phi[ell][ New]);
-            }
+            add_harmonic(&sv[56], &ws[1], MNew, w0 * ell, w0 * (56 - 160) * ell + phi[ell][ New], 104);
          }
       } else {
          if( vee[ell][Old]) {
-            for(en = 0; en <= 105; en++) {
-               sv[en] = sv[en] + ws[en+105] * MOld * cos(Oldw0 * en * ell + phi[ell][ Old]);
-            }
+            add_harmonic(&sv[0], &ws[105], MOld, Oldw0 * ell, phi[ell][ Old], 106);
          }
       }
    }
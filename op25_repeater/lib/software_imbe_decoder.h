@@ -79,6 +79,10 @@ private:
 	float Oldw0;
 	float Luv;						//number of unvoiced spectral amplitudes
 
+	float Wi[128];					//FFT twiddles, exp(-j*pi*k/128)
+	float Wq[128];
+	uint8_t BitRev[128];			//128-point FFT bit-reversal order
+
 	char sym_b[4096];
 	char RxData[4096];
 	int sym_bp;
@@ -94,6 +98,7 @@ private:
 	void fft(float i[], float q[]);
 	void enhance_spectral_amplitudes(float&);
 	void ifft(float i[], float q[], float[]);
+	void rfft(const float td[], float i[], float q[]);
 	uint16_t rearrange(uint32_t u0, uint32_t u1, uint32_t u2, uint32_t u3, uint32_t u4, uint32_t u5, uint32_t u6, uint32_t u7);
 	void synth_unvoiced();
 	void synth_voiced();
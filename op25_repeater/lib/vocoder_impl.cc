@@ -67,7 +67,7 @@ namespace gr {
               gr::io_signature::make (M_IN(encode_flag, udp_port), M_IN(encode_flag, udp_port), S_IN(encode_flag, udp_port)),
               gr::io_signature::make (M_OUT(encode_flag, udp_port), M_OUT(encode_flag, udp_port), S_OUT(encode_flag, udp_port))),
     output_queue(),
-    output_queue_decode(),
+    output_queue_decode(32768),
     opt_udp_port(udp_port),
     opt_encode_flag(encode_flag),
     p1voice_encode(verbose_flag, stretch_amt, udp_host, udp_port, raw_vectors_flag, output_queue),
@@ -114,12 +114,8 @@ vocoder_impl::general_work_decode (int noutput_items,
 
   consume_each (ninput_items[0]);
 
-  uint16_t *out = reinterpret_cast<uint16_t*>(output_items[0]);
-  const int n = std::min(static_cast<int>(output_queue_decode.size()), noutput_items);
-  if(0 < n) {
-     copy(output_queue_decode.begin(), output_queue_decode.begin() + n, out);
-     output_queue_decode.erase(output_queue_decode.begin(), output_queue_decode.begin() + n);
-  }
+  int16_t *out = reinterpret_cast<int16_t*>(output_items[0]);
+  const int n = output_queue_decode.read(out, noutput_items);
   // Tell runtime system how many output items we produced.
   return n;
 }
@@ -63,7 +63,7 @@ namespace gr {
   private:
 
 	std::deque<uint8_t> output_queue;
-	std::deque<int16_t> output_queue_decode;
+	sample_ring output_queue_decode;
 	int opt_udp_port;
 	bool opt_encode_flag;
         p25p1_voice_encode p1voice_encode;
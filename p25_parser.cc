@@ -1,12 +1,133 @@
 #include "p25_parser.h"
+#include <stdio.h>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/foreach.hpp>
+
 P25Parser::P25Parser() {
+	SiteInfo none = { 0, 0, 0, 0, 0 };
+	site = none;
+	saved_site = none;
+}
+
+void P25Parser::load_state(std::string filename) {
+	state_filename = filename;
+	if (state_filename.empty()) {
+		return;
+	}
+
+	try {
+		boost::property_tree::ptree pt;
+		boost::property_tree::read_json(state_filename, pt);
+
+		saved_site.nac = pt.get<unsigned long>("nac", 0);
+		saved_site.wacn = pt.get<unsigned long>("wacn", 0);
+		saved_site.sysid = pt.get<unsigned long>("sysid", 0);
+		saved_site.rfss = pt.get<unsigned long>("rfss", 0);
+		saved_site.site = pt.get<unsigned long>("site", 0);
+		site = saved_site;
+		BOOST_FOREACH( boost::property_tree::ptree::value_type  &node, pt.get_child("channels") )
+		{
+			Channel temp_chan = {
+				node.second.get<unsigned long>("id"),
+				node.second.get<unsigned long>("offset"),
+				node.second.get<unsigned long>("step"),
+				node.second.get<unsigned long>("frequency"),
+				node.second.get<int>("tdma"),
+				node.second.get<double>("bandwidth"),
+				false
+			};
+			channels[temp_chan.id] = temp_chan;
+		}
+		BOOST_LOG_TRIVIAL(info) << "Loaded " << channels.size() << " channel identifiers from " << state_filename << " for NAC 0x" << std::hex << site.nac << " WACN 0x" << site.wacn << " SysID 0x" << site.sysid << std::dec << " RFSS " << site.rfss << " Site " << site.site;
+	} catch (std::exception const& e) {
+		// first run, or a file from an older version
+		BOOST_LOG_TRIVIAL(info) << "No channel identifiers loaded from " << state_filename << ": " << e.what();
+		channels.clear();
+	}
+}
+
+void P25Parser::save_state() {
+	if (state_filename.empty()) {
+		return;
+	}
+
+	boost::property_tree::ptree pt;
+	pt.put("nac", site.nac);
+	pt.put("wacn", site.wacn);
+	pt.put("sysid", site.sysid);
+	pt.put("rfss", site.rfss);
+	pt.put("site", site.site);
+
+	boost::property_tree::ptree list;
+	for (std::map<int,Channel>::iterator c = channels.begin(); c != channels.end(); c++) {
+		boost::property_tree::ptree node;
+		node.put("id", c->second.id);
+		node.put("offset", c->second.offset);
+		node.put("step", c->second.step);
+		node.put("frequency", c->second.frequency);
+		node.put("tdma", c->second.tdma);
+		node.put("bandwidth", c->second.bandwidth);
+		list.push_back(std::make_pair("", node));
+	}
+	pt.add_child("channels", list);
+
+	// written aside and renamed, so a crash never leaves half a file
+	std::string temp_filename = state_filename + ".tmp";
+	try {
+		boost::property_tree::write_json(temp_filename, pt);
+		if (rename(temp_filename.c_str(), state_filename.c_str()) != 0) {
+			BOOST_LOG_TRIVIAL(error) << "Unable to replace " << state_filename;
+		}
+	} catch (std::exception const& e) {
+		BOOST_LOG_TRIVIAL(error) << "Unable to save the channel identifiers: " << e.what();
+	}
+}
 
+/*
+ * A broadcast value for the system or site. If the state file was
+ * written for a different one, the saved channel table belongs to
+ * another system and everything not heard since startup is dropped.
+ */
+void P25Parser::update_site(unsigned long &field, unsigned long &saved_field, unsigned long value, const char *name) {
+	if (field == value) {
+		return;
+	}
+	if (saved_field && (saved_field != value)) {
+		BOOST_LOG_TRIVIAL(info) << "\t" << name << " is now 0x" << std::hex << value << ", was 0x" << saved_field << std::dec << " in " << state_filename << ", dropping the saved channel identifiers";
+		for (it = channels.begin(); it != channels.end();) {
+			if (!it->second.confirmed) {
+				channels.erase(it++);
+			} else {
+				++it;
+			}
+		}
+	}
+	saved_field = 0;
+	field = value;
+	save_state();
 }
 
 void P25Parser::add_channel(int chan_id, Channel temp_chan) {
 //std::cout << "Add  - Channel id " << std::dec << chan_id << " freq " <<  temp_chan.frequency << " offset " << temp_chan.offset << " step " << temp_chan.step << " slots/carrier " << temp_chan.tdma  << std::endl;
+	temp_chan.confirmed = true;
 
+	it = channels.find(chan_id);
+	if (it != channels.end()) {
+		Channel &old_chan = it->second;
+		bool same = (old_chan.offset == temp_chan.offset) && (old_chan.step == temp_chan.step) &&
+		            (old_chan.frequency == temp_chan.frequency) && (old_chan.tdma == temp_chan.tdma) &&
+		            (old_chan.bandwidth == temp_chan.bandwidth);
+		if (same) {
+			old_chan.confirmed = true;
+			return;
+		}
+		if (!old_chan.confirmed) {
+			BOOST_LOG_TRIVIAL(info) << "\tSaved channel identifier " << chan_id << " was out of date, replaced";
+		}
+	}
 	channels[chan_id] = temp_chan;
+	save_state();
 }
 
 
@@ -236,7 +357,8 @@ std::vector<TrunkMessage> P25Parser::decode_tsbk(boost::dynamic_bitset<> &tsbk)
 			spac * 125, //step;
 			freq * 5, //frequency;
 			0, //tdma;
-			bandwidth
+			bandwidth,
+			true
 		};
 		add_channel(iden, temp_chan);
 		BOOST_LOG_TRIVIAL(trace) << "tsbk34 iden vhf/uhf id " << std::dec << iden << " toff " << toff * spac * 0.125 * 1e-3 << " spac " << spac * 0.125 << " freq " << freq * 0.000005 << " [ " << txt[toff_sign] << "]";
@@ -260,7 +382,8 @@ std::vector<TrunkMessage> P25Parser::decode_tsbk(boost::dynamic_bitset<> &tsbk)
 				spac * 125, //step;
 				f1 * 5, //frequency;
 				slots_per_carrier[channel_type], //tdma;
-				6.25
+				6.25,
+				true
 			};
 			add_channel(iden,temp_chan);
 			BOOST_LOG_TRIVIAL(trace) << "tsbk33 iden up tdma id " << std::dec << iden << " f " <<  temp_chan.frequency << " offset " << temp_chan.offset << " spacing " << temp_chan.step << " slots/carrier " << temp_chan.tdma;
@@ -283,7 +406,8 @@ std::vector<TrunkMessage> P25Parser::decode_tsbk(boost::dynamic_bitset<> &tsbk)
 			spac * 125, //step;
 			freq * 5, //frequency;
 			0, //tdma;
-			bw * .125
+			bw * .125,
+			true
 		};
 		add_channel(iden,temp_chan);
 		BOOST_LOG_TRIVIAL(trace) << "tsbk3d iden id "<< std::dec << iden <<" toff "<< toff * 0.25 << " spac " << spac * 0.125 << " freq " << freq * 0.000005;
@@ -293,6 +417,9 @@ std::vector<TrunkMessage> P25Parser::decode_tsbk(boost::dynamic_bitset<> &tsbk)
 		unsigned long stid = bitset_shift_mask(tsbk, 40, 0xff);
 		unsigned long chan = bitset_shift_mask(tsbk, 24, 0xffff);
 		
+		update_site(site.sysid, saved_site.sysid, syid, "SysID");
+		update_site(site.rfss, saved_site.rfss, rfid, "RFSS");
+		update_site(site.site, saved_site.site, stid, "Site");
 		BOOST_LOG_TRIVIAL(trace) << "tsbk3a rfss status: syid: " << syid << " rfid " << rfid << " stid " << stid << " ch1 " << chan << "(" << channel_id_to_string(chan) <<  ")"<< std::endl;
 	} else if (opcode == 0x39) {  // secondary cc
 		unsigned long rfid = bitset_shift_mask(tsbk, 72, 0xff);
@@ -317,6 +444,8 @@ std::vector<TrunkMessage> P25Parser::decode_tsbk(boost::dynamic_bitset<> &tsbk)
 		unsigned long syid = bitset_shift_mask(tsbk, 40, 0xfff);
 		unsigned long ch1  = bitset_shift_mask(tsbk, 24, 0xffff);
 		unsigned long f1 = channel_id_to_frequency(ch1);
+		update_site(site.wacn, saved_site.wacn, wacn, "WACN");
+		update_site(site.sysid, saved_site.sysid, syid, "SysID");
 		if (f1) {
 			/*
 			self.ns_syid = syid
@@ -413,23 +542,16 @@ void printbincharpad(char c)
 }
 
 
-std::vector<TrunkMessage> P25Parser::parse_message(gr::message::sptr msg) {
+std::vector<TrunkMessage> P25Parser::parse_message(const trunk_msg &msg) {
 	TrunkMessage message;
 	std::vector<TrunkMessage> messages;
 
 	message.message_type = UNKNOWN;
     message.source = 0;
 
-	long type = msg->type();
+	long type = msg.type;
 	
-	if (type == -2 ) {	 // # request from gui
-		std::string cmd = msg->to_string();
-
-		BOOST_LOG_TRIVIAL(trace) << "process_qmsg: command: " << cmd;
-		//self.update_state(cmd, curr_time)
-		messages.push_back(message);
-		return messages;
-	} else if ( type == -1 ) {  //	# timeout
+	if ( type == trunk_msg::TRUNK_MSG_TIMEOUT ) {  //	# timeout
 		BOOST_LOG_TRIVIAL(trace) << "process_data_unit timeout";
 		//self.update_state('timeout', curr_time)
 		messages.push_back(message);
@@ -439,17 +561,17 @@ std::vector<TrunkMessage> P25Parser::parse_message(gr::message::sptr msg) {
 		messages.push_back(message);
 		return messages;
 	}
-	std::string s = msg->to_string();
-	//# nac is always 1st two bytes
-	long nac = ((int) s[0] << 8) + (int) s[1];
+	long nac = msg.nac;
 	if (nac == 0xffff) {
 		//# TDMA
 		//self.update_state('tdma_duid%d' % type, curr_time)
 		messages.push_back(message);
 		return messages;
 	}
-	s = s.substr(2);
-	//std::cout << std::dec << "nac " << nac << " type " << type <<  " size " << msg->to_string().length() << " mesg len: " << msg->length() << std::endl; //" at %f state %d len %d" %(nac, type, time.time(), self.state, len(s))
+	update_site(site.nac, saved_site.nac, nac, "NAC");
+	const uint8_t *s = msg.data;
+	unsigned int len = msg.len;
+	//std::cout << std::dec << "nac " << nac << " type " << type << " mesg len: " << len << std::endl; //" at %f state %d len %d" %(nac, type, time.time(), self.state, len(s))
 	if ((type == 7) || (type == 12)) // and nac not in self.trunked_systems:
 	{
 		/*
@@ -462,9 +584,9 @@ std::vector<TrunkMessage> P25Parser::parse_message(gr::message::sptr msg) {
 	}
 	if (type == 7) { 	 //# trunk: TSBK
 
-		boost::dynamic_bitset<> b((s.length()+2)*8);
-		for (unsigned int i = 0; i < s.length(); ++i) {
-			unsigned char c = (unsigned char) s[i];
+		boost::dynamic_bitset<> b((len+2)*8);
+		for (unsigned int i = 0; i < len; ++i) {
+			unsigned char c = s[i];
 			b <<= 8;
 			for (int j = 0; j < 8 ; j++) {
 				if (c & 0x1) {
@@ -479,21 +601,20 @@ std::vector<TrunkMessage> P25Parser::parse_message(gr::message::sptr msg) {
 
 		return decode_tsbk(b);
 	} else if (type == 12) {	//# trunk: MBT
-		std::string s1 = s.substr(0,10);
-		std::string s2 = s.substr(10);
+		unsigned int len1 = (len < 10) ? len : 10;
 		long header=0;
 		long mbt_data = 0;
-		for (unsigned int i = 0; i < s1.length(); ++i)
+		for (unsigned int i = 0; i < len1; ++i)
 		{
-			header = (header << 8) + (int) s1[i];
+			header = (header << 8) + (int) s[i];
 		}
-		for (unsigned int i = 0; i < s2.length(); ++i)
+		for (unsigned int i = len1; i < len; ++i)
 		{
-			mbt_data = (mbt_data << 8) + (int) s2[i];
+			mbt_data = (mbt_data << 8) + (int) s[i];
 		}
 		long opcode = (header >> 16) & 0x3f;
 
-		BOOST_LOG_TRIVIAL(trace) << "type " << type << " len " << s1.length() << "/"<< s2.length() << " opcode " << opcode << "[" << header << "/" << mbt_data << "]";
+		BOOST_LOG_TRIVIAL(trace) << "type " << type << " len " << len1 << "/"<< len - len1 << " opcode " << opcode << "[" << header << "/" << mbt_data << "]";
 		//self.trunked_systems[nac].decode_mbt_data(opcode, header << 16, mbt_data << 32)
 	}
 	messages.push_back(message);
@@ -7,7 +7,6 @@
 #include <vector>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/log/trivial.hpp>
-#include <gnuradio/message.h>
 #include <bitset>
 
 struct Channel {
@@ -17,14 +16,33 @@ struct Channel {
 	unsigned long frequency;
 	int tdma;
 	double bandwidth;
+	bool confirmed;  // false if it came from the state file and has not been broadcast since
+};
+
+// what the control channel said about the system, 0 until it is heard
+struct SiteInfo {
+	unsigned long nac;
+	unsigned long wacn;
+	unsigned long sysid;
+	unsigned long rfss;
+	unsigned long site;
 };
 
 class P25Parser:public TrunkParser
 {
 	std::map<int,Channel> channels;
 	std::map<int,Channel>::iterator it;
+	SiteInfo site;
+	SiteInfo saved_site;  // site the state file was written for
+	std::string state_filename;
+	void update_site(unsigned long &field, unsigned long &saved_field, unsigned long value, const char *name);
+	void save_state();
 public:
 	P25Parser();
+	// reload the channel table and site written by a previous run, and
+	// keep filename up to date as they change. Saved entries are used
+	// until the control channel contradicts them.
+	void load_state(std::string filename);
 	long get_tdma_slot(int chan_id);
 	double get_bandwidth(int chan_id);
 	std::vector<TrunkMessage> decode_tsbk(boost::dynamic_bitset<> &tsbk);
@@ -33,7 +51,7 @@ public:
 	void print_bitset(boost::dynamic_bitset<> &tsbk);
 	void add_channel(int chan_id, Channel chan);
 	double channel_id_to_frequency(int chan_id);
-	std::vector<TrunkMessage> parse_message(gr::message::sptr msg);
+	std::vector<TrunkMessage> parse_message(const trunk_msg &msg);
 };
 
 #endif
\ No newline at end of file
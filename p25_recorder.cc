@@ -19,10 +19,15 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
 	long samp_rate = source->get_rate();
     qpsk_mod = qpsk;
 	talkgroup = 0;
+	first_voice_time = 0;
+	last_voice_time = 0;
+	voice_end_time = 0;
 	long capture_rate = samp_rate;
 
 	num = 0;
+	epoch = 0;
 	active = false;
+	active_ms = 0;
 
 	float offset = freq - center;
 
@@ -39,6 +44,7 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
 
 	timestamp = time(NULL);
 	starttime = time(NULL);
+	activate_time = monotonic_ms();
 
         double input_rate = capture_rate;
         
@@ -47,7 +53,12 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
         float costas_alpha = 0.04;
         float bb_gain = 1.0;
 
-       	baseband_amp = gr::blocks::multiply_const_ff::make(bb_gain);
+	costas_scale = -if_rate / (2 * pi);
+	tune_scale = symbol_deviation / bb_gain;
+	freq_error_sum = 0;
+	freq_error_samples = 0;
+	tune_error = 0;
+	has_tune_error = false;
 
 
 
@@ -55,12 +66,8 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
 
 
   
-        
-	valve = gr::blocks::copy::make(sizeof(gr_complex));
-	valve->set_enabled(false);
-        
-        
-            lpf_coeffs = gr::filter::firdes::low_pass(1.0, input_rate, xlate_bandwidth/2, 1500, gr::filter::firdes::WIN_HANN);
+
+            lpf_coeffs = cached_low_pass(1.0, input_rate, xlate_bandwidth/2, 1500, gr::filter::firdes::WIN_HANN);
         int decimation = int(input_rate / if_rate);
        
         prefilter = gr::filter::freq_xlating_fir_filter_ccf::make(decimation,
@@ -90,8 +97,8 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
 
                 // As we drop the bw factor, the optfir filter has a harder time converging;
                 // using the firdes method here for better results.
-                arb_taps = gr::filter::firdes::low_pass_2(arb_size, arb_size, bw, tb, arb_atten,
-                                                      gr::filter::firdes::WIN_BLACKMAN_HARRIS);
+                arb_taps = cached_low_pass_2(arb_size, arb_size, bw, tb, arb_atten,
+                                             gr::filter::firdes::WIN_BLACKMAN_HARRIS);
             } else {
                 BOOST_LOG_TRIVIAL(error) << "Something is probably wrong! Resampling rate too low";
                 exit(0);
@@ -124,9 +131,6 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
         arb_resampler = gr::filter::pfb_arb_resampler_ccf::make(arb_rate, arb_taps );
 
 
-        agc = gr::analog::feedforward_agc_cc::make(16, 1.0);
-
-
         float omega = float(if_rate) / float(symbol_rate);
         float gain_omega = 0.1  * gain_mu * gain_mu;
 
@@ -135,48 +139,49 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
         float fmax = 2400;	// Hz
         fmax = 2*pi * fmax / float(if_rate);
 
-        costas_clock = gr::op25_repeater::gardner_costas_cc::make(omega, gain_mu, gain_omega, alpha,  beta, fmax, -fmax);
-
-
-        // Perform Differential decoding on the constellation
-        diffdec = gr::digital::diff_phasor_cc::make();
-
-        // take angle of the difference (in radians)
-        to_float = gr::blocks::complex_to_arg::make();
-
-        // convert from radians such that signal is in -3/-1/+1/+3
-        rescale = gr::blocks::multiply_const_ff::make( (1 / (pi / 4)) );
-
-        // fm demodulator (needed in fsk4 case)
+        // fm demodulator (needed in fsk4 case), the baseband gain is
+        // applied here rather than by a block of its own
         float fm_demod_gain = if_rate / (2.0 * pi * symbol_deviation);
-        fm_demod = gr::analog::quadrature_demod_cf::make(fm_demod_gain);
 
 
 
 	double symbol_decim = 1;
 
-	valve = gr::blocks::copy::make(sizeof(gr_complex));
+	valve = make_preroll_valve(source->get_preroll(), source->get_preroll_catchup());
 	valve->set_enabled(false);
 
 	for (int i=0; i < samples_per_symbol; i++) {
 		sym_taps.push_back(1.0 / samples_per_symbol);
 	}
 
-	sym_filter =  gr::filter::fir_filter_fff::make(symbol_decim, sym_taps);
 	tune_queue = gr::msg_queue::make(2);
 	traffic_queue = gr::msg_queue::make(2);
-	rx_queue = gr::msg_queue::make(100);
+	rx_queue = gr::op25_repeater::trunk_msg_queue::make(100);
 	const float l[] = { -2.0, 0.0, 2.0, 4.0 };
 	std::vector<float> levels( l,l + sizeof( l ) / sizeof( l[0] ) );
-	fsk4_demod = gr::op25_repeater::fsk4_demod_ff::make(tune_queue, system_channel_rate, symbol_rate);
-	slicer = gr::op25_repeater::fsk4_slicer_fb::make(levels);
+
+	// only the blocks for the system's modulation are built
+	if (qpsk_mod) {
+		agc = gr::analog::feedforward_agc_cc::make(16, 1.0);
+		costas_clock = gr::op25_repeater::gardner_costas_cc::make(omega, gain_mu, gain_omega, alpha,  beta, fmax, -fmax);
+		// differential decoding, angle, scaling to -3/-1/+1/+3 and
+		// slicing in a single block
+		dqpsk = make_dqpsk_slicer(levels);
+		dqpsk->set_max_output_buffer(8192);
+	} else {
+		fm_demod = gr::analog::quadrature_demod_cf::make(fm_demod_gain * bb_gain);
+		sym_filter =  gr::filter::fir_filter_fff::make(symbol_decim, sym_taps);
+		fsk4_demod = gr::op25_repeater::fsk4_demod_ff::make(tune_queue, system_channel_rate, symbol_rate);
+		slicer = gr::op25_repeater::fsk4_slicer_fb::make(levels);
+		slicer->set_max_output_buffer(8192);
+	}
 
 	int udp_port = 0;
 	int verbosity = 1; // 10 = lots of debug messages
 	const char * wireshark_host="127.0.0.1";
 	bool do_imbe = 1;
 	bool do_output = 1;
-	bool do_msgq = 0;
+	bool do_msgq = 1;  // DUIDs are used to detect the end of the transmission
 	bool do_audio_output = 1;
 	bool do_tdma = 0;
 	op25_frame_assembler = gr::op25_repeater::p25_frame_assembler::make(wireshark_host,udp_port,verbosity,do_imbe, do_output, do_msgq, rx_queue, do_audio_output, do_tdma);
@@ -185,21 +190,16 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
         
 	converter = gr::blocks::short_to_float::make(1, 2048.0); //8192.0);
 
-	tm *ltm = localtime(&starttime);
-
-	std::stringstream path_stream;
-	path_stream << boost::filesystem::current_path().string() <<  "/" << 1900 + ltm->tm_year << "/" << 1 + ltm->tm_mon << "/" << ltm->tm_mday;
-
-	boost::filesystem::create_directories(path_stream.str());
-	sprintf(filename, "%s/%ld-%ld_%g.wav", path_stream.str().c_str(),talkgroup,timestamp,freq);
-	wav_sink = gr::blocks::nonstop_wavfile_sink::make(filename,1,8000,16);
-
-
+	// no file until the first call, activate() opens it
+	filename[0] = '\0';
+	wav_sink = gr::blocks::nonstop_wavfile_sink::make(NULL,1,8000,16);
+	if (silence_gate::enabled()) {
+		// the assembler is silent without voice frames, the gate
+		// times the gaps that leaves
+		gate = make_silence_gate(8000, true, false);
+	}
 
         valve->set_max_output_buffer(8192);
-        to_float->set_max_output_buffer(8192);
-        rescale->set_max_output_buffer(8192);
-        slicer->set_max_output_buffer(8192);
         op25_frame_assembler->set_max_output_buffer(8192);
         converter->set_max_output_buffer(8192);
 	if (!qpsk_mod) {
@@ -207,26 +207,26 @@ p25_recorder::p25_recorder(Source *src, bool qpsk)
 		connect(valve,0, prefilter,0);
 		connect(prefilter,0, arb_resampler, 0);
 		connect(arb_resampler,0, fm_demod,0);
-		connect(fm_demod, 0, baseband_amp, 0);
-		connect(baseband_amp,0, sym_filter, 0);
+		connect(fm_demod, 0, sym_filter, 0);
 		connect(sym_filter, 0, fsk4_demod, 0);
 		connect(fsk4_demod, 0, slicer, 0);
 		connect(slicer,0, op25_frame_assembler,0);
 		connect(op25_frame_assembler, 0,  converter,0);
-		connect(converter,  0, wav_sink,0);
 	} else {
         connect(self(),0, valve,0);
 		connect(valve,0, prefilter,0);
 		connect(prefilter, 0, arb_resampler, 0);
 		connect(arb_resampler,0, agc,0);
 		connect(agc, 0, costas_clock, 0);
-		connect(costas_clock,0, diffdec, 0);
-		connect(diffdec, 0, to_float, 0);
-		connect(to_float,0, rescale, 0);
-		connect(rescale, 0, slicer, 0);
-		connect(slicer,0, op25_frame_assembler,0);
+		connect(costas_clock,0, dqpsk, 0);
+		connect(dqpsk,0, op25_frame_assembler,0);
 		connect(op25_frame_assembler, 0,  converter,0);
-		connect(converter, 0, wav_sink,0);
+	}
+	if (gate) {
+		connect(converter, 0, gate, 0);
+		connect(gate, 0, wav_sink, 0);
+	} else {
+		connect(converter, 0, wav_sink, 0);
 	}
 }
 
@@ -249,15 +249,142 @@ double p25_recorder::get_freq() {
 	return freq;
 }
 
-int p25_recorder::lastupdate() {
-	return time(NULL) - timestamp;
+int64_t p25_recorder::lastupdate() {
+	return monotonic_ms() - activate_time;
+}
+
+int64_t p25_recorder::elapsed() {
+	return monotonic_ms() - activate_time;
+}
+
+int64_t p25_recorder::get_active_ms() {
+	if (active) {
+		return active_ms + elapsed();
+	}
+	return active_ms;
+}
+
+uint64_t p25_recorder::get_audio_drops() {
+	return op25_frame_assembler->get_audio_overflows();
+}
+
+// voice frame batches that need to be decoded for an estimate
+static const long MIN_FREQ_ERROR_SAMPLES = 5;
+
+void p25_recorder::sample_freq_error() {
+	if (qpsk_mod) {
+		freq_error_sum += costas_clock->get_freq() * costas_scale;
+		freq_error_samples++;
+	} else {
+		// the demodulator only asks to be retuned once it is far off,
+		// the latest request is the one that counts
+		gr::message::sptr msg = tune_queue->delete_head_nowait();
+		while (msg) {
+			tune_error = msg->arg1() * tune_scale;
+			has_tune_error = true;
+			msg = tune_queue->delete_head_nowait();
+		}
+	}
+}
+
+void p25_recorder::update_voice_state() {
+	gr::op25_repeater::trunk_msg msg;
+	bool voice = false;
+
+	// LDUs mean the transmission is going; a TDU, or losing the signal
+	// long enough for the frame assembler to time out, ends it
+	while (rx_queue->delete_head_nowait(msg)) {
+		switch (msg.type) {
+		case 0x05:
+		case 0x0a:
+			if (!first_voice_time)
+				first_voice_time = msg.rx_time;
+			last_voice_time = msg.rx_time;
+			voice_end_time = 0;
+			voice = true;
+			break;
+		case 0x03:
+		case 0x0f:
+		case gr::op25_repeater::trunk_msg::TRUNK_MSG_TIMEOUT:
+			if (first_voice_time && !voice_end_time)
+				voice_end_time = msg.rx_time;
+			break;
+		}
+	}
+
+	// the demodulator is locked on while voice frames decode
+	if (voice && active) {
+		sample_freq_error();
+	}
+}
+
+int64_t p25_recorder::since_end_of_voice() {
+	update_voice_state();
+	if (!voice_end_time)
+		return -1;
+	return monotonic_ms() - voice_end_time;
+}
+
+int64_t p25_recorder::waiting_for_voice() {
+	update_voice_state();
+	if (!active || first_voice_time)
+		return -1;
+	return monotonic_ms() - activate_time;
+}
+
+int64_t p25_recorder::get_first_voice_time() {
+	update_voice_state();
+	return first_voice_time;
 }
 
-long p25_recorder::elapsed() {
-	return time(NULL) - starttime;
+int64_t p25_recorder::get_last_voice_time() {
+	update_voice_state();
+	return last_voice_time;
 }
 
 
+bool p25_recorder::get_silence_gaps(std::vector<silence_gap> &gaps) {
+	gaps.clear();
+	if (!gate) {
+		return false;
+	}
+	// no gaps if none of the call's audio got to the gate
+	gate->get_gaps(epoch, gaps);
+	return true;
+}
+
+bool p25_recorder::get_decode_quality(DecodeQuality &quality) {
+	op25_frame_assembler->get_decode_stats(quality.stats);
+	if (quality.stats.epoch != epoch) {
+		// nothing of this call has reached the frame assembler yet
+		quality.stats.clear(epoch);
+	}
+
+	quality.slicer_symbols = 0;
+	quality.symbol_error = 0;
+	if (qpsk_mod) {
+		long slicer_epoch;
+		double error;
+		uint64_t symbols;
+		dqpsk->get_symbol_error(slicer_epoch, error, symbols);
+		if (slicer_epoch == epoch) {
+			quality.slicer_symbols = symbols;
+			quality.symbol_error = error;
+		}
+	}
+	return true;
+}
+
+bool p25_recorder::get_decode_totals(DecodeTotals &totals) {
+	totals = decode_totals;
+	if (epoch > 0) {
+		DecodeQuality quality;
+		get_decode_quality(quality);
+		totals.add(quality);
+	}
+	return true;
+}
+
 void p25_recorder::tune_offset(double f) {
 	freq = f;
 	int offset_amount = (f - center);
@@ -269,27 +396,37 @@ void p25_recorder::deactivate() {
 	BOOST_LOG_TRIVIAL(info) << "p25_recorder.cc: Deactivating Logger \t[ " << num << " ] - freq[ " << freq << "] \t talkgroup[ " << talkgroup << " ]";
 
 	active = false;
+	active_ms += elapsed();
 	valve->set_enabled(false);
+
+	if (qpsk_mod && freq_error_samples >= MIN_FREQ_ERROR_SAMPLES) {
+		source->afc_update(freq_error_sum / freq_error_samples, activate_time);
+	} else if (has_tune_error) {
+		source->afc_update(tune_error, activate_time);
+	}
     /*BOOST_LOG_TRIVIAL(info) << 
 		  "Valve: \t" << valve->max_output_buffer(0) << "\n" <<
 		  "Prefilter: \t" << prefilter->max_output_buffer(0) << "\n" <<
 		  "arb_resampler: \t" << arb_resampler->max_output_buffer(0) << "\n" <<
 		  "agc: \t\t" << agc->max_output_buffer(0) << "\n" <<
 		  "costas_clock: \t" << costas_clock->max_output_buffer(0) << "\n" <<
-		  "diffdec: \t" << diffdec->max_output_buffer(0) << "\n" <<
-		"to_float: \t" << to_float->max_output_buffer(0) << "\n" <<
-		  "rescale: \t" << rescale->max_output_buffer(0) << "\n" <<
-		"slicer: \t" << slicer->max_output_buffer(0) << "\n" <<
+		"dqpsk: \t" << dqpsk->max_output_buffer(0) << "\n" <<
 		"op25: \t\t" << op25_frame_assembler->max_output_buffer(0) << "\n" <<
 		"converter: \t" << converter->max_output_buffer(0) << "\n" <<
         "wav_sink: \t" <<  wav_sink->max_output_buffer(0);*/
 	wav_sink->close();
 }
 
+void p25_recorder::abort() {
+	deactivate();
+	wav_sink->discard();
+}
+
 void p25_recorder::activate(Call *call, int n) {
 
 	timestamp = time(NULL);
 	starttime = time(NULL);
+	activate_time = monotonic_ms();
 
 	talkgroup = call->get_talkgroup();
 	freq = call->get_freq();
@@ -300,9 +437,28 @@ void p25_recorder::activate(Call *call, int n) {
 	int offset_amount = (freq - center);
 	prefilter->set_center_freq(offset_amount); 
 
-	wav_sink->open(call->get_filename());
+	// the sink switches files where the valve tags the first sample
+	// of this activation, audio of the last call still in the chain
+	// is dropped instead of starting the new file
+	if (epoch > 0) {
+		// the last call's counts are final now, the frame assembler
+		// has had until this activation to finish its frames
+		DecodeQuality quality;
+		get_decode_quality(quality);
+		decode_totals.add(quality);
+	}
+	epoch++;
+	wav_sink->open(call->get_filename(), epoch);
+	rx_queue->flush();
+	tune_queue->flush();
+	freq_error_sum = 0;
+	freq_error_samples = 0;
+	has_tune_error = false;
+	first_voice_time = 0;
+	last_voice_time = 0;
+	voice_end_time = 0;
 	active = true;
-	valve->set_enabled(true);
+	valve->start_from(call->get_grant_time() - source->get_preroll_time(), epoch);
 }
 
 
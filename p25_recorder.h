@@ -30,9 +30,7 @@
 #include <gnuradio/analog/sig_source_c.h>
 #include <gnuradio/analog/feedforward_agc_cc.h>
 
-#include <gnuradio/digital/diff_phasor_cc.h>
 
-#include <gnuradio/blocks/complex_to_arg.h>
 
 
 #include <gnuradio/blocks/multiply_cc.h>
@@ -65,6 +63,9 @@
 
 #include "nonstop_wavfile_sink.h"
 #include <gnuradio/blocks/file_sink.h>
+#include "preroll_valve.h"
+#include "dqpsk_slicer.h"
+#include "filter_cache.h"
 #include "recorder.h"
 #include "smartnet.h"
 
@@ -87,14 +88,24 @@ public:
 	void activate( Call *call, int n);
 
 	void deactivate();
+	void abort();
 	double get_freq();
 	bool is_active();
-	int lastupdate();
-	long elapsed();
+	int64_t lastupdate();
+	int64_t elapsed();
+	int64_t since_end_of_voice();
+	int64_t waiting_for_voice();
+	int64_t get_first_voice_time();
+	int64_t get_last_voice_time();
+	bool get_decode_quality(DecodeQuality &quality);
+	bool get_decode_totals(DecodeTotals &totals);
+	bool get_silence_gaps(std::vector<silence_gap> &gaps);
+	int64_t get_active_ms();
+	uint64_t get_audio_drops();
     Source *get_source();
 	gr::msg_queue::sptr tune_queue;
 	gr::msg_queue::sptr traffic_queue;
-	gr::msg_queue::sptr rx_queue;
+	gr::op25_repeater::trunk_msg_queue::sptr rx_queue;
 	//void forecast(int noutput_items, gr_vector_int &ninput_items_required);
 
 private:
@@ -104,15 +115,36 @@ private:
 	long talkgroup;
 	time_t timestamp;
 	time_t starttime;
+	int64_t activate_time;
+	int64_t active_ms;  // of the calls before the current one
 
         Source *source;
 	char filename[160];
 	char raw_filename[160];
 	int num;
+	long epoch;  // activation number, tags the first sample of each call
+	DecodeTotals decode_totals;  // of the calls before the current one
 
 	bool iam_logging;
 	bool active;
 
+	// end of transmission tracking from the frame assembler messages,
+	// all monotonic_ms()
+	int64_t first_voice_time;
+	int64_t last_voice_time;
+	int64_t voice_end_time;
+	void update_voice_state();
+
+	// frequency error seen while voice was being decoded, reported to
+	// the Source when the call ends
+	double costas_scale;  // costas loop radians per sample to Hz
+	double tune_scale;    // fsk4_demod tune message units to Hz
+	double freq_error_sum;
+	long freq_error_samples;
+	double tune_error;
+	bool has_tune_error;
+	void sample_freq_error();
+
 
 	std::vector<float> lpf_coeffs;
 	std::vector<float> arb_taps;
@@ -124,8 +156,6 @@ private:
 
 	gr::analog::sig_source_c::sptr lo;
 
-gr::digital::diff_phasor_cc::sptr diffdec;
-
 	gr::blocks::multiply_cc::sptr mixer;
 	gr::blocks::file_sink::sptr fs;
 
@@ -138,18 +168,17 @@ gr::digital::diff_phasor_cc::sptr diffdec;
 	gr::analog::feedforward_agc_cc::sptr agc;
 
 	gr::blocks::nonstop_wavfile_sink::sptr wav_sink;
+	silence_gate_sptr gate;  // NULL unless silence gating is on
 
 	gr::blocks::short_to_float::sptr converter;
-	gr::blocks::copy::sptr valve;
+	preroll_valve_sptr valve;
 
 	gr::blocks::multiply_const_ff::sptr multiplier;
-	gr::blocks::multiply_const_ff::sptr rescale;
-	gr::blocks::multiply_const_ff::sptr baseband_amp;
-	gr::blocks::complex_to_arg::sptr to_float;
 	gr::op25_repeater::fsk4_demod_ff::sptr fsk4_demod;
 	gr::op25_repeater::p25_frame_assembler::sptr op25_frame_assembler;
 
 	gr::op25_repeater::fsk4_slicer_fb::sptr slicer;
+	dqpsk_slicer_sptr dqpsk;
 	gr::op25_repeater::vocoder::sptr op25_vocoder;
 	gr::op25_repeater::gardner_costas_cc::sptr costas_clock;
 };
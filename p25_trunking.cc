@@ -3,14 +3,14 @@
 #include <boost/log/trivial.hpp>
 
 
-p25_trunking_sptr make_p25_trunking(double freq, double center, long s,  gr::msg_queue::sptr queue, bool qpsk)
+p25_trunking_sptr make_p25_trunking(double freq, double center, long s,  gr::op25_repeater::trunk_msg_queue::sptr queue, bool qpsk)
 {
 	return gnuradio::get_initial_sptr(new p25_trunking(freq, center, s, queue, qpsk));
 }
 
 
 
-p25_trunking::p25_trunking(double f, double c, long s, gr::msg_queue::sptr queue, bool qpsk)
+p25_trunking::p25_trunking(double f, double c, long s, gr::op25_repeater::trunk_msg_queue::sptr queue, bool qpsk)
 	: gr::hier_block2 ("p25_trunking",
 	                   gr::io_signature::make  (1, 1, sizeof(gr_complex)),
 	                   gr::io_signature::make  (0, 0, sizeof(float)))
@@ -41,6 +41,13 @@ p25_trunking::p25_trunking(double f, double c, long s, gr::msg_queue::sptr queue
         float costas_alpha = 0.04;
         float bb_gain = 1.0;
 
+	costas_scale = -if_rate / (2 * pi);
+	tune_scale = symbol_deviation / bb_gain;
+	freq_error_sum = 0;
+	freq_error_samples = 0;
+	tune_error = 0;
+	has_tune_error = false;
+
        	baseband_amp = gr::blocks::multiply_const_ff::make(bb_gain);
 
 
@@ -183,6 +190,42 @@ double p25_trunking::get_freq() {
 }
 
 
+// control channel messages that need to be decoded for an estimate
+static const long MIN_FREQ_ERROR_SAMPLES = 10;
+
+void p25_trunking::sample_freq_error() {
+	if (qpsk_mod) {
+		freq_error_sum += costas_clock->get_freq() * costas_scale;
+		freq_error_samples++;
+	} else {
+		// the demodulator only asks to be retuned once it is far off,
+		// the latest request is the one that counts
+		gr::message::sptr msg = tune_queue->delete_head_nowait();
+		while (msg) {
+			tune_error = msg->arg1() * tune_scale;
+			has_tune_error = true;
+			msg = tune_queue->delete_head_nowait();
+		}
+	}
+}
+
+bool p25_trunking::get_freq_error(double &offset) {
+	bool found = false;
+	if (qpsk_mod) {
+		if (freq_error_samples >= MIN_FREQ_ERROR_SAMPLES) {
+			offset = freq_error_sum / freq_error_samples;
+			found = true;
+		}
+	} else if (has_tune_error) {
+		offset = tune_error;
+		found = true;
+	}
+	freq_error_sum = 0;
+	freq_error_samples = 0;
+	has_tune_error = false;
+	return found;
+}
+
 void p25_trunking::tune_offset(double f) {
 	freq = f;
 	int offset_amount = (f - center);
@@ -68,29 +68,43 @@ class p25_trunking;
 
 typedef boost::shared_ptr<p25_trunking> p25_trunking_sptr;
 
-p25_trunking_sptr make_p25_trunking(double f, double c, long s, gr::msg_queue::sptr queue, bool qpsk);
+p25_trunking_sptr make_p25_trunking(double f, double c, long s, gr::op25_repeater::trunk_msg_queue::sptr queue, bool qpsk);
 
 class p25_trunking : public gr::hier_block2
 {
-	friend p25_trunking_sptr make_p25_trunking(double f, double c, long s, gr::msg_queue::sptr queue, bool qpsk);
+	friend p25_trunking_sptr make_p25_trunking(double f, double c, long s, gr::op25_repeater::trunk_msg_queue::sptr queue, bool qpsk);
 protected:
-	p25_trunking(double f, double c, long s, gr::msg_queue::sptr queue, bool qpsk);
+	p25_trunking(double f, double c, long s, gr::op25_repeater::trunk_msg_queue::sptr queue, bool qpsk);
 
 public:
 	~p25_trunking();
 
 	void tune_offset(double f);
 	double get_freq();
+	// takes the demodulator's estimate of the control channel offset,
+	// call while messages are being decoded
+	void sample_freq_error();
+	// Hz above the control channel frequency the signal was received
+	// since the last call, false if there are too few samples
+	bool get_freq_error(double &offset);
 
 	gr::msg_queue::sptr tune_queue;
 	gr::msg_queue::sptr traffic_queue;
-	gr::msg_queue::sptr rx_queue;
+	gr::op25_repeater::trunk_msg_queue::sptr rx_queue;
 	//void forecast(int noutput_items, gr_vector_int &ninput_items_required);
 
 private:
 	double center, freq;
     bool qpsk_mod;
 
+	// frequency error samples since get_freq_error()
+	double costas_scale;  // costas loop radians per sample to Hz
+	double tune_scale;    // fsk4_demod tune message units to Hz
+	double freq_error_sum;
+	long freq_error_samples;
+	double tune_error;
+	bool has_tune_error;
+
 	std::vector<float> lpf_coeffs;
 	std::vector<float> arb_taps;
 	std::vector<float> sym_taps;
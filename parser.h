@@ -2,6 +2,10 @@
 #define PARSE_H
 #include <iostream>
 #include <vector>
+#include <op25_repeater/trunk_msg_queue.h>
+
+typedef gr::op25_repeater::trunk_msg trunk_msg;
+typedef gr::op25_repeater::trunk_msg_queue trunk_msg_queue;
 
 enum MessageType {
 	GRANT = 0,
@@ -22,10 +26,11 @@ struct TrunkMessage {
 	bool emergency;
 	int tdma;
 	long source;
+	int64_t rx_time;  // trunk_msg::rx_time of the message it was parsed from
 };
 
 
 class TrunkParser {
-	std::vector<TrunkMessage> parse_message(std::string s);
+	std::vector<TrunkMessage> parse_message(const trunk_msg &msg);
 };
 #endif
\ No newline at end of file
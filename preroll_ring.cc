@@ -0,0 +1,101 @@
+#include "preroll_ring.h"
+#include "timestamp.h"
+#include <gnuradio/io_signature.h>
+#include <math.h>
+
+// full scale of the 16 bit samples, source samples are within [-1, 1]
+static const float PREROLL_SCALE = 32767.0;
+
+static inline int16_t to_short(float v)
+{
+	v *= PREROLL_SCALE;
+	if (v > PREROLL_SCALE)
+		return 32767;
+	if (v < -PREROLL_SCALE)
+		return -32767;
+	return (int16_t) lrintf(v);
+}
+
+preroll_ring_sptr make_preroll_ring(double rate, int64_t depth_ms)
+{
+	return preroll_ring_sptr (new preroll_ring (rate, depth_ms));
+}
+
+preroll_ring::preroll_ring(double rate, int64_t depth_ms)
+	: gr::sync_block ("preroll_ring",
+	                  gr::io_signature::make (1, 1, sizeof (gr_complex)),
+	                  gr::io_signature::make (0, 0, 0))
+{
+	d_rate = rate;
+	d_depth_ms = depth_ms;
+	d_written = 0;
+	d_written_time = monotonic_ms();
+
+	// power of two so the index is a mask
+	uint64_t want = (uint64_t) (rate * (depth_ms + SLACK_MS) / 1000.0);
+	uint64_t capacity = 1;
+	while (capacity < want)
+		capacity <<= 1;
+	d_buf.resize(capacity);
+	d_mask = capacity - 1;
+}
+
+preroll_ring::~preroll_ring()
+{
+}
+
+uint64_t preroll_ring::written()
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	return d_written;
+}
+
+uint64_t preroll_ring::sample_at(int64_t t)
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	uint64_t oldest = d_written > d_buf.size() ? d_written - d_buf.size() : 0;
+	int64_t age = d_written_time - t;
+
+	if (age <= 0)
+		return d_written;
+	uint64_t back = (uint64_t) (age * d_rate / 1000.0);
+	if (back >= d_written - oldest)
+		return oldest;
+	return d_written - back;
+}
+
+int preroll_ring::read(uint64_t &start, gr_complex *out, int n)
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	uint64_t oldest = d_written > d_buf.size() ? d_written - d_buf.size() : 0;
+
+	if (start < oldest)
+		start = oldest;
+	if (start >= d_written)
+		return 0;
+	if ((uint64_t) n > d_written - start)
+		n = d_written - start;
+
+	const float scale = 1.0 / PREROLL_SCALE;
+	for (int i = 0; i < n; i++) {
+		const std::complex<int16_t> &s = d_buf[(start + i) & d_mask];
+		out[i] = gr_complex(s.real() * scale, s.imag() * scale);
+	}
+	return n;
+}
+
+int
+preroll_ring::work (int noutput_items,
+                    gr_vector_const_void_star &input_items,
+                    gr_vector_void_star &output_items)
+{
+	const gr_complex *in = (const gr_complex *) input_items[0];
+	gr::thread::scoped_lock guard(d_mutex);
+
+	for (int i = 0; i < noutput_items; i++) {
+		d_buf[(d_written + i) & d_mask] = std::complex<int16_t>(to_short(in[i].real()), to_short(in[i].imag()));
+	}
+	d_written += noutput_items;
+	d_written_time = monotonic_ms();
+	return noutput_items;
+}
@@ -0,0 +1,74 @@
+#ifndef PREROLL_RING_H
+#define PREROLL_RING_H
+
+#include <complex>
+#include <vector>
+#include <stdint.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/thread/thread.h>
+
+class preroll_ring;
+
+typedef boost::shared_ptr<preroll_ring> preroll_ring_sptr;
+
+preroll_ring_sptr make_preroll_ring(double rate, int64_t depth_ms);
+
+/*!
+ * \brief History of the most recent baseband samples of a Source.
+ *
+ * Connected to the source block next to the recorders, it keeps the
+ * last depth_ms (plus some slack for the grant to activate latency)
+ * of samples as 16 bit I/Q, half the size of gr_complex. Samples are
+ * addressed by their absolute index in the source stream, which is
+ * the same as nitems_read() of any other block fed by the source, so
+ * a preroll_valve can replay the ring and then splice onto its live
+ * input without a gap or a duplicate.
+ */
+class preroll_ring : public gr::sync_block
+{
+	friend preroll_ring_sptr make_preroll_ring(double rate, int64_t depth_ms);
+
+	preroll_ring(double rate, int64_t depth_ms);
+
+	gr::thread::mutex d_mutex;
+	std::vector<std::complex<int16_t> > d_buf;
+	uint64_t d_mask;
+	uint64_t d_written;      // samples stored since the flowgraph started
+	int64_t d_written_time;  // monotonic_ms() when the newest sample arrived
+	double d_rate;
+	int64_t d_depth_ms;
+
+public:
+	// time allowed between the grant and the recorder activating, on
+	// top of the requested depth
+	static const int64_t SLACK_MS = 500;
+
+	~preroll_ring();
+
+	/*!
+	 * Index of the sample that arrived at monotonic_ms() time t,
+	 * clamped to the samples still in the ring.
+	 */
+	uint64_t sample_at(int64_t t);
+
+	/*! Index one past the newest sample. */
+	uint64_t written();
+
+	/*!
+	 * Copy up to n samples starting at index start to out.
+	 *
+	 * \return the number of samples copied; 0 if start is not in the
+	 * ring yet. If start has already been overwritten start is moved
+	 * up to the oldest sample still held.
+	 */
+	int read(uint64_t &start, gr_complex *out, int n);
+
+	int64_t depth() const { return d_depth_ms; }
+	size_t bytes() const { return d_buf.size() * sizeof(d_buf[0]); }
+
+	int work(int noutput_items,
+	         gr_vector_const_void_star &input_items,
+	         gr_vector_void_star &output_items);
+};
+
+#endif /* PREROLL_RING_H */
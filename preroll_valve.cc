@@ -0,0 +1,127 @@
+#include "preroll_valve.h"
+#include <gnuradio/io_signature.h>
+#include <op25_repeater/epoch_tag.h>
+#include <string.h>
+#include <algorithm>
+
+preroll_valve_sptr make_preroll_valve(preroll_ring_sptr ring, float catchup)
+{
+	return preroll_valve_sptr (new preroll_valve (ring, catchup));
+}
+
+preroll_valve::preroll_valve(preroll_ring_sptr ring, float catchup)
+	: gr::block ("preroll_valve",
+	             gr::io_signature::make (1, 1, sizeof (gr_complex)),
+	             gr::io_signature::make (1, 1, sizeof (gr_complex)))
+{
+	d_ring = ring;
+	// anything at or below real time would never catch up
+	d_catchup = catchup > 1.1 ? catchup : 1.1;
+	d_enabled = false;
+	d_catching_up = false;
+	d_cursor = 0;
+	d_credit = 0;
+	d_epoch = 0;
+	d_tag_pending = false;
+	// the output is not in step with the input while catching up
+	set_tag_propagation_policy(TPP_DONT);
+}
+
+preroll_valve::~preroll_valve()
+{
+}
+
+void preroll_valve::set_enabled(bool enabled)
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	d_enabled = enabled;
+	d_catching_up = false;
+}
+
+void preroll_valve::start_from(int64_t t, long epoch)
+{
+	uint64_t cursor = 0;
+	if (d_ring)
+		cursor = d_ring->sample_at(t);
+
+	gr::thread::scoped_lock guard(d_mutex);
+	d_cursor = cursor;
+	d_credit = 0;
+	d_catching_up = d_ring.get() != 0;
+	d_enabled = true;
+	d_epoch = epoch;
+	d_tag_pending = true;
+}
+
+bool preroll_valve::catching_up()
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	return d_catching_up;
+}
+
+void preroll_valve::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+{
+	// while catching up the output comes from the ring, input only
+	// paces the replay
+	ninput_items_required[0] = d_catching_up ? 1 : noutput_items;
+}
+
+void preroll_valve::tag_epoch(int produced)
+{
+	if (!d_tag_pending || !produced)
+		return;
+	add_item_tag(0, nitems_written(0), gr::op25_repeater::epoch_tag_key(), pmt::from_long(d_epoch));
+	d_tag_pending = false;
+}
+
+int
+preroll_valve::general_work (int noutput_items,
+                             gr_vector_int &ninput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items)
+{
+	const gr_complex *in = (const gr_complex *) input_items[0];
+	gr_complex *out = (gr_complex *) output_items[0];
+	int ninput = ninput_items[0];
+	gr::thread::scoped_lock guard(d_mutex);
+
+	if (!d_enabled) {
+		consume_each(ninput);
+		return 0;
+	}
+
+	if (d_catching_up) {
+		uint64_t live = nitems_read(0);
+
+		if (d_cursor < live) {
+			d_credit += ninput * d_catchup;
+			int n = std::min(noutput_items, (int) d_credit);
+			n = d_ring->read(d_cursor, out, n);
+			d_cursor += n;
+			d_credit -= n;
+			if (d_credit > noutput_items)
+				d_credit = noutput_items;
+			consume_each(ninput);
+			tag_epoch(n);
+			return n;
+		}
+
+		// caught up, drop the input that was already replayed and
+		// carry on with the live samples
+		uint64_t skip = d_cursor - live;
+		if (skip >= (uint64_t) ninput) {
+			consume_each(ninput);
+			return 0;
+		}
+		in += skip;
+		ninput -= skip;
+		consume_each(skip);
+		d_catching_up = false;
+	}
+
+	int n = std::min(noutput_items, ninput);
+	memcpy(out, in, n * sizeof(gr_complex));
+	consume_each(n);
+	tag_epoch(n);
+	return n;
+}
@@ -0,0 +1,74 @@
+#ifndef PREROLL_VALVE_H
+#define PREROLL_VALVE_H
+
+#include <stdint.h>
+#include <gnuradio/block.h>
+#include <gnuradio/thread/thread.h>
+#include "preroll_ring.h"
+
+class preroll_valve;
+
+typedef boost::shared_ptr<preroll_valve> preroll_valve_sptr;
+
+preroll_valve_sptr make_preroll_valve(preroll_ring_sptr ring, float catchup);
+
+/*!
+ * \brief Recorder input valve that can start in the past.
+ *
+ * While disabled it throws away its input, like a disabled
+ * gr::blocks::copy. start_from() enables it and first plays the
+ * Source's preroll_ring from a given time, then splices onto the live
+ * input at the exact sample where the ring caught up.
+ *
+ * Catching up runs the recorder faster than real time. To bound the
+ * CPU this takes, at most catchup ring samples are replayed for every
+ * live sample received, so the recorder runs at no more than catchup
+ * times real time for lag / (catchup - 1) of real time. Live input is
+ * consumed while catching up, the ring already holds it, so the
+ * source is never stalled.
+ *
+ * The first item output after start_from() carries an epoch_tag_key()
+ * tag with the activation number, so the blocks downstream can tell
+ * the new call's samples from the old one's still in their buffers.
+ */
+class preroll_valve : public gr::block
+{
+	friend preroll_valve_sptr make_preroll_valve(preroll_ring_sptr ring, float catchup);
+
+	preroll_valve(preroll_ring_sptr ring, float catchup);
+
+	gr::thread::mutex d_mutex;
+	preroll_ring_sptr d_ring;
+	float d_catchup;
+	bool d_enabled;
+	bool d_catching_up;
+	uint64_t d_cursor;       // next ring sample to replay
+	float d_credit;          // ring samples the catch-up bound still allows
+	long d_epoch;
+	bool d_tag_pending;      // d_epoch has not been tagged yet
+
+	void tag_epoch(int produced);
+
+public:
+	~preroll_valve();
+
+	void set_enabled(bool enabled);
+
+	/*!
+	 * Enable the valve as activation epoch, starting with the samples
+	 * that arrived at monotonic_ms() time t, or as far back as the
+	 * ring goes. Without a ring it starts with the live input.
+	 */
+	void start_from(int64_t t, long epoch);
+
+	bool catching_up();
+
+	void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+	int general_work(int noutput_items,
+	                 gr_vector_int &ninput_items,
+	                 gr_vector_const_void_star &input_items,
+	                 gr_vector_void_star &output_items);
+};
+
+#endif /* PREROLL_VALVE_H */
@@ -0,0 +1,278 @@
+#include "qa_call_archive.h"
+#include "call_archive.h"
+#include "nonstop_wavfile_sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <boost/bind.hpp>
+#include <boost/filesystem/operations.hpp>
+
+static std::string temp_dir()
+{
+	char dir[] = "/tmp/qa_call_archive.XXXXXX";
+	CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+	return dir;
+}
+
+static uint32_t lcg(uint32_t &seed)
+{
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+// the recording of call n, its size and contents made from n
+static std::vector<char> call_data(int n)
+{
+	uint32_t seed = n;
+	std::vector<char> data(44 + lcg(seed) % 65536);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = lcg(seed);
+	return data;
+}
+
+static std::string call_name(int n)
+{
+	std::ostringstream name;
+	name << "/calls/2017/7/14/" << n << "-1500000000.wav";
+	return name.str();
+}
+
+static std::vector<char> read_file(const std::string &filename)
+{
+	std::ifstream in(filename.c_str(), std::ios::binary);
+	CPPUNIT_ASSERT(in.good());
+	return std::vector<char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static void check_call(const std::string &dir, int n)
+{
+	std::string out = dir + "/out.wav";
+	CPPUNIT_ASSERT(CallArchive::extract(dir, call_name(n), out));
+	CPPUNIT_ASSERT(read_file(out) == call_data(n));
+	unlink(out.c_str());
+}
+
+// the one file of the day with extension ext
+static std::string day_file(const std::string &dir, const std::string &ext)
+{
+	std::string found;
+	boost::filesystem::directory_iterator end;
+	for (boost::filesystem::directory_iterator it(dir); it != end; it++) {
+		if (it->path().extension() == ext) {
+			CPPUNIT_ASSERT(found.empty());
+			found = it->path().string();
+		}
+	}
+	CPPUNIT_ASSERT(!found.empty());
+	return found;
+}
+
+void qa_call_archive::t_extract()
+{
+	std::string dir = temp_dir();
+	{
+		CallArchive archive(dir);
+		for (int n = 1; n <= 3; n++) {
+			std::vector<char> data = call_data(n);
+			CPPUNIT_ASSERT(archive.append(call_name(n), &data[0], data.size()));
+		}
+	}
+
+	// the index has the calls end to end, by file name
+	std::ifstream index(day_file(dir, ".idx").c_str());
+	uint64_t offset, expected = 0;
+	size_t size;
+	std::string file;
+	for (int n = 1; n <= 3; n++) {
+		CPPUNIT_ASSERT(index >> offset >> size >> file);
+		CPPUNIT_ASSERT_EQUAL(expected, offset);
+		CPPUNIT_ASSERT_EQUAL(call_data(n).size(), size);
+		CPPUNIT_ASSERT_EQUAL(boost::filesystem::path(call_name(n)).filename().string(), file);
+		expected += size;
+	}
+	CPPUNIT_ASSERT(!(index >> offset));
+	// the space allocated ahead is not in the size
+	CPPUNIT_ASSERT_EQUAL((uintmax_t) expected, boost::filesystem::file_size(day_file(dir, ".seg")));
+
+	check_call(dir, 2);
+	check_call(dir, 1);
+	check_call(dir, 3);
+
+	// by the last part of the name alone
+	std::string out = dir + "/out.wav";
+	CPPUNIT_ASSERT(CallArchive::extract(dir, "3-1500000000.wav", out));
+	CPPUNIT_ASSERT(read_file(out) == call_data(3));
+
+	CPPUNIT_ASSERT(!CallArchive::extract(dir, call_name(4), dir + "/missing.wav"));
+	CPPUNIT_ASSERT(!boost::filesystem::exists(dir + "/missing.wav"));
+
+	boost::filesystem::remove_all(dir);
+}
+
+static void archive_calls(CallArchive *archive, int first, int n, bool *ok)
+{
+	*ok = true;
+	for (int i = first; i < first + n; i++) {
+		std::vector<char> data = call_data(i);
+		*ok = archive->append(call_name(i), &data[0], data.size()) && *ok;
+	}
+}
+
+// the recorders' sinks archive their calls from the flow graph's threads
+void qa_call_archive::t_threads()
+{
+	static const int THREADS = 8;
+	static const int CALLS = 100;
+	std::string dir = temp_dir();
+	{
+		CallArchive archive(dir);
+		gr::thread::thread_group threads;
+		bool ok[THREADS];
+		for (int t = 0; t < THREADS; t++)
+			threads.create_thread(boost::bind(archive_calls, &archive, t * CALLS, CALLS, &ok[t]));
+		threads.join_all();
+		for (int t = 0; t < THREADS; t++)
+			CPPUNIT_ASSERT(ok[t]);
+	}
+
+	for (int i = 0; i < THREADS * CALLS; i += 7)
+		check_call(dir, i);
+	check_call(dir, THREADS * CALLS - 1);
+
+	boost::filesystem::remove_all(dir);
+}
+
+// a restart carries on after the calls already in the day's segment
+void qa_call_archive::t_reopen()
+{
+	std::string dir = temp_dir();
+	size_t before = 0;
+	{
+		CallArchive archive(dir);
+		for (int n = 1; n <= 2; n++) {
+			std::vector<char> data = call_data(n);
+			CPPUNIT_ASSERT(archive.append(call_name(n), &data[0], data.size()));
+			before += data.size();
+		}
+	}
+	{
+		CallArchive archive(dir);
+		std::vector<char> data = call_data(3);
+		CPPUNIT_ASSERT(archive.append(call_name(3), &data[0], data.size()));
+	}
+
+	CPPUNIT_ASSERT_EQUAL((uintmax_t) before + call_data(3).size(), boost::filesystem::file_size(day_file(dir, ".seg")));
+	for (int n = 1; n <= 3; n++)
+		check_call(dir, n);
+
+	boost::filesystem::remove_all(dir);
+}
+
+/*
+ * With an archive, the sink builds the file in memory and archives the
+ * finished WAV file when it is closed; nothing is written under its name.
+ */
+void qa_call_archive::t_sink()
+{
+	static const int N = 8000;
+	std::string dir = temp_dir();
+	std::string name = dir + "/calls/101-1500000000.wav";
+	CallArchive archive(dir);
+	gr::blocks::nonstop_wavfile_sink::set_archive(&archive);
+
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(name.c_str(), 1, 8000, 16);
+	std::vector<float> v(N);
+	for (int i = 0; i < N; i++)
+		v[i] = (i % 1000) / 32767.0f;
+	gr_vector_const_void_star in(1, &v[0]);
+	gr_vector_void_star out;
+	sink->work(N, in, out);
+	sink->close();
+	sink->stop();
+	std::vector<std::string> names;
+	gr::blocks::nonstop_wavfile_sink::finish_drained(names);
+	gr::blocks::nonstop_wavfile_sink::set_archive(NULL);
+	CPPUNIT_ASSERT(std::find(names.begin(), names.end(), name) != names.end());
+	CPPUNIT_ASSERT(!boost::filesystem::exists(name));
+
+	std::string output = dir + "/out.wav";
+	CPPUNIT_ASSERT(CallArchive::extract(dir, name, output));
+	std::vector<char> wav = read_file(output);
+	CPPUNIT_ASSERT_EQUAL((size_t) 44 + 2 * N, wav.size());
+	CPPUNIT_ASSERT(memcmp(&wav[0], "RIFF", 4) == 0);
+	CPPUNIT_ASSERT(memcmp(&wav[8], "WAVE", 4) == 0);
+	// the sizes filled in after the samples
+	const unsigned char *p = (const unsigned char *) &wav[0];
+	CPPUNIT_ASSERT_EQUAL((int) wav.size() - 8, p[4] | (p[5] << 8) | (p[6] << 16) | (p[7] << 24));
+	CPPUNIT_ASSERT_EQUAL(2 * N, p[40] | (p[41] << 8) | (p[42] << 16) | (p[43] << 24));
+	for (int i = 0; i < N; i++) {
+		short sample = p[44 + 2 * i] | (p[45 + 2 * i] << 8);
+		if (sample != i % 1000)
+			CPPUNIT_ASSERT_EQUAL(i % 1000, (int) sample);
+	}
+
+	boost::filesystem::remove_all(dir);
+}
+
+/*
+ * A call that ended without voice is dropped: nothing goes in the
+ * archive, or on disk without one, and the next call is kept as usual.
+ */
+void qa_call_archive::t_discard()
+{
+	static const int N = 800;
+	std::string dir = temp_dir();
+	std::string dropped = dir + "/101-1500000000.wav";
+	std::string kept = dir + "/101-1500000005.wav";
+	std::vector<float> v(N, 0.25f);
+	gr_vector_const_void_star in(1, &v[0]);
+	gr_vector_void_star out;
+	std::vector<std::string> names;
+	{
+		CallArchive archive(dir);
+		gr::blocks::nonstop_wavfile_sink::set_archive(&archive);
+		gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(NULL, 1, 8000, 16);
+
+		// installed and written to
+		sink->open(dropped.c_str());
+		sink->work(N, in, out);
+		sink->close();
+		sink->discard();
+		// still waiting for its epoch tag
+		sink->open(dropped.c_str(), 5);
+		sink->discard();
+
+		sink->open(kept.c_str());
+		sink->work(N, in, out);
+		sink->close();
+		sink->stop();
+		gr::blocks::nonstop_wavfile_sink::finish_drained(names);
+		gr::blocks::nonstop_wavfile_sink::set_archive(NULL);
+	}
+	CPPUNIT_ASSERT(std::find(names.begin(), names.end(), dropped) == names.end());
+	CPPUNIT_ASSERT(std::find(names.begin(), names.end(), kept) != names.end());
+	CPPUNIT_ASSERT(!CallArchive::extract(dir, dropped, dir + "/out.wav"));
+	CPPUNIT_ASSERT(CallArchive::extract(dir, kept, dir + "/out.wav"));
+	CPPUNIT_ASSERT_EQUAL((size_t) 44 + 2 * N, read_file(dir + "/out.wav").size());
+	// the kept call is the only one in the segment
+	CPPUNIT_ASSERT_EQUAL((uintmax_t) 44 + 2 * N, boost::filesystem::file_size(day_file(dir, ".seg")));
+
+	// a file on disk is removed
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(NULL, 1, 8000, 16);
+	sink->open(dropped.c_str());
+	sink->work(N, in, out);
+	CPPUNIT_ASSERT(boost::filesystem::exists(dropped));
+	sink->discard();
+	CPPUNIT_ASSERT(!boost::filesystem::exists(dropped));
+	sink->open(dropped.c_str(), 6);
+	CPPUNIT_ASSERT(boost::filesystem::exists(dropped));
+	sink->discard();
+	CPPUNIT_ASSERT(!boost::filesystem::exists(dropped));
+
+	boost::filesystem::remove_all(dir);
+}
@@ -0,0 +1,31 @@
+#ifndef QA_CALL_ARCHIVE_H
+#define QA_CALL_ARCHIVE_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * CallArchive: calls appended to the day's segment and index and
+ * extracted again byte for byte, from several threads at once and
+ * after a restart, and the WAV files nonstop_wavfile_sink archives or
+ * drops.
+ */
+class qa_call_archive : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_call_archive);
+	CPPUNIT_TEST(t_extract);
+	CPPUNIT_TEST(t_threads);
+	CPPUNIT_TEST(t_reopen);
+	CPPUNIT_TEST(t_sink);
+	CPPUNIT_TEST(t_discard);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_extract();
+	void t_threads();
+	void t_reopen();
+	void t_sink();
+	void t_discard();
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "qa_call_history.h"
+#include "call_history.h"
+#include "journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boost/filesystem/operations.hpp>
+
+static const int64_t TIMEOUT = 3000;
+static const int64_t EPOCH = 1500000000000LL;  // wall clock of monotonic 0
+static const double F1 = 851012500;
+static const double F2 = 851025000;
+
+static std::string temp_dir()
+{
+	char dir[] = "/tmp/qa_call_history.XXXXXX";
+	CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+	return dir;
+}
+
+struct Event {
+	int64_t t;  // rx_time, monotonic_ms()
+	MessageType type;
+	double freq;
+	long talkgroup;
+};
+
+/*
+ * A journal as a run started at monotonic_ms() start, epoch on the wall
+ * clock, would have written it: a message with one parsed message for
+ * each event.
+ */
+static void write_journal(const std::string &filename, int64_t start, int64_t epoch, const Event *events, int n)
+{
+	FILE *fp = fopen(filename.c_str(), "wb");
+	CPPUNIT_ASSERT(fp != NULL);
+	JournalHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+	header.record_size = sizeof(JournalRecord);
+	header.message_size = sizeof(JournalMessage);
+	header.monotonic_ms = start;
+	header.epoch_ms = epoch;
+	header.run_ms = start;
+	fwrite(&header, sizeof(header), 1, fp);
+
+	for (int i = 0; i < n; i++) {
+		JournalRecord record;
+		memset(&record, 0, sizeof(record));
+		record.rx_time = events[i].t;
+		record.type = 7;
+		record.parsed = 1;
+		fwrite(&record, sizeof(record), 1, fp);
+
+		JournalMessage message;
+		memset(&message, 0, sizeof(message));
+		message.freq = events[i].freq;
+		message.talkgroup = events[i].talkgroup;
+		message.message_type = events[i].type;
+		fwrite(&message, sizeof(message), 1, fp);
+	}
+	fclose(fp);
+}
+
+static void write_file(const std::string &filename, const char *text)
+{
+	FILE *fp = fopen(filename.c_str(), "w");
+	CPPUNIT_ASSERT(fp != NULL);
+	fputs(text, fp);
+	fclose(fp);
+}
+
+// the calls in one journal of events
+static std::vector<HistoricalCall> load_events(const Event *events, int n)
+{
+	std::string dir = temp_dir();
+	write_journal(dir + "/a.journal", 0, EPOCH, events, n);
+	CallHistory history(TIMEOUT);
+	history.load(std::vector<std::string>(1, dir));
+	boost::filesystem::remove_all(dir);
+	return history.get_calls();
+}
+
+static void check_call(const HistoricalCall &call, long talkgroup, double freq, int64_t start, int64_t last, int64_t cut)
+{
+	CPPUNIT_ASSERT_EQUAL(talkgroup, call.talkgroup);
+	CPPUNIT_ASSERT_EQUAL(freq, call.freq);
+	CPPUNIT_ASSERT_EQUAL(EPOCH + start, call.start);
+	CPPUNIT_ASSERT_EQUAL(EPOCH + last, call.last);
+	CPPUNIT_ASSERT_EQUAL(cut ? EPOCH + cut : 0, call.cut);
+}
+
+void qa_call_history::t_channel_reuse()
+{
+	const Event events[] = {
+		{ 1000, GRANT, F1, 100 },
+		{ 1500, UPDATE, F1, 100 },
+		{ 2000, GRANT, F1, 100 },
+		{ 2200, GRANT, F2, 300 },
+		{ 2500, GRANT, F1, 200 },  // ends 100, 300 goes on
+		{ 2600, UPDATE, F1, 100 },  // too late for the call that was cut
+		{ 3000, UPDATE, F2, 300 },
+		{ 3500, UPDATE, F1, 200 },
+	};
+	std::vector<HistoricalCall> calls = load_events(events, 8);
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, calls.size());
+	check_call(calls[0], 100, F1, 1000, 2000, 2500);
+	check_call(calls[1], 300, F2, 2200, 3000, 0);
+	check_call(calls[2], 200, F1, 2500, 3500, 0);
+
+	CPPUNIT_ASSERT_EQUAL(EPOCH + 2500, calls[0].end(1000));
+	CPPUNIT_ASSERT_EQUAL(EPOCH + 2300, calls[0].end(300));
+	CPPUNIT_ASSERT_EQUAL(EPOCH + 4000, calls[1].end(1000));
+}
+
+void qa_call_history::t_timeout()
+{
+	const Event events[] = {
+		{ 1000, GRANT, F1, 100 },
+		{ 1000 + TIMEOUT, UPDATE, F1, 100 },
+		// quiet for longer than the timeout: a new call, and the update
+		// does not belong to any
+		{ 2001 + 2 * TIMEOUT, UPDATE, F1, 100 },
+		{ 2002 + 2 * TIMEOUT, GRANT, F1, 100 },
+		{ 2003 + 2 * TIMEOUT, UPDATE, F1, 100 },
+	};
+	std::vector<HistoricalCall> calls = load_events(events, 5);
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, calls.size());
+	check_call(calls[0], 100, F1, 1000, 1000 + TIMEOUT, 0);
+	check_call(calls[1], 100, F1, 2002 + 2 * TIMEOUT, 2003 + 2 * TIMEOUT, 0);
+
+	// a grant on the channel of a call that has ended leaves it, and
+	// the talkgroup's next call, alone
+	const Event later[] = {
+		{ 1000, GRANT, F1, 100 },
+		{ 1001 + TIMEOUT, GRANT, F2, 100 },
+		{ 1002 + TIMEOUT, GRANT, F1, 200 },
+		{ 1003 + TIMEOUT, UPDATE, F2, 100 },
+	};
+	calls = load_events(later, 4);
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, calls.size());
+	check_call(calls[0], 100, F1, 1000, 1000, 0);
+	check_call(calls[1], 100, F2, 1001 + TIMEOUT, 1003 + TIMEOUT, 0);
+	check_call(calls[2], 200, F1, 1002 + TIMEOUT, 1002 + TIMEOUT, 0);
+}
+
+/*
+ * A call moved to another channel keeps its recorder, so a grant on
+ * the channel it left does not end it, and one on its new channel does.
+ */
+void qa_call_history::t_retune()
+{
+	const Event events[] = {
+		{ 1000, GRANT, F1, 100 },
+		{ 1500, GRANT, F2, 100 },
+		{ 2000, GRANT, F1, 200 },
+		{ 2500, GRANT, F2, 300 },
+	};
+	std::vector<HistoricalCall> calls = load_events(events, 4);
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, calls.size());
+	check_call(calls[0], 100, F1, 1000, 1500, 2500);
+	check_call(calls[1], 200, F1, 2000, 2000, 0);
+	check_call(calls[2], 300, F2, 2500, 2500, 0);
+}
+
+/*
+ * Journals of two runs, the second after a reboot reset the monotonic
+ * clock, and call files, found in a directory tree and merged in order
+ * of their start on the wall clock. Files that are not calls are left out.
+ */
+void qa_call_history::t_files()
+{
+	std::string dir = temp_dir();
+	boost::filesystem::create_directories(dir + "/later");
+
+	const Event first_run[] = {
+		{ 1000, GRANT, F1, 100 },
+		{ 2000, UPDATE, F1, 100 },
+	};
+	write_journal(dir + "/2017-07-14-024000.journal", 0, EPOCH, first_run, 2);
+	const Event second_run[] = {
+		{ 600, GRANT, F1, 200 },
+	};
+	write_journal(dir + "/later/2017-07-14-052640.journal", 500, EPOCH + 10000000, second_run, 1);
+
+	char text[256];
+	snprintf(text, sizeof(text), "{\n\"freq\": %.0f,\n\"talkgroup\": 400,\n\"emergency\": 1,\n\"grantTime\": %lld,\n\"lastVoiceTime\": %lld,\n\"stopTime\": %lld\n}\n",
+		F2, (long long) EPOCH + 5000, (long long) EPOCH + 7000, (long long) EPOCH + 8000);
+	write_file(dir + "/400.json", text);
+	// no voice
+	snprintf(text, sizeof(text), "{\n\"freq\": %.0f,\n\"talkgroup\": 500,\n\"grantTime\": %lld,\n\"lastVoiceTime\": null,\n\"stopTime\": %lld\n}\n",
+		F1, (long long) EPOCH + 6000, (long long) EPOCH + 6500);
+	write_file(dir + "/later/500.json", text);
+	// from before the times were written, not a call, and not JSON
+	write_file(dir + "/old.json", "{\n\"freq\": 851012500,\n\"talkgroup\": 600,\n\"stopTime\": 1500000000000\n}\n");
+	write_file(dir + "/config.json", "{\n\"sources\": []\n}\n");
+	write_file(dir + "/bad.json", "{\n\"freq\": ");
+	write_file(dir + "/notes.txt", "not read\n");
+
+	CallHistory history(TIMEOUT);
+	history.load(std::vector<std::string>(1, dir));
+	const std::vector<HistoricalCall> &calls = history.get_calls();
+	CPPUNIT_ASSERT_EQUAL((size_t) 4, calls.size());
+	check_call(calls[0], 100, F1, 1000, 2000, 0);
+	check_call(calls[1], 400, F2, 5000, 7000, 0);
+	CPPUNIT_ASSERT(calls[1].emergency);
+	check_call(calls[2], 500, F1, 6000, 6500, 0);
+	CPPUNIT_ASSERT(!calls[2].emergency);
+	check_call(calls[3], 200, F1, 10000100, 10000100, 0);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 10000100 - 1000, history.get_span());
+
+	boost::filesystem::remove_all(dir);
+}
@@ -0,0 +1,29 @@
+#ifndef QA_CALL_HISTORY_H
+#define QA_CALL_HISTORY_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * CallHistory condensing journals and call files into calls: a grant
+ * continuing a call or cutting off another on its channel, quiet
+ * talkgroups starting new calls, and runs on different clocks lined
+ * up on the wall clock.
+ */
+class qa_call_history : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_call_history);
+	CPPUNIT_TEST(t_channel_reuse);
+	CPPUNIT_TEST(t_timeout);
+	CPPUNIT_TEST(t_retune);
+	CPPUNIT_TEST(t_files);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_channel_reuse();
+	void t_timeout();
+	void t_retune();
+	void t_files();
+};
+
+#endif
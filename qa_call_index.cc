@@ -0,0 +1,198 @@
+#include "qa_call_index.h"
+#include "call_index.h"
+#include "timestamp.h"
+
+#include <sqlite3.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <boost/filesystem/operations.hpp>
+#include <boost/lexical_cast.hpp>
+
+static std::string temp_dir()
+{
+	char dir[] = "/tmp/qa_call_index.XXXXXX";
+	CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+	return dir;
+}
+
+static CallIndexRecord record(long talkgroup, int64_t grant_time)
+{
+	CallIndexRecord r;
+	r.talkgroup = talkgroup;
+	r.freq = 851012500;
+	r.tdma = 0;
+	r.emergency = false;
+	r.encrypted = false;
+	r.priority = 2;
+	r.grant_time = grant_time;
+	r.recorder_time = grant_time + 20;
+	r.first_voice_time = grant_time + 300;
+	r.last_voice_time = grant_time + 4000;
+	r.stop_time = grant_time + 6000;
+	r.filename = "/calls/" + boost::lexical_cast<std::string>(talkgroup) + ".wav";
+	r.has_quality = false;
+	r.voice_error_rate = 0;
+	r.has_mer = false;
+	r.mer = 0;
+	r.sync_losses = 0;
+	r.frames = 0;
+	r.silence_removed_ms = 0;
+	return r;
+}
+
+// a query's single row as text, NULL columns as "-", separated by '|'
+static std::string query(sqlite3 *db, const std::string &sql)
+{
+	sqlite3_stmt *stmt = NULL;
+	CPPUNIT_ASSERT_EQUAL(SQLITE_OK, sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL));
+	CPPUNIT_ASSERT_EQUAL(SQLITE_ROW, sqlite3_step(stmt));
+	std::string row;
+	for (int i = 0; i < sqlite3_column_count(stmt); i++) {
+		if (i) {
+			row += "|";
+		}
+		const unsigned char *text = sqlite3_column_text(stmt, i);
+		row += text ? (const char *) text : "-";
+	}
+	CPPUNIT_ASSERT_EQUAL(SQLITE_DONE, sqlite3_step(stmt));
+	sqlite3_finalize(stmt);
+	return row;
+}
+
+static sqlite3 *open_db(const std::string &filename)
+{
+	sqlite3 *db = NULL;
+	CPPUNIT_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(filename.c_str(), &db));
+	sqlite3_busy_timeout(db, 5000);
+	return db;
+}
+
+void qa_call_index::t_rows()
+{
+	std::string dir = temp_dir();
+	std::string filename = dir + "/calls.db";
+	CallIndex index;
+	CPPUNIT_ASSERT(index.open(filename));
+
+	// a C4FM call with units and no voice
+	CallIndexRecord plain = record(101, 1500000000000LL);
+	plain.first_voice_time = 0;
+	plain.last_voice_time = 0;
+	plain.has_quality = true;
+	plain.voice_error_rate = 0.25;
+	plain.sync_losses = 2;
+	plain.frames = 40;
+	plain.units.push_back(1234567);
+	plain.units.push_back(7654321);
+	index.add(plain);
+
+	// a CQPSK emergency call with its silence taken out
+	CallIndexRecord cqpsk = record(202, 1500000010000LL);
+	cqpsk.tdma = 1;
+	cqpsk.emergency = true;
+	cqpsk.has_quality = true;
+	cqpsk.has_mer = true;
+	cqpsk.mer = 21.5;
+	cqpsk.frames = 80;
+	cqpsk.silence_removed_ms = 1750;
+	cqpsk.units.push_back(1234567);
+	index.add(cqpsk);
+
+	// an analog call, no decode quality at all
+	CallIndexRecord analog = record(303, 1500000020000LL);
+	analog.encrypted = true;
+	index.add(analog);
+	index.close();
+
+	// and nothing after close()
+	index.add(record(404, 1500000030000LL));
+
+	sqlite3 *db = open_db(filename);
+	CPPUNIT_ASSERT_EQUAL(std::string("3"), query(db, "SELECT COUNT(*) FROM calls;"));
+	CPPUNIT_ASSERT_EQUAL(std::string("101|851012500.0|0|0|0|2|1500000000000|1500000000020|-|-|1500000006000|/calls/101.wav|0.25|-|2|40|0"),
+		query(db, "SELECT talkgroup, freq, tdma, emergency, encrypted, priority, grant_time, recorder_time, first_voice_time,"
+		          " last_voice_time, stop_time, filename, voice_error_rate, mer, sync_losses, frames, silence_removed"
+		          " FROM calls WHERE talkgroup = 101;"));
+	CPPUNIT_ASSERT_EQUAL(std::string("1|1|1500000010300|1500000014000|21.5|80|1750"),
+		query(db, "SELECT tdma, emergency, first_voice_time, last_voice_time, mer, frames, silence_removed FROM calls WHERE talkgroup = 202;"));
+	CPPUNIT_ASSERT_EQUAL(std::string("1|-|-|-|-"),
+		query(db, "SELECT encrypted, voice_error_rate, mer, sync_losses, frames FROM calls WHERE talkgroup = 303;"));
+
+	// the units, and finding calls by them
+	CPPUNIT_ASSERT_EQUAL(std::string("2"), query(db, "SELECT COUNT(*) FROM call_units JOIN calls ON calls.id = call_id WHERE talkgroup = 101;"));
+	CPPUNIT_ASSERT_EQUAL(std::string("101,202"), query(db, "SELECT GROUP_CONCAT(talkgroup) FROM (SELECT talkgroup FROM calls JOIN call_units ON call_units.call_id = calls.id WHERE unit = 1234567 ORDER BY talkgroup);"));
+	CPPUNIT_ASSERT_EQUAL(std::string("0"), query(db, "SELECT COUNT(*) FROM call_units JOIN calls ON calls.id = call_id WHERE talkgroup = 303;"));
+	sqlite3_close(db);
+
+	boost::filesystem::remove_all(dir);
+}
+
+/*
+ * Calls are written in batches by the index's own thread, and can be
+ * read by another connection without closing the index.
+ */
+void qa_call_index::t_while_writing()
+{
+	std::string dir = temp_dir();
+	std::string filename = dir + "/calls.db";
+	CallIndex index;
+	CPPUNIT_ASSERT(index.open(filename));
+	sqlite3 *db = open_db(filename);
+
+	const int N = 1000;
+	for (int i = 0; i < N; i++) {
+		index.add(record(1000 + i, 1500000000000LL + i * 1000));
+	}
+	// written within a flush interval, without close()
+	std::string count;
+	int64_t start = monotonic_ms();
+	while (monotonic_ms() - start < 5000) {
+		count = query(db, "SELECT COUNT(*) FROM calls;");
+		if (count == "1000") {
+			break;
+		}
+		usleep(50000);
+	}
+	CPPUNIT_ASSERT_EQUAL(std::string("1000"), count);
+	CPPUNIT_ASSERT_EQUAL(std::string("wal"), query(db, "PRAGMA journal_mode;"));
+
+	// a reopened index adds to what is there
+	index.close();
+	CPPUNIT_ASSERT(index.open(filename));
+	index.add(record(5, 1400000000000LL));
+	index.close();
+	CPPUNIT_ASSERT_EQUAL(std::string("1001|5"), query(db, "SELECT COUNT(*), MIN(talkgroup) FROM calls;"));
+	sqlite3_close(db);
+
+	boost::filesystem::remove_all(dir);
+}
+
+// a database made before silence_removed was added gets the column
+void qa_call_index::t_old_database()
+{
+	std::string dir = temp_dir();
+	std::string filename = dir + "/calls.db";
+	sqlite3 *db = open_db(filename);
+	CPPUNIT_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db,
+		"CREATE TABLE calls (id INTEGER PRIMARY KEY, talkgroup INTEGER NOT NULL, freq REAL NOT NULL,"
+		" tdma INTEGER NOT NULL, emergency INTEGER NOT NULL, encrypted INTEGER NOT NULL, priority INTEGER NOT NULL,"
+		" grant_time INTEGER NOT NULL, recorder_time INTEGER, first_voice_time INTEGER, last_voice_time INTEGER,"
+		" stop_time INTEGER, filename TEXT, voice_error_rate REAL, mer REAL, sync_losses INTEGER, frames INTEGER);"
+		"INSERT INTO calls (talkgroup, freq, tdma, emergency, encrypted, priority, grant_time)"
+		" VALUES (7, 851012500, 0, 0, 0, 1, 1400000000000);", NULL, NULL, NULL));
+	sqlite3_close(db);
+
+	CallIndex index;
+	CPPUNIT_ASSERT(index.open(filename));
+	CallIndexRecord r = record(8, 1500000000000LL);
+	r.silence_removed_ms = 300;
+	index.add(r);
+	index.close();
+
+	db = open_db(filename);
+	CPPUNIT_ASSERT_EQUAL(std::string("7|-,8|300"), query(db,
+		"SELECT GROUP_CONCAT(row) FROM (SELECT talkgroup || '|' || IFNULL(silence_removed, '-') AS row FROM calls ORDER BY talkgroup);"));
+	sqlite3_close(db);
+
+	boost::filesystem::remove_all(dir);
+}
@@ -0,0 +1,26 @@
+#ifndef QA_CALL_INDEX_H
+#define QA_CALL_INDEX_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * CallIndex against a database in a temporary directory: the rows and
+ * units written, batches read by another connection while the writer
+ * runs, and a database from before the silence_removed column.
+ */
+class qa_call_index : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_call_index);
+	CPPUNIT_TEST(t_rows);
+	CPPUNIT_TEST(t_while_writing);
+	CPPUNIT_TEST(t_old_database);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_rows();
+	void t_while_writing();
+	void t_old_database();
+};
+
+#endif
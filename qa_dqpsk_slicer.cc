@@ -0,0 +1,122 @@
+#include "qa_dqpsk_slicer.h"
+#include "dqpsk_slicer.h"
+
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/vector_source_c.h>
+#include <gnuradio/blocks/vector_sink_b.h>
+#include <gnuradio/blocks/complex_to_arg.h>
+#include <gnuradio/blocks/multiply_const_ff.h>
+#include <gnuradio/digital/diff_phasor_cc.h>
+#include <op25_repeater/fsk4_slicer_fb.h>
+#include <op25_repeater/epoch_tag.h>
+#include <math.h>
+
+static std::vector<float> levels()
+{
+	const float l[] = { -2.0, 0.0, 2.0, 4.0 };
+	return std::vector<float>(l, l + 4);
+}
+
+static uint32_t lcg(uint32_t &seed)
+{
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+/*
+ * n DQPSK symbols, each a phase step of a random odd multiple of pi/4,
+ * with up to +/- noise radians of phase noise and some amplitude
+ * ripple, as the costas loop hands them over.
+ */
+static std::vector<gr_complex> dqpsk_symbols(int n, float noise, uint32_t seed)
+{
+	std::vector<gr_complex> v(n);
+	float phase = 0;
+	for (int i = 0; i < n; i++) {
+		phase += (2 * (int) (lcg(seed) & 3) - 3) * M_PI / 4;
+		float jitter = noise * ((lcg(seed) & 0xffff) / 32768.0f - 1);
+		float amplitude = 1 + 0.1f * ((lcg(seed) & 0xffff) / 32768.0f - 1);
+		v[i] = std::polar(amplitude, phase + jitter);
+	}
+	return v;
+}
+
+void qa_dqpsk_slicer::t_same_as_chain()
+{
+	static const int N = 100000;
+	// noisy enough that some symbols land near the slice levels
+	std::vector<gr_complex> symbols = dqpsk_symbols(N, 0.6, 1);
+
+	gr::top_block_sptr tb = gr::make_top_block("qa_dqpsk_slicer");
+	gr::blocks::vector_source_c::sptr src = gr::blocks::vector_source_c::make(symbols);
+
+	gr::digital::diff_phasor_cc::sptr diffdec = gr::digital::diff_phasor_cc::make();
+	gr::blocks::complex_to_arg::sptr to_float = gr::blocks::complex_to_arg::make();
+	gr::blocks::multiply_const_ff::sptr rescale = gr::blocks::multiply_const_ff::make(4.0 / M_PI);
+	gr::op25_repeater::fsk4_slicer_fb::sptr slicer = gr::op25_repeater::fsk4_slicer_fb::make(levels());
+	gr::blocks::vector_sink_b::sptr chain_out = gr::blocks::vector_sink_b::make();
+	tb->connect(src, 0, diffdec, 0);
+	tb->connect(diffdec, 0, to_float, 0);
+	tb->connect(to_float, 0, rescale, 0);
+	tb->connect(rescale, 0, slicer, 0);
+	tb->connect(slicer, 0, chain_out, 0);
+
+	dqpsk_slicer_sptr dqpsk = make_dqpsk_slicer(levels());
+	gr::blocks::vector_sink_b::sptr dqpsk_out = gr::blocks::vector_sink_b::make();
+	tb->connect(src, 0, dqpsk, 0);
+	tb->connect(dqpsk, 0, dqpsk_out, 0);
+	tb->run();
+
+	std::vector<unsigned char> expected = chain_out->data();
+	std::vector<unsigned char> got = dqpsk_out->data();
+	CPPUNIT_ASSERT_EQUAL((size_t) N, expected.size());
+	CPPUNIT_ASSERT_EQUAL((size_t) N, got.size());
+	for (int i = 0; i < N; i++) {
+		if (expected[i] != got[i]) {
+			CPPUNIT_ASSERT_EQUAL((int) expected[i], (int) got[i]);
+		}
+	}
+}
+
+void qa_dqpsk_slicer::t_symbol_error()
+{
+	static const int N = 20000;
+	static const int TAG = 5000;
+	// clean symbols until the tag, noisy ones after it
+	std::vector<gr_complex> symbols = dqpsk_symbols(TAG, 0, 2);
+	std::vector<gr_complex> noisy = dqpsk_symbols(N - TAG, 0.3, 3);
+	gr_complex step = symbols.back() / std::abs(symbols.back());
+	for (size_t i = 0; i < noisy.size(); i++)
+		symbols.push_back(noisy[i] * step);
+
+	std::vector<gr::tag_t> tags(1);
+	tags[0].offset = TAG;
+	tags[0].key = gr::op25_repeater::epoch_tag_key();
+	tags[0].value = pmt::from_long(4);
+
+	gr::top_block_sptr tb = gr::make_top_block("qa_dqpsk_slicer");
+	gr::blocks::vector_source_c::sptr src = gr::blocks::vector_source_c::make(symbols, false, 1, tags);
+	dqpsk_slicer_sptr dqpsk = make_dqpsk_slicer(levels());
+	gr::blocks::vector_sink_b::sptr sink = gr::blocks::vector_sink_b::make();
+	tb->connect(src, 0, dqpsk, 0);
+	tb->connect(dqpsk, 0, sink, 0);
+	tb->run();
+
+	// only the symbols from the tag on are counted
+	long epoch;
+	double mean_square;
+	uint64_t count;
+	dqpsk->get_symbol_error(epoch, mean_square, count);
+	CPPUNIT_ASSERT_EQUAL(4l, epoch);
+	CPPUNIT_ASSERT_EQUAL((uint64_t) (N - TAG), count);
+	// uniform phase noise of +/- 0.3 rad is 0.03 rad^2 on each symbol,
+	// twice that on the difference of two, and (4/pi)^2 times that in
+	// symbol units
+	double expected = 2 * 0.3 * 0.3 / 3 * 16 / (M_PI * M_PI);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, mean_square, expected * 0.1);
+
+	// tags go through to the frame assembler
+	std::vector<gr::tag_t> out_tags = sink->tags();
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, out_tags.size());
+	CPPUNIT_ASSERT_EQUAL((uint64_t) TAG, out_tags[0].offset);
+}
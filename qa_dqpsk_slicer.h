@@ -0,0 +1,24 @@
+#ifndef QA_DQPSK_SLICER_H
+#define QA_DQPSK_SLICER_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * dqpsk_slicer against the diff_phasor_cc, complex_to_arg,
+ * multiply_const_ff and fsk4_slicer_fb chain it replaced, and its
+ * symbol error measurement.
+ */
+class qa_dqpsk_slicer : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_dqpsk_slicer);
+	CPPUNIT_TEST(t_same_as_chain);
+	CPPUNIT_TEST(t_symbol_error);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_same_as_chain();
+	void t_symbol_error();
+};
+
+#endif
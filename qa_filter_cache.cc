@@ -0,0 +1,38 @@
+#include "qa_filter_cache.h"
+#include "filter_cache.h"
+
+using gr::filter::firdes;
+
+void qa_filter_cache::t_same_as_firdes()
+{
+	std::vector<float> expected = firdes::low_pass(1.0, 2400000, 6000, 1500, firdes::WIN_HANN);
+	CPPUNIT_ASSERT(cached_low_pass(1.0, 2400000, 6000, 1500, firdes::WIN_HANN) == expected);
+	// and again from the cache
+	CPPUNIT_ASSERT(cached_low_pass(1.0, 2400000, 6000, 1500, firdes::WIN_HANN) == expected);
+
+	expected = firdes::low_pass_2(32, 32, 0.3, 0.05, 60, firdes::WIN_KAISER, 5.0);
+	CPPUNIT_ASSERT(cached_low_pass_2(32, 32, 0.3, 0.05, 60, firdes::WIN_KAISER, 5.0) == expected);
+	CPPUNIT_ASSERT(cached_low_pass_2(32, 32, 0.3, 0.05, 60, firdes::WIN_KAISER, 5.0) == expected);
+}
+
+void qa_filter_cache::t_designed_once()
+{
+	size_t before = cached_filter_count();
+
+	// a source's worth of recorders asking for their channel filter
+	for (int i = 0; i < 30; i++)
+		cached_low_pass(1.0, 8000000, 7000, 1500, firdes::WIN_HANN);
+	CPPUNIT_ASSERT_EQUAL(before + 1, cached_filter_count());
+
+	// any parameter that differs is a design of its own
+	cached_low_pass(1.0, 8000000, 7000, 1500, firdes::WIN_HAMMING);
+	cached_low_pass(1.0, 8000000, 7000, 2000, firdes::WIN_HANN);
+	cached_low_pass(1.0, 8000000, 7000, 1500, firdes::WIN_KAISER, 5.0);
+	cached_low_pass(1.0, 8000000, 7000, 1500, firdes::WIN_KAISER, 6.0);
+	CPPUNIT_ASSERT_EQUAL(before + 5, cached_filter_count());
+
+	// low_pass_2 with the same leading parameters is too
+	cached_low_pass_2(1.0, 8000000, 7000, 1500, 60, firdes::WIN_HANN);
+	cached_low_pass_2(1.0, 8000000, 7000, 1500, 60, firdes::WIN_HANN);
+	CPPUNIT_ASSERT_EQUAL(before + 6, cached_filter_count());
+}
@@ -0,0 +1,23 @@
+#ifndef QA_FILTER_CACHE_H
+#define QA_FILTER_CACHE_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * The filter cache hands back what firdes designs, and designs each
+ * set of parameters once however many recorders ask for it.
+ */
+class qa_filter_cache : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_filter_cache);
+	CPPUNIT_TEST(t_same_as_firdes);
+	CPPUNIT_TEST(t_designed_once);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_same_as_firdes();
+	void t_designed_once();
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "qa_journal.h"
+#include "journal.h"
+#include "timestamp.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <boost/filesystem/operations.hpp>
+
+static std::string temp_dir()
+{
+	char dir[] = "/tmp/qa_journal.XXXXXX";
+	CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+	return dir;
+}
+
+// the journal files in dir, in name order
+static std::vector<std::string> journals(const std::string &dir)
+{
+	std::vector<std::string> files;
+	boost::filesystem::directory_iterator end;
+	for (boost::filesystem::directory_iterator it(dir); it != end; it++) {
+		CPPUNIT_ASSERT(it->path().extension() == ".journal");
+		files.push_back(it->path().string());
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+// message i of a test run, with i grants parsed out of it
+static void message(int i, trunk_msg &msg, std::vector<TrunkMessage> &messages)
+{
+	memset(&msg, 0, sizeof(msg));
+	msg.type = 7;
+	msg.nac = 0x293;
+	msg.errors = i % 3;
+	msg.len = 10;
+	msg.rx_time = 1000 + i * 25;
+	for (int j = 0; j < 10; j++) {
+		msg.data[j] = i + j;
+	}
+
+	messages.clear();
+	for (int j = 0; j < i % 3; j++) {
+		TrunkMessage message;
+		memset(&message, 0, sizeof(message));
+		message.message_type = GRANT;
+		message.freq = 851012500 + j * 12500;
+		message.talkgroup = 100 + i;
+		message.source = 5000 + j;
+		message.encrypted = j == 1;
+		message.emergency = j == 0;
+		message.tdma = j;
+		message.rx_time = msg.rx_time;
+		messages.push_back(message);
+	}
+}
+
+static void write_run(const std::string &dir, int first, int n)
+{
+	JournalWriter writer(dir);
+	trunk_msg msg;
+	std::vector<TrunkMessage> messages;
+	for (int i = first; i < first + n; i++) {
+		message(i, msg, messages);
+		writer.append(msg, messages);
+	}
+}
+
+// reads the whole file back, checking it holds messages first, first + 1 ...
+static int check_file(const std::string &filename, int first)
+{
+	JournalReader reader;
+	CPPUNIT_ASSERT(reader.open(filename));
+	trunk_msg msg, expected;
+	std::vector<TrunkMessage> messages, expected_messages;
+	int n = 0;
+	while (reader.next(msg, messages)) {
+		message(first + n, expected, expected_messages);
+		CPPUNIT_ASSERT_EQUAL(expected.type, msg.type);
+		CPPUNIT_ASSERT_EQUAL(expected.nac, msg.nac);
+		CPPUNIT_ASSERT_EQUAL(expected.errors, msg.errors);
+		CPPUNIT_ASSERT_EQUAL(expected.len, msg.len);
+		CPPUNIT_ASSERT_EQUAL(expected.rx_time, msg.rx_time);
+		CPPUNIT_ASSERT(memcmp(expected.data, msg.data, msg.len) == 0);
+		CPPUNIT_ASSERT_EQUAL(expected_messages.size(), messages.size());
+		for (size_t j = 0; j < messages.size(); j++) {
+			CPPUNIT_ASSERT_EQUAL(expected_messages[j].message_type, messages[j].message_type);
+			CPPUNIT_ASSERT_EQUAL(expected_messages[j].freq, messages[j].freq);
+			CPPUNIT_ASSERT_EQUAL(expected_messages[j].talkgroup, messages[j].talkgroup);
+			CPPUNIT_ASSERT_EQUAL(expected_messages[j].source, messages[j].source);
+			CPPUNIT_ASSERT_EQUAL(expected_messages[j].encrypted, messages[j].encrypted);
+			CPPUNIT_ASSERT_EQUAL(expected_messages[j].emergency, messages[j].emergency);
+			CPPUNIT_ASSERT_EQUAL(expected_messages[j].tdma, messages[j].tdma);
+			CPPUNIT_ASSERT_EQUAL(expected.rx_time, messages[j].rx_time);
+		}
+		n++;
+	}
+	return n;
+}
+
+void qa_journal::t_round_trip()
+{
+	std::string dir = temp_dir();
+	int64_t before = monotonic_ms();
+	write_run(dir, 0, 500);
+
+	std::vector<std::string> files = journals(dir);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, files.size());
+	CPPUNIT_ASSERT_EQUAL(500, check_file(files[0], 0));
+
+	JournalReader reader;
+	CPPUNIT_ASSERT(reader.open(files[0]));
+	CPPUNIT_ASSERT(reader.get_monotonic_ms() >= before);
+	CPPUNIT_ASSERT(reader.get_monotonic_ms() <= monotonic_ms());
+	CPPUNIT_ASSERT(reader.get_run_ms() >= before);
+	CPPUNIT_ASSERT(reader.get_run_ms() <= reader.get_monotonic_ms());
+	int64_t offset = reader.get_epoch_ms() - reader.get_monotonic_ms();
+	CPPUNIT_ASSERT(labs(offset - (monotonic_to_epoch_ms(0))) < 1000);
+
+	boost::filesystem::remove_all(dir);
+}
+
+/*
+ * Runs started one after another, within the same second, each write a
+ * file of their own, in name order, with the run in the header.
+ */
+void qa_journal::t_file_per_run()
+{
+	std::string dir = temp_dir();
+	write_run(dir, 0, 10);
+	write_run(dir, 10, 20);
+	write_run(dir, 30, 5);
+
+	std::vector<std::string> files = journals(dir);
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, files.size());
+	CPPUNIT_ASSERT_EQUAL(10, check_file(files[0], 0));
+	CPPUNIT_ASSERT_EQUAL(20, check_file(files[1], 10));
+	CPPUNIT_ASSERT_EQUAL(5, check_file(files[2], 30));
+
+	JournalReader first, second;
+	CPPUNIT_ASSERT(first.open(files[0]));
+	CPPUNIT_ASSERT(second.open(files[1]));
+	CPPUNIT_ASSERT(first.get_run_ms() <= second.get_run_ms());
+	CPPUNIT_ASSERT(first.get_monotonic_ms() <= second.get_monotonic_ms());
+
+	// a run that heard nothing leaves no file
+	{
+		JournalWriter writer(dir);
+	}
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, journals(dir).size());
+
+	boost::filesystem::remove_all(dir);
+}
+
+/*
+ * A crash part way through writing a record: the reader stops at the
+ * last whole one, and the next run's file is not affected.
+ */
+void qa_journal::t_cut_record()
+{
+	std::string dir = temp_dir();
+	write_run(dir, 0, 8);
+	std::vector<std::string> files = journals(dir);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, files.size());
+
+	// message 7 has a record and a parsed message
+	off_t whole = sizeof(JournalHeader) + 8 * sizeof(JournalRecord) + 7 * sizeof(JournalMessage);
+	CPPUNIT_ASSERT_EQUAL((uintmax_t) whole, boost::filesystem::file_size(files[0]));
+	CPPUNIT_ASSERT(truncate(files[0].c_str(), whole - 3) == 0);
+	CPPUNIT_ASSERT_EQUAL(7, check_file(files[0], 0));
+	CPPUNIT_ASSERT(truncate(files[0].c_str(), whole - sizeof(JournalMessage) - 5) == 0);
+	CPPUNIT_ASSERT_EQUAL(7, check_file(files[0], 0));
+
+	write_run(dir, 8, 8);
+	files = journals(dir);
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, files.size());
+	CPPUNIT_ASSERT_EQUAL(7, check_file(files[0], 0));
+	CPPUNIT_ASSERT_EQUAL(8, check_file(files[1], 8));
+
+	boost::filesystem::remove_all(dir);
+}
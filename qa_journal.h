@@ -0,0 +1,25 @@
+#ifndef QA_JOURNAL_H
+#define QA_JOURNAL_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * JournalWriter and JournalReader: records read back as written, a
+ * file of its own for every run, and a record cut short by a crash.
+ */
+class qa_journal : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_journal);
+	CPPUNIT_TEST(t_round_trip);
+	CPPUNIT_TEST(t_file_per_run);
+	CPPUNIT_TEST(t_cut_record);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_round_trip();
+	void t_file_per_run();
+	void t_cut_record();
+};
+
+#endif
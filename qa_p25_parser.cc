@@ -0,0 +1,157 @@
+#include "qa_p25_parser.h"
+#include "p25_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const unsigned long NAC = 0x293;
+static const unsigned long OTHER_NAC = 0x1a4;
+
+// identifier 1: 851.0125 MHz base, 12.5 kHz steps, so channel 6 is 851.0875 MHz
+static const int IDEN = 1;
+static const int CHANNEL = (IDEN << 12) | 6;
+static const double FREQUENCY = 851087500;
+
+static std::string temp_dir()
+{
+	char dir[] = "/tmp/qa_p25_parser.XXXXXX";
+	CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+	return dir;
+}
+
+/*
+ * A TSBK as the decoder queues it: opcode, manufacturer ID and the 64
+ * bits of arguments, without the CRC. Bit n of args is bit n + 16 of
+ * the bitset decode_tsbk() reads its fields from.
+ */
+static trunk_msg tsbk(unsigned long nac, int opcode, int mfrid, unsigned long long args)
+{
+	trunk_msg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.type = 7;
+	msg.nac = nac;
+	msg.len = 10;
+	msg.data[0] = opcode & 0x3f;
+	msg.data[1] = mfrid;
+	for (int i = 0; i < 8; i++) {
+		msg.data[9 - i] = (args >> (i * 8)) & 0xff;
+	}
+	return msg;
+}
+
+static trunk_msg iden_up(unsigned long nac)
+{
+	unsigned long long bw = 100;         // 12.5 kHz in 125 Hz units
+	unsigned long long spac = 100;       // 12.5 kHz in 125 Hz units
+	unsigned long long base = 170202500; // 851.0125 MHz in 5 Hz units
+	unsigned long long args = ((unsigned long long) IDEN << 60) | (bw << 51) | (spac << 32) | base;
+	return tsbk(nac, 0x3d, 0, args);
+}
+
+static trunk_msg grant(unsigned long nac, int channel, long talkgroup)
+{
+	unsigned long long args = ((unsigned long long) channel << 40) | ((unsigned long long) talkgroup << 24) | 1234;
+	return tsbk(nac, 0x00, 0, args);
+}
+
+// the frequency a grant on channel resolves to, after checking it is a grant
+static double granted(P25Parser &parser, unsigned long nac, int channel)
+{
+	std::vector<TrunkMessage> messages = parser.parse_message(grant(nac, channel, 101));
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, messages.size());
+	CPPUNIT_ASSERT_EQUAL(GRANT, messages[0].message_type);
+	CPPUNIT_ASSERT_EQUAL(101L, messages[0].talkgroup);
+	CPPUNIT_ASSERT_EQUAL(1234L, messages[0].source);
+	return messages[0].freq;
+}
+
+void qa_p25_parser::t_iden_up()
+{
+	P25Parser parser;
+	CPPUNIT_ASSERT_EQUAL(0.0, granted(parser, NAC, CHANNEL));
+
+	parser.parse_message(iden_up(NAC));
+	CPPUNIT_ASSERT_EQUAL(FREQUENCY, granted(parser, NAC, CHANNEL));
+	CPPUNIT_ASSERT_EQUAL(FREQUENCY + 12500, granted(parser, NAC, CHANNEL + 1));
+	CPPUNIT_ASSERT_EQUAL(12.5, parser.get_bandwidth(CHANNEL));
+
+	// another identifier has not been broadcast
+	CPPUNIT_ASSERT_EQUAL(0.0, granted(parser, NAC, (2 << 12) | 6));
+}
+
+void qa_p25_parser::t_reload()
+{
+	std::string dir = temp_dir();
+	std::string file = dir + "/p25_state.json";
+	{
+		P25Parser parser;
+		parser.load_state(file);
+		parser.parse_message(iden_up(NAC));
+		CPPUNIT_ASSERT_EQUAL(FREQUENCY, granted(parser, NAC, CHANNEL));
+	}
+	CPPUNIT_ASSERT(access(file.c_str(), R_OK) == 0);
+	CPPUNIT_ASSERT(access((file + ".tmp").c_str(), F_OK) != 0);
+
+	// the first grant after a restart, before any IDEN_UP
+	P25Parser parser;
+	parser.load_state(file);
+	CPPUNIT_ASSERT_EQUAL(FREQUENCY, granted(parser, NAC, CHANNEL));
+
+	// and it is still there once the site rebroadcasts the same identifier
+	parser.parse_message(iden_up(NAC));
+	CPPUNIT_ASSERT_EQUAL(FREQUENCY, granted(parser, NAC, CHANNEL));
+
+	unlink(file.c_str());
+	rmdir(dir.c_str());
+}
+
+void qa_p25_parser::t_other_nac()
+{
+	std::string dir = temp_dir();
+	std::string file = dir + "/p25_state.json";
+	{
+		P25Parser parser;
+		parser.load_state(file);
+		parser.parse_message(iden_up(NAC));
+	}
+
+	// the saved table is for another system
+	{
+		P25Parser parser;
+		parser.load_state(file);
+		CPPUNIT_ASSERT_EQUAL(0.0, granted(parser, OTHER_NAC, CHANNEL));
+
+		// identifiers broadcast by the new system are kept
+		parser.parse_message(iden_up(OTHER_NAC));
+		CPPUNIT_ASSERT_EQUAL(FREQUENCY, granted(parser, OTHER_NAC, CHANNEL));
+	}
+
+	// which is what the file now holds
+	P25Parser parser;
+	parser.load_state(file);
+	CPPUNIT_ASSERT_EQUAL(FREQUENCY, granted(parser, OTHER_NAC, CHANNEL));
+
+	unlink(file.c_str());
+	rmdir(dir.c_str());
+}
+
+void qa_p25_parser::t_bad_file()
+{
+	std::string dir = temp_dir();
+	std::string file = dir + "/p25_state.json";
+	FILE *fp = fopen(file.c_str(), "w");
+	CPPUNIT_ASSERT(fp != NULL);
+	fputs("{\"nac\": \"659\", \"channels\": [{\"id\": ", fp);
+	fclose(fp);
+
+	P25Parser parser;
+	parser.load_state(file);
+	CPPUNIT_ASSERT_EQUAL(0.0, granted(parser, NAC, CHANNEL));
+	parser.parse_message(iden_up(NAC));
+	CPPUNIT_ASSERT_EQUAL(FREQUENCY, granted(parser, NAC, CHANNEL));
+
+	unlink(file.c_str());
+	rmdir(dir.c_str());
+}
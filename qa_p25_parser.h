@@ -0,0 +1,28 @@
+#ifndef QA_P25_PARSER_H
+#define QA_P25_PARSER_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * P25Parser's channel identifier table: grants before and after an
+ * IDEN_UP, and the state file that carries the table over a restart
+ * until the control channel says it belongs to another system.
+ */
+class qa_p25_parser : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_p25_parser);
+	CPPUNIT_TEST(t_iden_up);
+	CPPUNIT_TEST(t_reload);
+	CPPUNIT_TEST(t_other_nac);
+	CPPUNIT_TEST(t_bad_file);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_iden_up();
+	void t_reload();
+	void t_other_nac();
+	void t_bad_file();
+};
+
+#endif
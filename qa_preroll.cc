@@ -0,0 +1,118 @@
+#include "qa_preroll.h"
+#include "preroll_ring.h"
+#include "preroll_valve.h"
+#include "timestamp.h"
+
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/vector_source_c.h>
+#include <gnuradio/blocks/vector_sink_c.h>
+#include <op25_repeater/epoch_tag.h>
+#include <math.h>
+#include <unistd.h>
+
+static const double RATE = 100000;
+
+/*
+ * Sample i of the test stream carries i, 15 bits in each of I and Q,
+ * in steps the ring's 16 bit samples keep exactly.
+ */
+static std::vector<gr_complex> ramp(int n)
+{
+	std::vector<gr_complex> v(n);
+	for (int i = 0; i < n; i++)
+		v[i] = gr_complex((i & 0x7fff) / 32767.0f, ((i >> 15) & 0x7fff) / 32767.0f);
+	return v;
+}
+
+static long index_of(const gr_complex &s)
+{
+	return lrintf(s.real() * 32767.0f) | (lrintf(s.imag() * 32767.0f) << 15);
+}
+
+// the first index of out, after checking the rest follow on from it
+static long check_contiguous(const std::vector<gr_complex> &out)
+{
+	CPPUNIT_ASSERT(!out.empty());
+	long first = index_of(out[0]);
+	for (size_t i = 1; i < out.size(); i++) {
+		if (index_of(out[i]) != first + (long) i) {
+			CPPUNIT_ASSERT_EQUAL(first + (long) i, index_of(out[i]));
+		}
+	}
+	return first;
+}
+
+struct preroll_graph {
+	gr::top_block_sptr tb;
+	preroll_ring_sptr ring;
+	preroll_valve_sptr valve;
+	gr::blocks::vector_sink_c::sptr sink;
+
+	preroll_graph(int n, int64_t depth_ms = 1000) {
+		tb = gr::make_top_block("qa_preroll");
+		gr::blocks::vector_source_c::sptr src = gr::blocks::vector_source_c::make(ramp(n));
+		ring = make_preroll_ring(RATE, depth_ms);
+		valve = make_preroll_valve(ring, 4);
+		sink = gr::blocks::vector_sink_c::make();
+		tb->connect(src, 0, ring, 0);
+		tb->connect(src, 0, valve, 0);
+		tb->connect(valve, 0, sink, 0);
+	}
+};
+
+void qa_preroll::t_start_at_beginning()
+{
+	static const int N = 1000000;
+	preroll_graph g(N);
+
+	// a time before anything was received starts at the oldest sample
+	g.valve->start_from(0, 7);
+	g.tb->run();
+
+	std::vector<gr_complex> out = g.sink->data();
+	CPPUNIT_ASSERT_EQUAL((size_t) N, out.size());
+	CPPUNIT_ASSERT_EQUAL(0l, check_contiguous(out));
+
+	std::vector<gr::tag_t> tags = g.sink->tags();
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, tags.size());
+	CPPUNIT_ASSERT_EQUAL((uint64_t) 0, tags[0].offset);
+	CPPUNIT_ASSERT(pmt::eq(gr::op25_repeater::epoch_tag_key(), tags[0].key));
+	CPPUNIT_ASSERT_EQUAL(7l, pmt::to_long(tags[0].value));
+}
+
+void qa_preroll::t_start_while_running()
+{
+	static const int N = 4000000;
+	// nothing paces the source, so when the sink gets little CPU the
+	// replay falls behind the live input by more than a second and
+	// the ring overruns it; a ring that holds the whole stream can't
+	preroll_graph g(N, N / RATE * 1000);
+
+	g.tb->start();
+	while (g.ring->written() < N / 4)
+		usleep(100);
+	uint64_t live = g.ring->written();
+	g.valve->start_from(monotonic_ms() - 200, 1);
+	g.tb->wait();
+
+	// replayed from the ring, then spliced onto the live input without
+	// a gap or a repeat, to the end of the stream. For the same reason
+	// the input can end before the replay has caught up, or even
+	// started; what was replayed still has to follow on.
+	std::vector<gr_complex> out = g.sink->data();
+	if (out.empty() && g.valve->catching_up())
+		return;
+	long first = check_contiguous(out);
+	CPPUNIT_ASSERT(first <= (long) live);
+	if (!g.valve->catching_up())
+		CPPUNIT_ASSERT_EQUAL((long) N, first + (long) out.size());
+}
+
+void qa_preroll::t_disabled()
+{
+	preroll_graph g(100000);
+
+	g.tb->run();
+	CPPUNIT_ASSERT(g.sink->data().empty());
+	CPPUNIT_ASSERT_EQUAL((uint64_t) 100000, g.ring->written());
+}
@@ -0,0 +1,26 @@
+#ifndef QA_PREROLL_H
+#define QA_PREROLL_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * preroll_ring and preroll_valve fed from the same source in a flow
+ * graph, however the scheduler interleaves them: the valve's output
+ * has to be one contiguous run of the source stream.
+ */
+class qa_preroll : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_preroll);
+	CPPUNIT_TEST(t_start_at_beginning);
+	CPPUNIT_TEST(t_start_while_running);
+	CPPUNIT_TEST(t_disabled);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_start_at_beginning();
+	void t_start_while_running();
+	void t_disabled();
+};
+
+#endif
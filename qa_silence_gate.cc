@@ -0,0 +1,185 @@
+#include "qa_silence_gate.h"
+#include "silence_gate.h"
+
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/vector_source_f.h>
+#include <gnuradio/blocks/vector_sink_f.h>
+#include <op25_repeater/epoch_tag.h>
+#include <math.h>
+#include <stdlib.h>
+
+static const double RATE = 8000;
+// silenceKeep of 250 ms
+static const uint64_t KEEP = 2000;
+
+// a 1 kHz tone at half scale, starting on a peak
+static void tone(std::vector<float> &v, int n)
+{
+	for (int i = 0; i < n; i++)
+		v.push_back(0.5f * cos(2 * M_PI * 1000 * i / RATE));
+}
+
+// uniform noise of +/- level
+static void noise(std::vector<float> &v, int n, float level)
+{
+	for (int i = 0; i < n; i++)
+		v.push_back(level * (2.0f * rand() / RAND_MAX - 1));
+}
+
+static std::vector<gr::tag_t> epoch_tags(uint64_t offset, long epoch, const std::vector<gr::tag_t> &tags = std::vector<gr::tag_t>())
+{
+	std::vector<gr::tag_t> all = tags;
+	gr::tag_t tag;
+	tag.offset = offset;
+	tag.key = gr::op25_repeater::epoch_tag_key();
+	tag.value = pmt::from_long(epoch);
+	all.push_back(tag);
+	return all;
+}
+
+struct gate_graph {
+	gr::top_block_sptr tb;
+	silence_gate_sptr gate;
+	gr::blocks::vector_sink_f::sptr sink;
+
+	gate_graph(const std::vector<float> &audio, const std::vector<gr::tag_t> &tags, const std::vector<float> *noise = NULL) {
+		silence_gate::configure(true, -40, 250, -10);
+		tb = gr::make_top_block("qa_silence_gate");
+		gate = make_silence_gate(RATE, false, noise != NULL);
+		sink = gr::blocks::vector_sink_f::make();
+		tb->connect(gr::blocks::vector_source_f::make(audio, false, 1, tags), 0, gate, 0);
+		if (noise)
+			tb->connect(gr::blocks::vector_source_f::make(*noise), 0, gate, 1);
+		tb->connect(gate, 0, sink, 0);
+		silence_gate::configure(false, -40, 250, -10);
+	}
+};
+
+// out is in with the gaps taken out, at the places they are recorded
+static void check_gaps(const std::vector<float> &in, const std::vector<float> &out, const std::vector<silence_gap> &gaps, size_t start = 0)
+{
+	size_t skipped = 0;
+	size_t j = 0;
+	for (size_t g = 0; g <= gaps.size(); g++) {
+		size_t end = (g < gaps.size()) ? gaps[g].offset : out.size();
+		for (; j < end; j++) {
+			if (out[j] != in[start + j + skipped])
+				CPPUNIT_ASSERT_EQUAL(in[start + j + skipped], out[j]);
+		}
+		if (g < gaps.size())
+			skipped += gaps[g].removed;
+	}
+	CPPUNIT_ASSERT_EQUAL(in.size() - start, out.size() + skipped);
+}
+
+void qa_silence_gate::t_quiet_run()
+{
+	std::vector<float> in;
+	tone(in, 8000);
+	noise(in, 16000, 0.001f);
+	tone(in, 4000);
+	gate_graph g(in, epoch_tags(0, 1));
+	g.tb->run();
+
+	std::vector<float> out = g.sink->data();
+	std::vector<silence_gap> gaps;
+	CPPUNIT_ASSERT(g.gate->get_gaps(1, gaps));
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, gaps.size());
+	check_gaps(in, out, gaps);
+	// keep_ms of the quiet run is left, after the envelope has fallen
+	// from the tone to the threshold, 10 ms ln(0.5 / 0.01)
+	CPPUNIT_ASSERT(gaps[0].offset >= 8000 + KEEP);
+	CPPUNIT_ASSERT(gaps[0].offset <= 8000 + KEEP + 40 * RATE / 1000);
+	// it ends where the tone comes back
+	CPPUNIT_ASSERT_EQUAL((uint64_t) 24000, gaps[0].offset + gaps[0].removed);
+}
+
+void qa_silence_gate::t_short_pause()
+{
+	std::vector<float> in;
+	tone(in, 8000);
+	noise(in, 1600, 0.001f);
+	tone(in, 8000);
+	noise(in, 1600, 0.001f);
+	gate_graph g(in, epoch_tags(0, 1));
+	g.tb->run();
+
+	std::vector<silence_gap> gaps;
+	CPPUNIT_ASSERT(g.gate->get_gaps(1, gaps));
+	CPPUNIT_ASSERT(gaps.empty());
+	check_gaps(in, g.sink->data(), gaps);
+}
+
+void qa_silence_gate::t_epochs()
+{
+	std::vector<float> in;
+	tone(in, 4000);
+	noise(in, 8000, 0.001f);
+	// the next call starts while the first one's quiet run is being
+	// dropped
+	static const uint64_t TAG = 10000;
+	tone(in, 4000);
+	noise(in, 6000, 0.001f);
+	tone(in, 1000);
+	gate_graph g(in, epoch_tags(TAG, 2, epoch_tags(0, 1)));
+	g.tb->run();
+
+	std::vector<float> out = g.sink->data();
+	std::vector<silence_gap> gaps;
+	CPPUNIT_ASSERT(!g.gate->get_gaps(1, gaps));
+	CPPUNIT_ASSERT(g.gate->get_gaps(2, gaps));
+
+	// the second tag is at the shortened end of the first call
+	std::vector<gr::tag_t> tags = g.sink->tags();
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, tags.size());
+	CPPUNIT_ASSERT_EQUAL(2l, pmt::to_long(tags[1].value));
+	uint64_t first = tags[1].offset;
+	CPPUNIT_ASSERT(first >= 4000 + KEEP);
+	CPPUNIT_ASSERT(first < TAG - 1000);
+	for (uint64_t i = 0; i < 4000; i++)
+		CPPUNIT_ASSERT_EQUAL(in[i], out[i]);
+
+	// the second call's gaps are counted from its own start, the
+	// quiet run carried over from the first call started over at the tag
+	std::vector<float> second(out.begin() + first, out.end());
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, gaps.size());
+	check_gaps(in, second, gaps, TAG);
+	CPPUNIT_ASSERT_EQUAL((uint64_t) 22000 - TAG, gaps[0].offset + gaps[0].removed);
+}
+
+/*
+ * The discriminator puts out loud noise in the audio band as well when
+ * the carrier goes, which the level of the audio cannot tell from
+ * speech: the noise above the voice band turns the gate on.
+ */
+void qa_silence_gate::t_noise()
+{
+	std::vector<float> in, oob;
+	noise(in, 24000, 0.8f);
+	// keyed, nobody, keyed
+	noise(oob, 8000, 0.01f);
+	noise(oob, 8000, 0.8f);
+	noise(oob, 8000, 0.01f);
+	gate_graph g(in, epoch_tags(0, 1), &oob);
+	g.tb->run();
+
+	std::vector<float> out = g.sink->data();
+	std::vector<silence_gap> gaps;
+	CPPUNIT_ASSERT(g.gate->get_gaps(1, gaps));
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, gaps.size());
+	CPPUNIT_ASSERT_EQUAL(in.size(), out.size() + gaps[0].removed);
+
+	// the noise power averages up to -10 dB within a few ms of the
+	// carrier going, and down below -13 dB soon after it returns
+	uint64_t start = gaps[0].offset - KEEP;
+	uint64_t end = gaps[0].offset + gaps[0].removed;
+	CPPUNIT_ASSERT(start >= 8000 && start <= 8000 + 20 * RATE / 1000);
+	CPPUNIT_ASSERT(end >= 16000 && end <= 16000 + 40 * RATE / 1000);
+	for (uint64_t i = 0; i < start; i++)
+		CPPUNIT_ASSERT_EQUAL(in[i], out[i]);
+	// what is kept of it is silence
+	for (uint64_t i = start; i < gaps[0].offset; i++)
+		CPPUNIT_ASSERT_EQUAL(0.0f, out[i]);
+	for (uint64_t i = gaps[0].offset; i < out.size(); i++)
+		CPPUNIT_ASSERT_EQUAL(in[i + gaps[0].removed], out[i]);
+}
@@ -0,0 +1,28 @@
+#ifndef QA_SILENCE_GATE_H
+#define QA_SILENCE_GATE_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * silence_gate in a flow graph: what is dropped of a quiet run and
+ * where the gap is recorded, pauses that are left alone, gaps starting
+ * over at an epoch tag, and the noise squelch of the analog recorder.
+ */
+class qa_silence_gate : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_silence_gate);
+	CPPUNIT_TEST(t_quiet_run);
+	CPPUNIT_TEST(t_short_pause);
+	CPPUNIT_TEST(t_epochs);
+	CPPUNIT_TEST(t_noise);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_quiet_run();
+	void t_short_pause();
+	void t_epochs();
+	void t_noise();
+};
+
+#endif
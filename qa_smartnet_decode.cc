@@ -0,0 +1,110 @@
+#include "qa_smartnet_decode.h"
+#include "smartnet_decode.h"
+#include "smartnet_encode.h"
+
+#include <gnuradio/top_block.h>
+#include <gnuradio/blocks/vector_source_b.h>
+#include <stdint.h>
+
+static uint32_t lcg(uint32_t &seed)
+{
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+void qa_smartnet_decode::t_decode_osw()
+{
+	static const unsigned int addresses[] = { 0x0000, 0xffff, 0x33C7, 0x1234, 0xa5a5 };
+	static const unsigned int commands[] = { 0x000, 0x3ff, 0x32A, 0x308, 0x2f8 };
+	char frame[smartnet_decode::FRAME_BITS];
+
+	for (int a = 0; a < 5; a++) {
+		for (int c = 0; c < 5; c++) {
+			for (int g = 0; g < 2; g++) {
+				smartnet_packet pkt;
+				unsigned int errors = 99;
+				smartnet_encode_osw(addresses[a], g, commands[c], frame);
+				CPPUNIT_ASSERT(smartnet_decode::decode_osw(frame, pkt, errors));
+				CPPUNIT_ASSERT_EQUAL(addresses[a], pkt.address);
+				CPPUNIT_ASSERT_EQUAL(g == 1, pkt.groupflag);
+				CPPUNIT_ASSERT_EQUAL(commands[c], pkt.command);
+				CPPUNIT_ASSERT_EQUAL(0u, errors);
+			}
+		}
+	}
+}
+
+void qa_smartnet_decode::t_bit_errors()
+{
+	char frame[smartnet_decode::FRAME_BITS];
+	uint32_t seed = 1;
+
+	for (int n = 0; n < 2000; n++) {
+		unsigned int address = lcg(seed) & 0xffff;
+		unsigned int command = lcg(seed) & 0x3ff;
+		bool groupflag = lcg(seed) & 1;
+		smartnet_packet pkt;
+		unsigned int errors;
+
+		// any single error in the coded bits is corrected
+		int bit = lcg(seed) % 76;
+		smartnet_encode_osw(address, groupflag, command, frame);
+		frame[bit] ^= 1;
+		CPPUNIT_ASSERT(smartnet_decode::decode_osw(frame, pkt, errors));
+		CPPUNIT_ASSERT_EQUAL(address, pkt.address);
+		CPPUNIT_ASSERT_EQUAL(groupflag, pkt.groupflag);
+		CPPUNIT_ASSERT_EQUAL(command, pkt.command);
+		CPPUNIT_ASSERT(errors <= 1);
+
+		// the data and parity copies of a bit both wrong is caught by the CRC
+		int k = lcg(seed) % 27;
+		smartnet_encode_osw(address, groupflag, command, frame);
+		frame[(2 * k) / 4 + ((2 * k) % 4) * 19] ^= 1;
+		frame[(2 * k + 1) / 4 + ((2 * k + 1) % 4) * 19] ^= 1;
+		CPPUNIT_ASSERT(!smartnet_decode::decode_osw(frame, pkt, errors));
+	}
+}
+
+void qa_smartnet_decode::t_flowgraph()
+{
+	static const int OSWS = 5000;
+	std::vector<char> bits;
+	std::vector<smartnet_packet> sent;
+	uint32_t seed = 7;
+
+	for (int n = 0; n < OSWS; n++) {
+		smartnet_packet pkt;
+		pkt.address = lcg(seed) & 0xffff;
+		pkt.groupflag = lcg(seed) & 1;
+		pkt.command = lcg(seed) & 0x3ff;
+		smartnet_append_osw(bits, pkt.address, pkt.groupflag, pkt.command);
+		sent.push_back(pkt);
+		// idle bits between some of them, so OSWs straddle work calls
+		int idle = lcg(seed) % 40;
+		for (int i = 0; i < idle; i++) bits.push_back(0);
+	}
+	// the decoder holds back FRAME_BITS bits of history
+	bits.insert(bits.end(), smartnet_decode::FRAME_BITS, 0);
+
+	gr::op25_repeater::trunk_msg_queue::sptr queue = gr::op25_repeater::trunk_msg_queue::make(OSWS);
+	std::vector<unsigned char> input(bits.begin(), bits.end());
+	gr::top_block_sptr tb = gr::make_top_block("qa_smartnet_decode");
+	gr::blocks::vector_source_b::sptr src = gr::blocks::vector_source_b::make(input);
+	smartnet_decode_sptr decode = smartnet_make_decode(queue);
+	tb->connect(src, 0, decode, 0);
+	tb->run();
+
+	CPPUNIT_ASSERT_EQUAL((unsigned int) OSWS, queue->count());
+	// sync patterns inside the OSWs are found too and fail the CRC
+	CPPUNIT_ASSERT_EQUAL((unsigned long) OSWS, decode->frames() - decode->crc_errors());
+	for (int n = 0; n < OSWS; n++) {
+		gr::op25_repeater::trunk_msg msg;
+		smartnet_packet pkt;
+		CPPUNIT_ASSERT(queue->delete_head_nowait(msg));
+		CPPUNIT_ASSERT_EQUAL((uint32_t) sizeof(pkt), msg.len);
+		memcpy(&pkt, msg.data, sizeof(pkt));
+		CPPUNIT_ASSERT_EQUAL(sent[n].address, pkt.address);
+		CPPUNIT_ASSERT_EQUAL(sent[n].groupflag, pkt.groupflag);
+		CPPUNIT_ASSERT_EQUAL(sent[n].command, pkt.command);
+	}
+}
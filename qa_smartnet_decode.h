@@ -0,0 +1,25 @@
+#ifndef QA_SMARTNET_DECODE_H
+#define QA_SMARTNET_DECODE_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * OSWs encoded here from the mottrunk.txt description, run through
+ * smartnet_decode::decode_osw and through the block in a flow graph.
+ */
+class qa_smartnet_decode : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_smartnet_decode);
+	CPPUNIT_TEST(t_decode_osw);
+	CPPUNIT_TEST(t_bit_errors);
+	CPPUNIT_TEST(t_flowgraph);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_decode_osw();
+	void t_bit_errors();
+	void t_flowgraph();
+};
+
+#endif
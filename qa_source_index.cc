@@ -0,0 +1,160 @@
+#include "qa_source_index.h"
+#include "source_index.h"
+#include "call.h"
+
+static std::vector<Source *> sources(Source *a = NULL, Source *b = NULL)
+{
+	std::vector<Source *> v;
+	if (a)
+		v.push_back(a);
+	if (b)
+		v.push_back(b);
+	return v;
+}
+
+// a Source covering center +/- 1 MHz
+static Source *make_source(double center, int digital, int analog)
+{
+	Source *source = new Source(center, 2e6, 0, "replay", "");
+	source->create_replay_recorders(digital, analog);
+	return source;
+}
+
+// puts n more of the source's recorders of one kind to work
+static void busy(Source *source, bool analog, int n)
+{
+	// no directories for the calls' files
+	bool dry_run = Call::dry_run;
+	Call::dry_run = true;
+	for (int i = 0; i < n; i++) {
+		Recorder *recorder = analog ? source->get_analog_recorder(1) : source->get_digital_recorder(1);
+		CPPUNIT_ASSERT(recorder != NULL);
+		Call call(100 + i, source->get_center());
+		recorder->activate(&call, 0);
+	}
+	Call::dry_run = dry_run;
+}
+
+void qa_source_index::t_edges()
+{
+	// a and b overlap on 851-852 MHz, c is on its own
+	Source *a = make_source(851e6, 2, 0);
+	Source *b = make_source(852e6, 2, 0);
+	Source *c = make_source(860e6, 2, 0);
+	SourceIndex index;
+	index.add_source(a);
+	index.add_source(b);
+	index.add_source(c);
+
+	CPPUNIT_ASSERT(index.find_sources(849.9e6) == sources());
+	CPPUNIT_ASSERT(index.find_sources(850e6) == sources(a));
+	CPPUNIT_ASSERT(index.find_sources(850.5e6) == sources(a));
+	CPPUNIT_ASSERT(index.find_sources(851e6) == sources(a, b));
+	CPPUNIT_ASSERT(index.find_sources(851.5e6) == sources(a, b));
+	CPPUNIT_ASSERT(index.find_sources(852e6) == sources(a, b));
+	CPPUNIT_ASSERT(index.find_sources(852.5e6) == sources(b));
+	CPPUNIT_ASSERT(index.find_sources(853e6) == sources(b));
+	CPPUNIT_ASSERT(index.find_sources(853.1e6) == sources());
+	CPPUNIT_ASSERT(index.find_sources(858.9e6) == sources());
+	CPPUNIT_ASSERT(index.find_sources(859e6) == sources(c));
+	CPPUNIT_ASSERT(index.find_sources(861e6) == sources(c));
+	CPPUNIT_ASSERT(index.find_sources(861.1e6) == sources());
+
+	CPPUNIT_ASSERT(index.find_source(851.5e6) == a);
+	CPPUNIT_ASSERT(index.find_source(855e6) == NULL);
+}
+
+void qa_source_index::t_by_load()
+{
+	Source *a = make_source(851e6, 4, 2);
+	Source *b = make_source(852e6, 4, 2);
+	SourceIndex index;
+	index.add_source(a);
+	index.add_source(b);
+
+	// equally loaded, config order
+	CPPUNIT_ASSERT(index.find_sources_by_load(851.5e6, false) == sources(a, b));
+
+	busy(a, false, 2);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, a->get_load(false), 1e-9);
+	CPPUNIT_ASSERT(index.find_sources_by_load(851.5e6, false) == sources(b, a));
+
+	busy(b, false, 3);
+	CPPUNIT_ASSERT(index.find_sources_by_load(851.5e6, false) == sources(a, b));
+
+	// analog recorders are counted on their own
+	CPPUNIT_ASSERT(index.find_sources_by_load(851.5e6, true) == sources(a, b));
+	busy(a, true, 1);
+	CPPUNIT_ASSERT(index.find_sources_by_load(851.5e6, true) == sources(b, a));
+
+	// only the covering sources are ordered
+	CPPUNIT_ASSERT(index.find_sources_by_load(850.5e6, false) == sources(a));
+}
+
+void qa_source_index::t_ties()
+{
+	Source *a = make_source(851e6, 2, 0);
+	Source *b = make_source(852e6, 4, 0);
+	SourceIndex index;
+	index.add_source(a);
+	index.add_source(b);
+
+	// both half busy, the one with more idle recorders goes first
+	busy(a, false, 1);
+	busy(b, false, 2);
+	CPPUNIT_ASSERT(index.find_sources_by_load(851.5e6, false) == sources(b, a));
+}
+
+void qa_source_index::t_no_recorders()
+{
+	// a source without recorders of a kind is fully loaded for it
+	Source *a = make_source(851e6, 2, 0);
+	Source *b = make_source(852e6, 2, 2);
+	SourceIndex index;
+	index.add_source(a);
+	index.add_source(b);
+
+	busy(b, true, 1);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, a->get_load(true), 1e-9);
+	CPPUNIT_ASSERT(index.find_sources_by_load(851.5e6, true) == sources(b, a));
+}
+
+/*
+ * A preempted call is parked, as preempt_recorder() does, and its
+ * recorder goes to the higher priority call. When the preempted call
+ * times out and is ended again it must leave that recorder alone.
+ */
+void qa_source_index::t_preempt()
+{
+	Source *a = make_source(851e6, 1, 0);
+	bool dry_run = Call::dry_run;
+	Call::dry_run = true;
+
+	Call victim(100, 851e6);
+	Recorder *recorder = a->get_digital_recorder(1);
+	CPPUNIT_ASSERT(recorder != NULL);
+	recorder->activate(&victim, 0);
+	victim.set_recorder(recorder);
+	victim.set_recording(true);
+	CPPUNIT_ASSERT_EQUAL(0, a->get_num_available_recorders());
+
+	victim.park();
+	CPPUNIT_ASSERT(victim.get_parked());
+	CPPUNIT_ASSERT(!victim.get_recording());
+	CPPUNIT_ASSERT(!recorder->is_active());
+	CPPUNIT_ASSERT_EQUAL(1, a->get_num_available_recorders());
+
+	Call preemptor(200, 851e6);
+	CPPUNIT_ASSERT(a->get_digital_recorder(0) == recorder);
+	recorder->activate(&preemptor, 0);
+	preemptor.set_recorder(recorder);
+	preemptor.set_recording(true);
+
+	// callTimeout
+	victim.end_call();
+	CPPUNIT_ASSERT(recorder->is_active());
+	CPPUNIT_ASSERT_EQUAL(200l, recorder->get_talkgroup());
+	CPPUNIT_ASSERT_EQUAL(0, a->get_num_available_recorders());
+
+	Call::dry_run = dry_run;
+}
@@ -0,0 +1,31 @@
+#ifndef QA_SOURCE_INDEX_H
+#define QA_SOURCE_INDEX_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * SourceIndex over replay Sources, which have recorders but no SDR:
+ * which sources cover a frequency at and between their edges, and the
+ * order they are tried in as their recorders get busy, and a recorder
+ * taken from a preempted call.
+ */
+class qa_source_index : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_source_index);
+	CPPUNIT_TEST(t_edges);
+	CPPUNIT_TEST(t_by_load);
+	CPPUNIT_TEST(t_ties);
+	CPPUNIT_TEST(t_no_recorders);
+	CPPUNIT_TEST(t_preempt);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_edges();
+	void t_by_load();
+	void t_ties();
+	void t_no_recorders();
+	void t_preempt();
+};
+
+#endif
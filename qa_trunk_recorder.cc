@@ -0,0 +1,41 @@
+/*
+ * Gathers the test cases for the recorder into a single suite. As you
+ * create new test cases, add them here.
+ */
+
+#include "qa_trunk_recorder.h"
+#include "qa_smartnet_decode.h"
+#include "qa_preroll.h"
+#include "qa_wavfile_sink.h"
+#include "qa_source_index.h"
+#include "qa_dqpsk_slicer.h"
+#include "qa_filter_cache.h"
+#include "qa_p25_parser.h"
+#include "qa_journal.h"
+#include "qa_call_history.h"
+#include "qa_call_archive.h"
+#include "qa_silence_gate.h"
+#ifdef HAVE_SQLITE3
+#include "qa_call_index.h"
+#endif
+
+CppUnit::TestSuite *qa_trunk_recorder::suite()
+{
+	CppUnit::TestSuite *s = new CppUnit::TestSuite("trunk_recorder");
+	s->addTest(qa_smartnet_decode::suite());
+	s->addTest(qa_preroll::suite());
+	s->addTest(qa_wavfile_sink::suite());
+	s->addTest(qa_source_index::suite());
+	s->addTest(qa_dqpsk_slicer::suite());
+	s->addTest(qa_filter_cache::suite());
+	s->addTest(qa_p25_parser::suite());
+	s->addTest(qa_journal::suite());
+	s->addTest(qa_call_history::suite());
+	s->addTest(qa_call_archive::suite());
+	s->addTest(qa_silence_gate::suite());
+#ifdef HAVE_SQLITE3
+	s->addTest(qa_call_index::suite());
+#endif
+
+	return s;
+}
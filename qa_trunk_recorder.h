@@ -0,0 +1,13 @@
+#ifndef QA_TRUNK_RECORDER_H
+#define QA_TRUNK_RECORDER_H
+
+#include <cppunit/TestSuite.h>
+
+//! collect all the tests for the recorder's own blocks and classes
+class qa_trunk_recorder
+{
+public:
+	static CppUnit::TestSuite *suite();
+};
+
+#endif
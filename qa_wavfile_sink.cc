@@ -0,0 +1,258 @@
+#include "qa_wavfile_sink.h"
+#include "nonstop_wavfile_sink.h"
+
+#include <gnuradio/top_block.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/io_signature.h>
+#include <op25_repeater/epoch_tag.h>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static const unsigned RATE = 8000;
+
+static std::string temp_dir()
+{
+	char dir[] = "/tmp/qa_wavfile_sink.XXXXXX";
+	CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+	return dir;
+}
+
+// sample i of the test stream, kept exactly by 16 bit samples
+static float ramp(long i)
+{
+	return (i % 30000) / 32767.0f;
+}
+
+static int get_le(const unsigned char *p, int n)
+{
+	int v = 0;
+	for (int i = n - 1; i >= 0; i--)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+/*
+ * Reads a finished 16 bit mono file back, checking its header against
+ * its length, and returns the index of its first sample after checking
+ * the rest follow on from it; -1 for a file without any.
+ */
+static long check_file(const std::string &name, long &samples)
+{
+	FILE *fp = fopen(name.c_str(), "rb");
+	CPPUNIT_ASSERT(fp != NULL);
+	std::vector<unsigned char> buf;
+	unsigned char block[4096];
+	size_t n;
+	while ((n = fread(block, 1, sizeof(block), fp)) > 0)
+		buf.insert(buf.end(), block, block + n);
+	fclose(fp);
+
+	CPPUNIT_ASSERT(buf.size() >= 44);
+	CPPUNIT_ASSERT_EQUAL((int) buf.size() - 8, get_le(&buf[4], 4));
+	CPPUNIT_ASSERT_EQUAL((int) buf.size() - 44, get_le(&buf[40], 4));
+	samples = (buf.size() - 44) / 2;
+	if (!samples)
+		return -1;
+
+	long first = (short) get_le(&buf[44], 2);
+	for (long i = 1; i < samples; i++) {
+		long sample = (short) get_le(&buf[44 + 2 * i], 2);
+		if (sample != (first + i) % 30000) {
+			CPPUNIT_ASSERT_EQUAL((first + i) % 30000, sample);
+		}
+	}
+	return first;
+}
+
+static bool closed(const std::vector<std::string> &names, const std::string &name)
+{
+	return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+/*
+ * The ramp, a little at a time. Where a recorder would be given the
+ * next call, the source closes the sink's file and opens the next one
+ * with that call's epoch, while the samples before it are still on the
+ * way to the sink, and tags the sample the new call starts at.
+ */
+class call_source : public gr::sync_block
+{
+	gr::blocks::nonstop_wavfile_sink::sptr d_sink;
+	long d_n;
+	long d_at;
+	std::string d_next;
+	long d_pos;
+
+public:
+	call_source(gr::blocks::nonstop_wavfile_sink::sptr sink, long n, long at, const std::string &next)
+		: gr::sync_block("call_source",
+		                 gr::io_signature::make(0, 0, 0),
+		                 gr::io_signature::make(1, 1, sizeof(float))),
+		  d_sink(sink), d_n(n), d_at(at), d_next(next), d_pos(0) {}
+
+	int work(int noutput_items,
+	         gr_vector_const_void_star &input_items,
+	         gr_vector_void_star &output_items)
+	{
+		float *out = (float *) output_items[0];
+		if (d_pos >= d_n)
+			return WORK_DONE;
+		int n = std::min((long) std::min(noutput_items, 500), d_n - d_pos);
+		for (int i = 0; i < n; i++, d_pos++) {
+			if (d_pos == d_at) {
+				d_sink->close();
+				CPPUNIT_ASSERT(d_sink->open(d_next.c_str(), 9));
+				add_item_tag(0, d_pos, gr::op25_repeater::epoch_tag_key(), pmt::from_long(9));
+			}
+			out[i] = ramp(d_pos);
+		}
+		return n;
+	}
+};
+
+// feeds n samples of the ramp from start into the sink without a flow graph
+static void feed(gr::blocks::nonstop_wavfile_sink::sptr sink, long start, int n)
+{
+	std::vector<float> v(n);
+	for (int i = 0; i < n; i++)
+		v[i] = ramp(start + i);
+	gr_vector_const_void_star in(1, &v[0]);
+	gr_vector_void_star out;
+	sink->work(n, in, out);
+}
+
+void qa_wavfile_sink::t_epoch_switch()
+{
+	static const long N = 100000;
+	static const long AT = 37123;
+	std::string dir = temp_dir();
+	std::string first = dir + "/1.wav";
+	std::string second = dir + "/2.wav";
+
+	gr::top_block_sptr tb = gr::make_top_block("qa_wavfile_sink");
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(first.c_str(), 1, RATE, 16);
+	gr::block_sptr src(new call_source(sink, N, AT, second));
+	tb->connect(src, 0, sink, 0);
+	tb->run();
+
+	// the first call's file was finished at the tag, not at the close()
+	std::vector<std::string> names;
+	gr::blocks::nonstop_wavfile_sink::finish_drained(names);
+	CPPUNIT_ASSERT(closed(names, first));
+
+	long samples;
+	CPPUNIT_ASSERT_EQUAL(0l, check_file(first, samples));
+	CPPUNIT_ASSERT_EQUAL(AT, samples);
+
+	sink.reset();
+	tb.reset();
+	src.reset();
+	CPPUNIT_ASSERT_EQUAL(AT % 30000, check_file(second, samples));
+	CPPUNIT_ASSERT_EQUAL(N - AT, samples);
+}
+
+void qa_wavfile_sink::t_drain_idle()
+{
+	std::string name = temp_dir() + "/1.wav";
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(name.c_str(), 1, RATE, 16);
+	std::vector<std::string> names;
+
+	feed(sink, 0, 1000);
+	sink->close();
+	// the end of the call, still coming through after the close()
+	feed(sink, 1000, 500);
+	gr::blocks::nonstop_wavfile_sink::finish_drained(names);
+	CPPUNIT_ASSERT(!closed(names, name));
+
+	usleep((gr::blocks::nonstop_wavfile_sink::DRAIN_IDLE_MS + 50) * 1000);
+	gr::blocks::nonstop_wavfile_sink::finish_drained(names);
+	CPPUNIT_ASSERT(closed(names, name));
+
+	// nothing goes into a finished file
+	feed(sink, 1500, 500);
+	long samples;
+	CPPUNIT_ASSERT_EQUAL(0l, check_file(name, samples));
+	CPPUNIT_ASSERT_EQUAL(1500l, samples);
+}
+
+void qa_wavfile_sink::t_drain_max()
+{
+	std::string name = temp_dir() + "/1.wav";
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(name.c_str(), 1, RATE, 16);
+	std::vector<std::string> names;
+
+	feed(sink, 0, 100);
+	sink->close();
+	// samples that never stop do not keep the file open
+	long fed = 100;
+	int64_t step = gr::blocks::nonstop_wavfile_sink::DRAIN_IDLE_MS / 5;
+	for (int64_t t = 0; t < gr::blocks::nonstop_wavfile_sink::DRAIN_MAX_MS + 100; t += step) {
+		usleep(step * 1000);
+		feed(sink, fed, 100);
+		fed += 100;
+	}
+	gr::blocks::nonstop_wavfile_sink::finish_drained(names);
+	CPPUNIT_ASSERT(closed(names, name));
+
+	long samples;
+	CPPUNIT_ASSERT_EQUAL(0l, check_file(name, samples));
+	CPPUNIT_ASSERT(samples > 100 && samples < fed);
+}
+
+void qa_wavfile_sink::t_stop()
+{
+	std::string name = temp_dir() + "/1.wav";
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(name.c_str(), 1, RATE, 16);
+	std::vector<std::string> names;
+
+	feed(sink, 0, 800);
+	sink->close();
+	sink->stop();
+	gr::blocks::nonstop_wavfile_sink::finish_drained(names);
+	CPPUNIT_ASSERT(closed(names, name));
+
+	long samples;
+	CPPUNIT_ASSERT_EQUAL(0l, check_file(name, samples));
+	CPPUNIT_ASSERT_EQUAL(800l, samples);
+}
+
+void qa_wavfile_sink::t_replace()
+{
+	std::string name = temp_dir() + "/1.wav";
+	FILE *fp = fopen(name.c_str(), "wb");
+	CPPUNIT_ASSERT(fp != NULL);
+	std::vector<char> junk(100000, 'x');
+	fwrite(&junk[0], 1, junk.size(), fp);
+	fclose(fp);
+
+	// a file of the same name is replaced, not added to
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(name.c_str(), 1, RATE, 16);
+	feed(sink, 0, 10);
+	sink.reset();
+
+	long samples;
+	CPPUNIT_ASSERT_EQUAL(0l, check_file(name, samples));
+	CPPUNIT_ASSERT_EQUAL(10l, samples);
+}
+
+void qa_wavfile_sink::t_no_file()
+{
+	// a recorder's sink is made before it has a call, samples until
+	// the first open() are dropped
+	gr::blocks::nonstop_wavfile_sink::sptr sink = gr::blocks::nonstop_wavfile_sink::make(NULL, 1, RATE, 16);
+	feed(sink, 0, 1000);
+	CPPUNIT_ASSERT_EQUAL(0.0f, sink->length_in_seconds());
+	sink->close();
+
+	std::string name = temp_dir() + "/1.wav";
+	CPPUNIT_ASSERT(sink->open(name.c_str()));
+	feed(sink, 1000, 2 * RATE);
+	CPPUNIT_ASSERT_EQUAL(2.0f, sink->length_in_seconds());
+	sink.reset();
+
+	long samples;
+	CPPUNIT_ASSERT_EQUAL(1000l, check_file(name, samples));
+	CPPUNIT_ASSERT_EQUAL(2l * RATE, samples);
+}
@@ -0,0 +1,32 @@
+#ifndef QA_WAVFILE_SINK_H
+#define QA_WAVFILE_SINK_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestCase.h>
+
+/*!
+ * nonstop_wavfile_sink moving from one call's file to the next: the
+ * audio still on its way when a call is closed goes to that call's
+ * file, up to the next call's epoch tag or until it stops coming.
+ */
+class qa_wavfile_sink : public CppUnit::TestCase
+{
+	CPPUNIT_TEST_SUITE(qa_wavfile_sink);
+	CPPUNIT_TEST(t_epoch_switch);
+	CPPUNIT_TEST(t_drain_idle);
+	CPPUNIT_TEST(t_drain_max);
+	CPPUNIT_TEST(t_stop);
+	CPPUNIT_TEST(t_replace);
+	CPPUNIT_TEST(t_no_file);
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	void t_epoch_switch();
+	void t_drain_idle();
+	void t_drain_max();
+	void t_stop();
+	void t_replace();
+	void t_no_file();
+};
+
+#endif
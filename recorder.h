@@ -50,6 +50,8 @@
 
 class Call;
 #include "call.h"
+#include "decode_quality.h"
+#include "silence_gate.h"
 
 class Source;
 
@@ -57,13 +59,34 @@ class Recorder
 {
 
 public:
+	virtual ~Recorder() {};
 	virtual void tune_offset(double f) {};
 	virtual void activate( Call *call, int n) {};
 	virtual void deactivate() {} ;
+	// deactivate() and drop the file of a call that had nothing in it
+	virtual void abort() { deactivate(); };
 	virtual double get_freq() {return 0;};
     virtual Source *get_source() {return NULL;};
 	virtual long get_talkgroup() {return 0;};
 	virtual bool is_active() {return false;};
+	// milliseconds since the transmission ended, -1 while it is still going
+	virtual int64_t since_end_of_voice() {return -1;};
+	// milliseconds since activate() with no voice heard yet, -1 once
+	// there has been some or if the recorder cannot tell
+	virtual int64_t waiting_for_voice() {return -1;};
+	// monotonic_ms() of the first / last voice frame, 0 if unknown
+	virtual int64_t get_first_voice_time() {return 0;};
+	virtual int64_t get_last_voice_time() {return 0;};
+	// error counts of the current call, false if the recorder has none
+	virtual bool get_decode_quality(DecodeQuality &quality) {return false;};
+	// error counts since startup, the current call's included
+	virtual bool get_decode_totals(DecodeTotals &totals) {return false;};
+	// silence taken out of the current call's file, false if it is not gated
+	virtual bool get_silence_gaps(std::vector<silence_gap> &gaps) {return false;};
+	// milliseconds spent recording calls since startup
+	virtual int64_t get_active_ms() {return 0;};
+	// audio samples lost since startup because the sink fell behind
+	virtual uint64_t get_audio_drops() {return 0;};
 	/*
 	private:
 		double center, freq;
@@ -0,0 +1,49 @@
+#include "replay_recorder.h"
+
+replay_recorder::replay_recorder(Source *src) {
+	source = src;
+	freq = 0;
+	talkgroup = 0;
+	active = false;
+	activate_time = 0;
+	active_ms = 0;
+}
+
+void replay_recorder::tune_offset(double f) {
+	freq = f;
+}
+
+void replay_recorder::activate(Call *call, int n) {
+	freq = call->get_freq();
+	talkgroup = call->get_talkgroup();
+	activate_time = call_time_ms();
+	active = true;
+}
+
+void replay_recorder::deactivate() {
+	active = false;
+	active_ms += call_time_ms() - activate_time;
+}
+
+double replay_recorder::get_freq() {
+	return freq;
+}
+
+Source *replay_recorder::get_source() {
+	return source;
+}
+
+long replay_recorder::get_talkgroup() {
+	return talkgroup;
+}
+
+bool replay_recorder::is_active() {
+	return active;
+}
+
+int64_t replay_recorder::get_active_ms() {
+	if (active) {
+		return active_ms + call_time_ms() - activate_time;
+	}
+	return active_ms;
+}
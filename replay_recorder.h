@@ -0,0 +1,40 @@
+#ifndef REPLAY_RECORDER_H
+#define REPLAY_RECORDER_H
+
+#include "recorder.h"
+
+class Source;
+
+/*
+ * Stands in for a p25_recorder or analog_recorder while a journal is
+ * replayed. It only keeps the state call management looks at, there
+ * are no blocks behind it.
+ *
+ * The journal has no voice channel, so a replayed recorder never sees
+ * the end of a transmission; its call ends when the control channel
+ * stops updating it (callTimeout) or grants its channel to another
+ * talkgroup.
+ */
+class replay_recorder : public Recorder
+{
+	Source *source;
+	double freq;
+	long talkgroup;
+	bool active;
+	int64_t activate_time;
+	int64_t active_ms;  // of the calls before the current one
+
+public:
+	replay_recorder(Source *src);
+
+	void tune_offset(double f);
+	void activate(Call *call, int n);
+	void deactivate();
+	double get_freq();
+	Source *get_source();
+	long get_talkgroup();
+	bool is_active();
+	int64_t get_active_ms();
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "silence_gate.h"
+#include "timestamp.h"
+#include <gnuradio/io_signature.h>
+#include <op25_repeater/epoch_tag.h>
+#include <math.h>
+#include <algorithm>
+
+// time constant of the envelope, so the quiet end of a word is not cut
+static const double ENVELOPE_MS = 10.0;
+// averaging time of the noise power, the noise is too spiky for a peak envelope
+static const double NOISE_MS = 20.0;
+// the noise has to fall this far below the threshold again, 3 dB, so
+// the gate does not chatter while the average crosses it
+static const double NOISE_HYSTERESIS = 0.5;
+
+bool silence_gate::s_enabled = false;
+float silence_gate::s_threshold_db = -40;
+int64_t silence_gate::s_keep_ms = 250;
+float silence_gate::s_noise_db = -10;
+
+silence_gate_sptr make_silence_gate(double rate, bool timed, bool noise)
+{
+	return silence_gate_sptr (new silence_gate (rate, timed, noise));
+}
+
+void silence_gate::configure(bool enabled, float threshold_db, int64_t keep_ms, float noise_db)
+{
+	s_enabled = enabled;
+	s_threshold_db = threshold_db;
+	s_keep_ms = keep_ms;
+	s_noise_db = noise_db;
+}
+
+silence_gate::silence_gate(double rate, bool timed, bool noise)
+	: gr::block ("silence_gate",
+	             gr::io_signature::make (noise ? 2 : 1, noise ? 2 : 1, sizeof (float)),
+	             gr::io_signature::make (1, 1, sizeof (float)))
+{
+	d_rate = rate;
+	d_timed = timed;
+	d_threshold = pow(10.0, s_threshold_db / 20.0);
+	d_decay = exp(-1000.0 / (ENVELOPE_MS * rate));
+	d_noise = noise;
+	d_noise_threshold = pow(10.0, s_noise_db / 10.0);
+	d_noise_decay = exp(-1000.0 / (NOISE_MS * rate));
+	d_keep = (uint64_t) (s_keep_ms * rate / 1000);
+	d_epoch = -1;
+	start_epoch(-1);
+	// items are dropped, the epoch tags are put back by hand
+	set_tag_propagation_policy(TPP_DONT);
+}
+
+silence_gate::~silence_gate()
+{
+}
+
+void silence_gate::start_epoch(long epoch)
+{
+	d_epoch = epoch;
+	d_gaps.clear();
+	d_env = 0;
+	// a call starts on a grant, so with a carrier
+	d_noise_power = 0;
+	d_carrier = true;
+	d_quiet = 0;
+	d_dropped = 0;
+	d_written = 0;
+	d_audio_end = 0;
+}
+
+// a quiet run is over, keep what was dropped of it as a gap
+void silence_gate::end_run()
+{
+	if (d_dropped) {
+		silence_gap gap;
+		gap.offset = d_written;
+		gap.removed = d_dropped;
+		d_gaps.push_back(gap);
+	}
+	d_quiet = 0;
+	d_dropped = 0;
+}
+
+int silence_gate::gate(const float *in, const float *noise, float *out, int n)
+{
+	int produced = 0;
+
+	if (d_timed && n) {
+		double now = monotonic_ms();
+		if (d_audio_end && (now > d_audio_end + s_keep_ms)) {
+			end_run();
+			silence_gap gap;
+			gap.offset = d_written;
+			gap.removed = (uint64_t) ((now - d_audio_end) * d_rate / 1000);
+			d_gaps.push_back(gap);
+		}
+		// audio that comes in faster than real time, as it does
+		// while the pre-roll catches up, just queues up
+		d_audio_end = std::max(d_audio_end, now) + n * 1000.0 / d_rate;
+	}
+
+	for (int i = 0; i < n; i++) {
+		float level = fabsf(in[i]);
+		d_env = (level > d_env) ? level : d_env * d_decay;
+		if (noise) {
+			d_noise_power = d_noise_power * d_noise_decay + noise[i] * noise[i] * (1 - d_noise_decay);
+			if (d_noise_power >= d_noise_threshold)
+				d_carrier = false;
+			else if (d_noise_power < d_noise_threshold * NOISE_HYSTERESIS)
+				d_carrier = true;
+		}
+		if (d_carrier && (d_env >= d_threshold)) {
+			end_run();
+			out[produced++] = in[i];
+		} else if (++d_quiet <= d_keep) {
+			// the noise of an empty channel is not worth keeping
+			out[produced++] = d_carrier ? in[i] : 0;
+		} else {
+			d_dropped++;
+			continue;
+		}
+		// kept up to date sample by sample, a run ending further on
+		// in this call is recorded where it was
+		d_written++;
+	}
+	return produced;
+}
+
+bool silence_gate::get_gaps(long epoch, std::vector<silence_gap> &gaps)
+{
+	gr::thread::scoped_lock guard(d_mutex);
+	if (epoch != d_epoch)
+		return false;
+	gaps = d_gaps;
+	if (d_dropped) {
+		silence_gap gap;
+		gap.offset = d_written;
+		gap.removed = d_dropped;
+		gaps.push_back(gap);
+	}
+	return true;
+}
+
+int
+silence_gate::general_work (int noutput_items,
+                            gr_vector_int &ninput_items,
+                            gr_vector_const_void_star &input_items,
+                            gr_vector_void_star &output_items)
+{
+	const float *in = (const float *) input_items[0];
+	const float *noise = d_noise ? (const float *) input_items[1] : NULL;
+	float *out = (float *) output_items[0];
+	// never more out than in
+	int ninput = std::min(ninput_items[0], noutput_items);
+	if (d_noise)
+		ninput = std::min(ninput, ninput_items[1]);
+	std::vector<gr::tag_t> tags;
+	gr::thread::scoped_lock guard(d_mutex);
+
+	get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + ninput, gr::op25_repeater::epoch_tag_key());
+
+	// the samples up to each tag go with the epoch before it
+	int start = 0;
+	int produced = 0;
+	for (size_t t = 0; t <= tags.size(); t++) {
+		int end = ninput;
+		if (t < tags.size())
+			end = std::max(start, (int) (tags[t].offset - nitems_read(0)));
+		produced += gate(in + start, noise ? noise + start : NULL, out + produced, end - start);
+		start = end;
+		if (t < tags.size()) {
+			start_epoch(pmt::to_long(tags[t].value));
+			add_item_tag(0, nitems_written(0) + produced, tags[t].key, tags[t].value);
+		}
+	}
+
+	consume_each(ninput);
+	return produced;
+}
@@ -0,0 +1,106 @@
+#ifndef SILENCE_GATE_H
+#define SILENCE_GATE_H
+
+#include <stdint.h>
+#include <vector>
+#include <gnuradio/block.h>
+#include <gnuradio/thread/thread.h>
+
+class silence_gate;
+
+typedef boost::shared_ptr<silence_gate> silence_gate_sptr;
+
+silence_gate_sptr make_silence_gate(double rate, bool timed, bool noise);
+
+// audio left out of a recording
+struct silence_gap {
+	uint64_t offset;    // samples into the file where it was
+	uint64_t removed;   // samples it was long
+};
+
+/*!
+ * \brief Takes the silence out of a recorder's audio before the sink.
+ *
+ * A quiet run, the envelope below the threshold, is passed until it
+ * has lasted keep_ms, which stays in the file to mark the gap, and
+ * the rest of it is dropped. Pauses in speech shorter than that are
+ * left alone.
+ *
+ * With timed set the input is also checked against the clock. The P25
+ * frame assembler only puts out audio for the voice frames it decodes,
+ * so when the audio arrives more than keep_ms after the audio before
+ * it should have ended, the time in between is a gap as well. A stream
+ * that is never held up, like analog audio, does not need it.
+ *
+ * With noise set there is a second input, the demodulated audio above
+ * the voice band, like an FM receiver's noise squelch. The discriminator
+ * puts out loud noise when nobody is keyed up, which the level of the
+ * audio alone cannot tell from speech, but a carrier quiets it. While
+ * that noise is above the noise threshold the channel is quiet however
+ * loud the audio, and what is kept of the run is written as silence.
+ *
+ * Every gap is kept with its place in the file, so playback can put
+ * the time back. Gaps start over at each epoch_tag_key() tag, the
+ * start of a new call's file, and the tag is passed on to the item
+ * where it belongs in the shortened output.
+ */
+class silence_gate : public gr::block
+{
+	friend silence_gate_sptr make_silence_gate(double rate, bool timed, bool noise);
+
+	silence_gate(double rate, bool timed, bool noise);
+
+	gr::thread::mutex d_mutex;
+	double d_rate;
+	bool d_timed;
+	float d_threshold;       // linear, full scale is 1
+	float d_decay;           // of the envelope, per sample
+	bool d_noise;
+	float d_noise_threshold; // of the noise power, linear
+	float d_noise_decay;     // of the noise power average, per sample
+	float d_noise_power;
+	bool d_carrier;          // the noise is below the threshold, or there is no noise input
+	uint64_t d_keep;         // samples of a quiet run that are kept
+	float d_env;
+	uint64_t d_quiet;        // samples in the current quiet run
+	uint64_t d_dropped;      // of them, dropped
+	uint64_t d_written;      // samples output in this epoch
+	double d_audio_end;      // monotonic_ms() the audio so far would end playing, 0 before any
+	long d_epoch;
+	std::vector<silence_gap> d_gaps;
+
+	static bool s_enabled;
+	static float s_threshold_db;
+	static int64_t s_keep_ms;
+	static float s_noise_db;
+
+	void end_run();
+	void start_epoch(long epoch);
+	int gate(const float *in, const float *noise, float *out, int n);
+
+public:
+	~silence_gate();
+
+	/*!
+	 * Turns gating on for the recorders built after this, with a
+	 * threshold in dB of full scale, how much of each quiet run is
+	 * kept, and the level in dB of full scale of the noise input
+	 * above which nobody is transmitting.
+	 */
+	static void configure(bool enabled, float threshold_db, int64_t keep_ms, float noise_db);
+	static bool enabled() { return s_enabled; }
+
+	/*!
+	 * The gaps in the file of activation epoch, including a quiet run
+	 * that is still being dropped. False if that epoch's audio has
+	 * not reached the gate.
+	 */
+	bool get_gaps(long epoch, std::vector<silence_gap> &gaps);
+
+	int general_work(int noutput_items,
+	                 gr_vector_int &ninput_items,
+	                 gr_vector_const_void_star &input_items,
+	                 gr_vector_void_star &output_items);
+};
+
+#endif /* SILENCE_GATE_H */
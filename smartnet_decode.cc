@@ -0,0 +1,131 @@
+#include "smartnet_decode.h"
+#include <gnuradio/io_signature.h>
+#include <stdint.h>
+
+// preamble 10101100 marks the start of every OSW
+static const unsigned int SMARTNET_SYNC = 0xAC;
+
+smartnet_decode_sptr smartnet_make_decode(gr::op25_repeater::trunk_msg_queue::sptr queue)
+{
+	return smartnet_decode_sptr (new smartnet_decode (queue));
+}
+
+smartnet_decode::smartnet_decode(gr::op25_repeater::trunk_msg_queue::sptr queue)
+	: gr::sync_block ("smartnet_decode",
+	                  gr::io_signature::make (1, 1, sizeof (char)),
+	                  gr::io_signature::make (0, 0, 0))
+{
+	d_queue = queue;
+	d_sync_reg = 0;
+	d_frames = 0;
+	d_crc_errors = 0;
+	// keep the FRAME_BITS bits after the last sync bit of the buffer
+	set_history(FRAME_BITS + 1);
+}
+
+smartnet_decode::~smartnet_decode()
+{
+}
+
+/*
+ * The CRC is a 10 bit LFSR whose state sequence does not depend on the
+ * data, so the check value is 0x393 xor the register state for every
+ * set data bit. The states are folded into three 9 bit chunk tables so
+ * the 27 data bits take three lookups.
+ */
+struct smartnet_crc_table {
+	unsigned short chunk[3][512];
+
+	smartnet_crc_table() {
+		unsigned int ops[27];
+		unsigned int crcop = 0x036E;
+		for (int j = 0; j < 27; j++) {
+			if (crcop & 0x01) crcop = (crcop >> 1) ^ 0x0225;
+			else crcop >>= 1;
+			ops[j] = crcop;
+		}
+		for (int c = 0; c < 3; c++) {
+			for (int v = 0; v < 512; v++) {
+				unsigned int accum = 0;
+				for (int b = 0; b < 9; b++) {
+					if (v & (0x100 >> b)) accum ^= ops[c * 9 + b];
+				}
+				chunk[c][v] = accum;
+			}
+		}
+	}
+};
+
+static const smartnet_crc_table crc_table;
+
+bool smartnet_decode::decode_osw(const char *in, smartnet_packet &pkt, unsigned int &errors)
+{
+	uint64_t info = 0;
+	uint64_t parity = 0;
+
+	// deinterleave: 19 columns of 4 bits; after deinterleaving even
+	// bits are data and odd bits are parity. Data / parity bit k is
+	// packed MSB first at bit 63 - k so the fields come out in order.
+	for (int k = 0; k < 19; k++) {
+		const char *col = &in[k];
+		int n = 63 - 2 * k;
+		info |= (uint64_t) (col[0] & 0x01) << n;
+		parity |= (uint64_t) (col[19] & 0x01) << n;
+		info |= (uint64_t) (col[38] & 0x01) << (n - 1);
+		parity |= (uint64_t) (col[57] & 0x01) << (n - 1);
+	}
+
+	// convolutional ECC: parity bit k is data k xor data k-1. Two
+	// failing parity checks in a row point at the shared data bit.
+	uint64_t syndrome = parity ^ info ^ (info >> 1);
+	uint64_t flip = syndrome & (syndrome << 1) & ~((1ULL << 27) - 1);
+	info ^= flip;
+
+	unsigned int crcaccum = 0x0393
+		^ crc_table.chunk[0][(info >> 55) & 0x1ff]
+		^ crc_table.chunk[1][(info >> 46) & 0x1ff]
+		^ crc_table.chunk[2][(info >> 37) & 0x1ff];
+
+	// the data bits are sent inverted
+	uint64_t data = ~info;
+	unsigned int crcgiven = (data >> 27) & 0x3ff;
+	if (crcgiven != crcaccum)
+		return false;
+
+	//now correct things according to the mottrunk.txt description
+	pkt.address = ((data >> 48) & 0xffff) ^ 0x33C7;
+	pkt.groupflag = (data >> 47) & 0x01;
+	pkt.command = ((data >> 37) & 0x3ff) ^ 0x032A;
+	pkt.crc = crcgiven;
+	errors = __builtin_popcountll(flip);
+	return true;
+}
+
+int
+smartnet_decode::work (int noutput_items,
+                       gr_vector_const_void_star &input_items,
+                       gr_vector_void_star &output_items)
+{
+	// each bit is shifted into the sync register once; history
+	// guarantees the FRAME_BITS bits after it are in the buffer
+	const char *in = (const char *) input_items[0];
+
+	for (int i = 0; i < noutput_items; i++) {
+		d_sync_reg = ((d_sync_reg << 1) | (in[i] & 0x01)) & 0xff;
+		if (d_sync_reg != SMARTNET_SYNC)
+			continue;
+
+		d_frames++;
+		smartnet_packet pkt;
+		unsigned int errors;
+		if (!decode_osw(&in[i + 1], pkt, errors)) {
+			d_crc_errors++;
+			continue;
+		}
+
+		gr::op25_repeater::trunk_msg msg;
+		msg.set(0, 0, errors, &pkt, sizeof(pkt));
+		d_queue->insert_tail(msg);
+	}
+	return noutput_items;
+}
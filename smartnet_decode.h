@@ -0,0 +1,55 @@
+#ifndef SMARTNET_DECODE_H
+#define SMARTNET_DECODE_H
+
+#include <gnuradio/sync_block.h>
+#include <op25_repeater/trunk_msg_queue.h>
+#include "smartnet_types.h"
+
+class smartnet_decode;
+
+typedef boost::shared_ptr<smartnet_decode> smartnet_decode_sptr;
+
+smartnet_decode_sptr smartnet_make_decode(gr::op25_repeater::trunk_msg_queue::sptr queue);
+
+/*!
+ * \brief SmartNet outbound signalling word (OSW) decoder.
+ *
+ * Takes the sliced bit stream (one bit per char) and does sync
+ * correlation, deinterleave, ECC, CRC and field extraction in a
+ * single pass, without stream tags. Every OSW that passes CRC is put
+ * on the queue as a trunk_msg whose payload is a smartnet_packet.
+ */
+class smartnet_decode : public gr::sync_block
+{
+	friend smartnet_decode_sptr smartnet_make_decode(gr::op25_repeater::trunk_msg_queue::sptr queue);
+
+	smartnet_decode(gr::op25_repeater::trunk_msg_queue::sptr queue);
+	gr::op25_repeater::trunk_msg_queue::sptr d_queue;
+
+	// last 8 bits shifted in, compared against the sync word
+	unsigned int d_sync_reg;
+	unsigned long d_frames;
+	unsigned long d_crc_errors;
+
+public:
+	static const int FRAME_BITS = 84;
+
+	~smartnet_decode();
+
+	/*!
+	 * Decode the FRAME_BITS bits following a sync word.
+	 *
+	 * \return true and fill in pkt and the number of bits the ECC
+	 * corrected if the OSW passed CRC.
+	 */
+	static bool decode_osw(const char *frame, smartnet_packet &pkt, unsigned int &errors);
+
+	unsigned long frames() const { return d_frames; }
+	unsigned long crc_errors() const { return d_crc_errors; }
+
+	int work (int noutput_items,
+	          gr_vector_const_void_star &input_items,
+	          gr_vector_void_star &output_items);
+};
+
+#endif /* SMARTNET_DECODE_H */
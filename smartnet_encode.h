@@ -0,0 +1,61 @@
+#ifndef SMARTNET_ENCODE_H
+#define SMARTNET_ENCODE_H
+
+#include <vector>
+#include "smartnet_decode.h"
+
+/*
+ * The transmit side of smartnet_decode, for the tests and benchmarks:
+ * fields scrambled and inverted, CRC, rate 1/2 convolutional code and
+ * the 19 x 4 interleave, one bit per char.
+ */
+
+static const char SMARTNET_SYNC_BITS[8] = { 1, 0, 1, 0, 1, 1, 0, 0 };
+
+// the FRAME_BITS bits that follow the sync word; the 8 bits after the
+// interleaved block are not used by the decoder and are left 0
+static inline void smartnet_encode_osw(unsigned int address, bool groupflag, unsigned int command, char frame[smartnet_decode::FRAME_BITS])
+{
+	char data[27];
+	char info[38];
+	char coded[76];
+	unsigned int a = (address & 0xffff) ^ 0x33C7;
+	unsigned int c = (command & 0x3ff) ^ 0x032A;
+
+	for (int k = 0; k < 16; k++) data[k] = (a >> (15 - k)) & 1;
+	data[16] = groupflag;
+	for (int k = 0; k < 10; k++) data[17 + k] = (c >> (9 - k)) & 1;
+
+	// the data bits are sent inverted and the CRC runs over them as sent
+	for (int k = 0; k < 27; k++) info[k] = !data[k];
+	unsigned int crcaccum = 0x0393;
+	unsigned int crcop = 0x036E;
+	for (int j = 0; j < 27; j++) {
+		if (crcop & 0x01) crcop = (crcop >> 1) ^ 0x0225;
+		else crcop >>= 1;
+		if (info[j]) crcaccum ^= crcop;
+	}
+	for (int j = 0; j < 10; j++) info[27 + j] = !((crcaccum >> (9 - j)) & 1);
+	info[37] = 0;
+
+	for (int k = 0; k < 38; k++) {
+		coded[2 * k] = info[k];
+		coded[2 * k + 1] = info[k] ^ (k ? info[k - 1] : 0);
+	}
+	for (int k = 0; k < 19; k++)
+		for (int l = 0; l < 4; l++)
+			frame[k + l * 19] = coded[k * 4 + l];
+	for (int i = 76; i < smartnet_decode::FRAME_BITS; i++)
+		frame[i] = 0;
+}
+
+// sync word and OSW appended to a bit stream
+static inline void smartnet_append_osw(std::vector<char> &bits, unsigned int address, bool groupflag, unsigned int command)
+{
+	char frame[smartnet_decode::FRAME_BITS];
+	smartnet_encode_osw(address, groupflag, command, frame);
+	bits.insert(bits.end(), SMARTNET_SYNC_BITS, SMARTNET_SYNC_BITS + 8);
+	bits.insert(bits.end(), frame, frame + smartnet_decode::FRAME_BITS);
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "smartnet_parser.h"
+#include <string.h>
 
 using namespace std;
 SmartnetParser::SmartnetParser() {
@@ -20,23 +21,24 @@ double SmartnetParser::getfreq(int cmd) {
 
 
 
-std::vector<TrunkMessage> SmartnetParser::parse_message(std::string s) {
+std::vector<TrunkMessage> SmartnetParser::parse_message(const trunk_msg &msg) {
 	std::vector<TrunkMessage> messages;
 	TrunkMessage message;
 
 
 	message.message_type = UNKNOWN;
 
+	if (msg.len != sizeof(smartnet_packet)) {
+		messages.push_back(message);
+		return messages;
+	}
 
-	std::vector<std::string> x;
-	boost::split(x, s, boost::is_any_of(","), boost::token_compress_on);
-
-	long address = atoi( x[0].c_str() ) & 0xFFF0;
-	//int groupflag = atoi( x[1].c_str() );
-	int command = atoi( x[2].c_str() );
+	smartnet_packet pkt;
+	memcpy(&pkt, msg.data, sizeof(pkt));
 
-	x.clear();
-	vector<string>().swap(x);
+	long address = pkt.address & 0xFFF0;
+	//int groupflag = pkt.groupflag;
+	int command = pkt.command;
 
 	if (command < 0x2d0) {
 		if (  (address != 56016) && (address != 8176)) {  // remove this later to make it more general
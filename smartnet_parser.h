@@ -4,9 +4,7 @@
 #include <iostream>
 #include <vector>
 
-#include <boost/algorithm/string/split.hpp>
-#include <boost/algorithm/string/classification.hpp>
-#include <boost/tokenizer.hpp>
+#include "smartnet_types.h"
 
 
 class SmartnetParser:public TrunkParser
@@ -16,6 +14,6 @@ class SmartnetParser:public TrunkParser
 public:
 	SmartnetParser();
 	double getfreq(int cmd);
-	std::vector<TrunkMessage> parse_message(std::string s);
+	std::vector<TrunkMessage> parse_message(const trunk_msg &msg);
 };
 #endif
\ No newline at end of file
@@ -2,12 +2,12 @@
 
 using namespace std;
 
-smartnet_trunking_sptr make_smartnet_trunking(float freq, float center, long samp, gr::msg_queue::sptr queue)
+smartnet_trunking_sptr make_smartnet_trunking(float freq, float center, long samp, gr::op25_repeater::trunk_msg_queue::sptr queue)
 {
 	return gnuradio::get_initial_sptr(new smartnet_trunking(freq, center, samp, queue));
 }
 
-smartnet_trunking::smartnet_trunking(float f, float c, long s, gr::msg_queue::sptr queue)
+smartnet_trunking::smartnet_trunking(float f, float c, long s, gr::op25_repeater::trunk_msg_queue::sptr queue)
 	: gr::hier_block2 ("smartnet_trunking",
 	                   gr::io_signature::make  (1, 1, sizeof(gr_complex)),
 	                   gr::io_signature::make  (0, 0, sizeof(float)))
@@ -49,18 +49,12 @@ smartnet_trunking::smartnet_trunking(float f, float c, long s, gr::msg_queue::sp
 
 	gr::digital::binary_slicer_fb::sptr slicer =  gr::digital::binary_slicer_fb::make();
 
-	gr::digital::correlate_access_code_tag_bb::sptr start_correlator = gr::digital::correlate_access_code_tag_bb::make("10101100",0,"smartnet_preamble");
-
-	smartnet_deinterleave_sptr deinterleave = smartnet_make_deinterleave();
-
-	smartnet_crc_sptr crc = smartnet_make_crc(queue);
+	smartnet_decode_sptr decode = smartnet_make_decode(queue);
 
 	connect(self(),0,prefilter,0);
 	connect(prefilter,0,carriertrack,0);
 	connect(carriertrack, 0, pll_demod, 0);
 	connect(pll_demod, 0, softbits, 0);
 	connect(softbits, 0, slicer, 0);
-	connect(slicer, 0, start_correlator, 0);
-	connect(start_correlator, 0, deinterleave, 0);
-	connect(deinterleave, 0, crc, 0);
+	connect(slicer, 0, decode, 0);
 }
\ No newline at end of file
@@ -1,4 +1,6 @@
 //datatypes for smartnet decoder
+#ifndef SMARTNET_TYPES_H
+#define SMARTNET_TYPES_H
 
 struct smartnet_packet {
 	unsigned int address;
@@ -6,3 +8,5 @@ struct smartnet_packet {
 	unsigned int command;
 	unsigned int crc;
 };
+
+#endif
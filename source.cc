@@ -1,4 +1,9 @@
 #include "source.h"
+#include "replay_recorder.h"
+#include "timestamp.h"
+
+// offsets smaller than this are left to the demodulators' own loops
+static const double AFC_DEADBAND = 100;
 
 
 
@@ -37,6 +42,31 @@ void Source::set_error(double e) {
 double Source::get_error() {
 	return error;
 }
+void Source::set_afc(bool a) {
+	afc = a;
+}
+bool Source::get_afc() {
+	return afc;
+}
+// A decoder measured its signal offset Hz above where it was expected,
+// over the time from monotonic_ms() since until now. All signals from
+// the Source are off by the same amount, so the correction is made at
+// the SDR. Measurements that started before the last correction are
+// out of date and ignored.
+void Source::afc_update(double offset, int64_t since) {
+	if (!afc || since < afc_time || fabs(offset) < AFC_DEADBAND) {
+		return;
+	}
+	error += offset;
+	afc_time = monotonic_ms();
+	if (driver == "osmosdr") {
+		cast_to_osmo_sptr(source_block)->set_center_freq(center + error,0);
+	}
+	if (driver == "usrp") {
+		cast_to_usrp_sptr(source_block)->set_center_freq(center + error,0);
+	}
+	BOOST_LOG_TRIVIAL(info) << "Source [ " << driver << " ] Center: " << center << "\tFrequency Correction: " << error << "Hz (" << error / center * 1000000 << " ppm)";
+}
 void Source::set_bb_gain(int b)
 {
 	if (driver == "osmosdr") {
@@ -79,37 +109,119 @@ void Source::set_freq_corr(double p)
 int Source::get_if_gain() {
 	return if_gain;
 }
+// Restricts the driver block, and the recorders and pre-roll created
+// after this, to the given CPU cores. Must be called before the flow
+// graph is started, GNU Radio applies the affinity when it starts the
+// block threads.
+void Source::set_cores(std::vector<int> c) {
+	cores = c;
+	next_core = 0;
+	if (!cores.empty()) {
+		source_block->set_processor_affinity(cores);
+	}
+}
+std::vector<int> Source::get_cores() {
+	return cores;
+}
+// Each recorder gets a single core, round robin over the source's set,
+// so the blocks of one recorder hand their buffers over in the same
+// cache.
+void Source::pin_recorder(gr::basic_block_sptr recorder) {
+	if (cores.empty()) {
+		return;
+	}
+	recorder->set_processor_affinity(std::vector<int>(1, cores[next_core % cores.size()]));
+	next_core++;
+}
+void Source::create_preroll(gr::top_block_sptr tb, int64_t ms, float catchup) {
+	preroll_time = ms;
+	preroll_catchup = catchup;
+	preroll = make_preroll_ring(rate, ms);
+	tb->connect(source_block, 0, preroll, 0);
+	if (!cores.empty()) {
+		preroll->set_processor_affinity(cores);
+	}
+	BOOST_LOG_TRIVIAL(info) << "[ " << driver << " ] Pre-roll: " << ms << "ms, catch up at " << catchup << "x, ring uses " << preroll->bytes() / (1024 * 1024.0) << " MB";
+}
+preroll_ring_sptr Source::get_preroll() {
+	return preroll;
+}
+int64_t Source::get_preroll_time() {
+	return preroll_time;
+}
+float Source::get_preroll_catchup() {
+	return preroll_catchup;
+}
+void Source::set_lazy_recorders(bool l) {
+	lazy = l;
+}
+bool Source::get_lazy_recorders() {
+	return lazy;
+}
+analog_recorder_sptr Source::add_analog_recorder() {
+	analog_recorder_sptr log = make_analog_recorder( this);
+	analog_recorders.push_back(log);
+	analog_pool.push_back((Recorder *) log.get());
+	top_block->connect(source_block, 0, log, 0);
+	pin_recorder(log);
+	return log;
+}
 void Source::create_analog_recorders(gr::top_block_sptr tb, int r) {
 	max_analog_recorders = r;
+	top_block = tb;
 
+	if (lazy) {
+		return;
+	}
 	for (int i = 0; i < max_analog_recorders; i++) {
-		analog_recorder_sptr log = make_analog_recorder( this);
-		analog_recorders.push_back(log);
-		tb->connect(source_block, 0, log, 0);
+		add_analog_recorder();
 	}
 }
 Recorder * Source::get_analog_recorder(int priority)
 {
-	for(std::vector<analog_recorder_sptr>::iterator it = analog_recorders.begin(); it != analog_recorders.end(); it++) {
-		analog_recorder_sptr rx = *it;
+	// priority N needs N idle recorders, see get_digital_recorder()
+	if (priority > get_num_available_analog_recorders()) {
+		return NULL;
+	}
+
+	for(std::vector<Recorder *>::iterator it = analog_pool.begin(); it != analog_pool.end(); it++) {
+		Recorder *rx = *it;
 		if (!rx->is_active())
 		{
-			return (Recorder *) rx.get();
+			return rx;
 			break;
 		}
 	}
+	if ((int) analog_pool.size() < max_analog_recorders) {
+		// adding blocks to the running flow graph stops and restarts it
+		top_block->lock();
+		analog_recorder_sptr rx = add_analog_recorder();
+		top_block->unlock();
+		BOOST_LOG_TRIVIAL(info) << "[ " << driver << " ] Built Analog Recorder " << analog_recorders.size() << " of " << max_analog_recorders;
+		return (Recorder *) rx.get();
+	}
 	BOOST_LOG_TRIVIAL(info) << "[ " << driver << " ] No Analog Recorders Available";
 	return NULL;
 
 }
+p25_recorder_sptr Source::add_digital_recorder() {
+	p25_recorder_sptr log = make_p25_recorder( this, qpsk_mod);
+	digital_recorders.push_back(log);
+	digital_pool.push_back((Recorder *) log.get());
+	top_block->connect(source_block, 0, log, 0);
+	pin_recorder(log);
+	return log;
+}
 void Source::create_digital_recorders(gr::top_block_sptr tb, int r, bool qpsk) {
 	max_digital_recorders = r;
+	qpsk_mod = qpsk;
+	top_block = tb;
 
+	if (lazy) {
+		return;
+	}
 	for (int i = 0; i < max_digital_recorders; i++) {
-
-		p25_recorder_sptr log = make_p25_recorder( this, qpsk);
-		digital_recorders.push_back(log);
-		tb->connect(source_block, 0, log, 0);
+		add_digital_recorder();
 	}
 }
 void Source::create_debug_recorders(gr::top_block_sptr tb, int r) {
@@ -121,6 +233,30 @@ void Source::create_debug_recorders(gr::top_block_sptr tb, int r) {
 
 		debug_recorders.push_back(log);
 		tb->connect(source_block, 0, log, 0);
+		pin_recorder(log);
+	}
+}
+
+// Recorders without any DSP, for replaying a journal. The Source has
+// no SDR then, see the "replay" driver. Any made before are replaced,
+// so a simulation can start over with other counts.
+void Source::create_replay_recorders(int digital, int analog) {
+	for (std::vector<Recorder *>::iterator it = digital_pool.begin(); it != digital_pool.end(); it++) {
+		delete *it;
+	}
+	for (std::vector<Recorder *>::iterator it = analog_pool.begin(); it != analog_pool.end(); it++) {
+		delete *it;
+	}
+	digital_pool.clear();
+	analog_pool.clear();
+	max_digital_recorders = digital;
+	max_analog_recorders = analog;
+
+	for (int i = 0; i < digital; i++) {
+		digital_pool.push_back(new replay_recorder(this));
+	}
+	for (int i = 0; i < analog; i++) {
+		analog_pool.push_back(new replay_recorder(this));
 	}
 }
 
@@ -142,36 +278,82 @@ Recorder * Source::get_debug_recorder()
 int Source::get_num_available_recorders() {
 	int num_available_recorders = 0;
 
-	for(std::vector<p25_recorder_sptr>::iterator it = digital_recorders.begin(); it != digital_recorders.end(); it++) {
-		p25_recorder_sptr rx = *it;
+	for(std::vector<Recorder *>::iterator it = digital_pool.begin(); it != digital_pool.end(); it++) {
+		Recorder *rx = *it;
 		if (!rx->is_active())
 		{
 			num_available_recorders++;
 		}
 	}
-	return num_available_recorders;
+	// not built yet counts as idle
+	return num_available_recorders + max_digital_recorders - digital_pool.size();
+}
+
+int Source::get_num_available_analog_recorders() {
+	int num_available_recorders = 0;
+
+	for(std::vector<Recorder *>::iterator it = analog_pool.begin(); it != analog_pool.end(); it++) {
+		Recorder *rx = *it;
+		if (!rx->is_active())
+		{
+			num_available_recorders++;
+		}
+	}
+	// not built yet counts as idle
+	return num_available_recorders + max_analog_recorders - analog_pool.size();
+}
+
+// the recorders built so far
+std::vector<Recorder *> Source::get_recorders(bool analog) {
+	return analog ? analog_pool : digital_pool;
+}
+
+int Source::get_num_digital_recorders() {
+	return max_digital_recorders;
+}
+
+int Source::get_num_analog_recorders() {
+	return max_analog_recorders;
+}
+
+// fraction of the recorders of one kind that are busy, 1 if there are none
+double Source::get_load(bool analog) {
+	int total = analog ? get_num_analog_recorders() : get_num_digital_recorders();
+	int available = analog ? get_num_available_analog_recorders() : get_num_available_recorders();
+
+	if (total == 0) {
+		return 1;
+	}
+	return (double) (total - available) / total;
 }
 
 Recorder * Source::get_digital_recorder(int priority)
 {
-	//int num_available_recorders = get_num_available_recorders();
-	//BOOST_LOG_TRIVIAL(info) << "\tTG Priority: "<< priority << " Available Digital Recorders: " <<num_available_recorders;
-
- 	if (priority> 99) { //num_available_recorders) { // a low priority is bad. You need atleast the number of availalbe recorders to your priority
-		//BOOST_LOG_TRIVIAL(info) << "Not recording because of priority";
+	// a priority N call needs N idle recorders, so the last few are
+	// kept for the high priority talkgroups. 0 (emergencies) and 1
+	// take any idle recorder.
+	if (priority > get_num_available_recorders()) {
 		return NULL;
 	}
 
 
-	for(std::vector<p25_recorder_sptr>::iterator it = digital_recorders.begin(); it != digital_recorders.end(); it++) {
-		p25_recorder_sptr rx = *it;
+	for(std::vector<Recorder *>::iterator it = digital_pool.begin(); it != digital_pool.end(); it++) {
+		Recorder *rx = *it;
         
 		if (!rx->is_active())
 		{
-			return (Recorder *) rx.get();
+			return rx;
 			break;
 		}
 	}
+	if ((int) digital_pool.size() < max_digital_recorders) {
+		// adding blocks to the running flow graph stops and restarts it
+		top_block->lock();
+		p25_recorder_sptr rx = add_digital_recorder();
+		top_block->unlock();
+		BOOST_LOG_TRIVIAL(info) << "[ " << driver << " ] Built Digital Recorder " << digital_recorders.size() << " of " << max_digital_recorders;
+		return (Recorder *) rx.get();
+	}
 	BOOST_LOG_TRIVIAL(info) << "[ " << driver << " ] No Digital Recorders Available";
 	return NULL;
 
@@ -183,6 +365,16 @@ Source::Source(double c, double r, double e, std::string drv, std::string dev)
 {
 	rate = r;
 	center = c;
+	preroll_time = 0;
+	preroll_catchup = 4.0;
+	next_core = 0;
+	lazy = false;
+	qpsk_mod = true;
+	afc = false;
+	afc_time = 0;
+	max_digital_recorders = 0;
+	max_analog_recorders = 0;
+	max_debug_recorders = 0;
 	error = e;
 	min_hz = center - (rate/2);
 	max_hz = center + (rate/2);
@@ -224,4 +416,8 @@ Source::Source(double c, double r, double e, std::string drv, std::string dev)
 
 		source_block = usrp_src;
 	}
+	if (driver == "replay") {
+		// no source block, create_replay_recorders() gives it recorders
+		BOOST_LOG_TRIVIAL(info) << "SOURCE TYPE REPLAY";
+	}
 }
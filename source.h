@@ -6,6 +6,7 @@
 #include <osmosdr/source.h>
 #include <gnuradio/uhd/usrp_source.h>
 
+#include "preroll_ring.h"
 #include "recorder.h"
 #include "analog_recorder.h"
 #include "debug_recorder.h"
@@ -30,13 +31,37 @@ class Source
 	std::vector<p25_recorder_sptr> digital_recorders;
 	std::vector<debug_recorder_sptr> debug_recorders;
 	std::vector<analog_recorder_sptr> analog_recorders;
+	// every recorder built so far, the ones above or, when a journal
+	// is replayed, replay_recorders
+	std::vector<Recorder *> digital_pool;
+	std::vector<Recorder *> analog_pool;
 	std::string driver;
 	std::string device;
 	std::string antenna;
 	gr::basic_block_sptr source_block;
+	preroll_ring_sptr preroll;
+	int64_t preroll_time;
+	float preroll_catchup;
+	std::vector<int> cores;
+	size_t next_core;
+	void pin_recorder(gr::basic_block_sptr recorder);
+	// lazy sources build their recorders the first time they are needed
+	bool lazy;
+	bool qpsk_mod;
+	gr::top_block_sptr top_block;
+	// automatic frequency control, error is moved to where the
+	// decoders find the signals
+	bool afc;
+	int64_t afc_time;  // monotonic_ms() of the last correction
+	p25_recorder_sptr add_digital_recorder();
+	analog_recorder_sptr add_analog_recorder();
 
 public:
 	int get_num_available_recorders();
+	int get_num_available_analog_recorders();
+	int get_num_digital_recorders();
+	int get_num_analog_recorders();
+	double get_load(bool analog);
 	Source(double c, double r, double e, std::string driver, std::string device);
 	gr::basic_block_sptr get_src_block();
 	double get_min_hz();
@@ -49,6 +74,9 @@ public:
 	std::string get_antenna();
 	void set_error(double e);
 	double get_error();
+	void set_afc(bool a);
+	bool get_afc();
+	void afc_update(double offset, int64_t since);
 	void set_if_gain(int i);
 	int get_if_gain();
 	void set_gain(int r);
@@ -56,11 +84,21 @@ public:
 	void set_bb_gain(int b);
 	int get_bb_gain();
     void set_freq_corr(double p);
+	void set_cores(std::vector<int> c);
+	std::vector<int> get_cores();
+	void set_lazy_recorders(bool l);
+	bool get_lazy_recorders();
+	void create_preroll(gr::top_block_sptr tb, int64_t ms, float catchup);
+	preroll_ring_sptr get_preroll();
+	int64_t get_preroll_time();
+	float get_preroll_catchup();
 	void create_analog_recorders(gr::top_block_sptr tb, int r);
 	Recorder * get_analog_recorder(int priority);
 	void create_digital_recorders(gr::top_block_sptr tb, int r, bool qpsk);
 	Recorder * get_digital_recorder(int priority);
+	std::vector<Recorder *> get_recorders(bool analog);
 	void create_debug_recorders(gr::top_block_sptr tb, int r);
+	void create_replay_recorders(int digital, int analog);
 	Recorder * get_debug_recorder();
 	inline osmosdr::source::sptr cast_to_osmo_sptr(gr::basic_block_sptr p)
 	{
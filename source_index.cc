@@ -0,0 +1,94 @@
+#include "source_index.h"
+#include <algorithm>
+#include <boost/log/trivial.hpp>
+
+SourceIndex::SourceIndex() {
+}
+
+void SourceIndex::add_source(Source *source) {
+	sources.push_back(source);
+	rebuild();
+}
+
+void SourceIndex::rebuild() {
+	std::vector<double> edges;
+
+	segments.clear();
+	for(std::vector<Source *>::iterator it = sources.begin(); it != sources.end(); it++) {
+		edges.push_back((*it)->get_min_hz());
+		edges.push_back((*it)->get_max_hz());
+	}
+	std::sort(edges.begin(), edges.end());
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+	for(size_t i = 0; i < edges.size(); i++) {
+		std::vector<Source *> &covering = segments[edges[i]];
+		for(std::vector<Source *>::iterator it = sources.begin(); it != sources.end(); it++) {
+			// a segment starting at a source's max_hz only holds that
+			// one frequency, find_sources() checks it exactly
+			if (((*it)->get_min_hz() <= edges[i]) && ((*it)->get_max_hz() >= edges[i])) {
+				covering.push_back(*it);
+			}
+		}
+	}
+}
+
+std::vector<Source *> SourceIndex::find_sources(double freq) {
+	std::vector<Source *> found;
+	std::map<double, std::vector<Source *> >::iterator seg = segments.upper_bound(freq);
+
+	if (seg == segments.begin()) {
+		return found;
+	}
+	--seg;
+	for(std::vector<Source *>::iterator it = seg->second.begin(); it != seg->second.end(); it++) {
+		if (((*it)->get_min_hz() <= freq) && ((*it)->get_max_hz() >= freq)) {
+			found.push_back(*it);
+		}
+	}
+	return found;
+}
+
+struct LessLoaded {
+	bool analog;
+	LessLoaded(bool a) : analog(a) {}
+	bool operator()(Source *a, Source *b) const {
+		double load_a = a->get_load(analog);
+		double load_b = b->get_load(analog);
+		if (load_a != load_b) {
+			return load_a < load_b;
+		}
+		if (analog) {
+			return a->get_num_available_analog_recorders() > b->get_num_available_analog_recorders();
+		}
+		return a->get_num_available_recorders() > b->get_num_available_recorders();
+	}
+};
+
+std::vector<Source *> SourceIndex::find_sources_by_load(double freq, bool analog) {
+	std::vector<Source *> found = find_sources(freq);
+	// stable so equally loaded sources keep the config order
+	std::stable_sort(found.begin(), found.end(), LessLoaded(analog));
+	return found;
+}
+
+Source *SourceIndex::find_source(double freq) {
+	std::vector<Source *> found = find_sources(freq);
+	if (found.empty()) {
+		return NULL;
+	}
+	return found[0];
+}
+
+void SourceIndex::log_utilization() {
+	for(std::vector<Source *>::iterator it = sources.begin(); it != sources.end(); it++) {
+		Source *source = *it;
+		int digital = source->get_num_digital_recorders();
+		int analog = source->get_num_analog_recorders();
+
+		BOOST_LOG_TRIVIAL(info) << "\tSource [ " << source->get_driver() << " ] Center: " << source->get_center()
+			<< "\tDigital Recorders: " << digital - source->get_num_available_recorders() << "/" << digital
+			<< "\tAnalog Recorders: " << analog - source->get_num_available_analog_recorders() << "/" << analog
+			<< "\tFrequency Correction: " << source->get_error() << "Hz";
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef SOURCE_INDEX_H
+#define SOURCE_INDEX_H
+
+#include <map>
+#include <vector>
+#include "source.h"
+
+/*
+ * Frequency to Source lookup. The band is cut into segments at every
+ * source edge and each segment lists the sources that cover all of
+ * it, so a lookup is a single map search however many sources there
+ * are.
+ */
+class SourceIndex {
+	std::vector<Source *> sources;
+	// segment start -> sources covering [start, next start)
+	std::map<double, std::vector<Source *> > segments;
+	void rebuild();
+public:
+	SourceIndex();
+	void add_source(Source *source);
+
+	// every source whose range includes freq, in the order they were added
+	std::vector<Source *> find_sources(double freq);
+
+	// the covering sources ordered least loaded first, for the kind of
+	// recorder a call needs
+	std::vector<Source *> find_sources_by_load(double freq, bool analog);
+
+	Source *find_source(double freq);
+	void log_utilization();
+};
+#endif
@@ -0,0 +1,20 @@
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/XmlOutputter.h>
+
+#include <gnuradio/unittests.h>
+#include "qa_trunk_recorder.h"
+#include <fstream>
+
+int main(int argc, char **argv)
+{
+	CppUnit::TextTestRunner runner;
+	std::ofstream xmlfile(get_unittest_path("trunk_recorder.xml").c_str());
+	CppUnit::XmlOutputter *xmlout = new CppUnit::XmlOutputter(&runner.result(), xmlfile);
+
+	runner.addTest(qa_trunk_recorder::suite());
+	runner.setOutputter(xmlout);
+
+	bool was_successful = runner.run("", false);
+
+	return was_successful ? 0 : 1;
+}
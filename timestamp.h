@@ -0,0 +1,43 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+
+// Milliseconds on CLOCK_MONOTONIC. All call management intervals use
+// this so a wall clock step (NTP, manual change) cannot expire calls
+// early or keep them alive. It is the same clock as trunk_msg::rx_time.
+static inline int64_t monotonic_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Time of the control channel message being replayed, 0 when the
+// messages are live; see journal.h.
+extern int64_t replay_time_ms;
+
+// The clock of call management: monotonic_ms(), or the replayed
+// message's time while a journal is replayed.
+static inline int64_t call_time_ms() {
+	return replay_time_ms ? replay_time_ms : monotonic_ms();
+}
+
+// Microseconds on CLOCK_MONOTONIC, for timing short operations.
+static inline int64_t monotonic_us() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Convert a monotonic_ms() value to milliseconds since the Unix epoch,
+// for timestamps that are written out.
+static inline int64_t monotonic_to_epoch_ms(int64_t t) {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	int64_t now = (int64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+	return now - (monotonic_ms() - t);
+}
+
+#endif